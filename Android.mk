@@ -101,6 +101,7 @@ LOCAL_SRC_FILES := \
     device/src/UltrasoundDevice.cpp \
     session/src/Session.cpp \
     session/src/PayloadBuilder.cpp \
+    session/src/PayloadArena.cpp \
     session/src/SessionAlsaPcm.cpp \
     session/src/SessionAgm.cpp \
     session/src/SessionAlsaUtils.cpp \
@@ -114,10 +115,13 @@ LOCAL_SRC_FILES := \
     session/src/ACDEngine.cpp \
     resource_manager/src/ResourceManager.cpp \
     resource_manager/src/SndCardMonitor.cpp \
+    resource_manager/src/StreamHandleTable.cpp \
     utils/src/SoundTriggerXmlParser.cpp \
     utils/src/SoundTriggerPlatformInfo.cpp \
     utils/src/ACDPlatformInfo.cpp \
     utils/src/PalRingBuffer.cpp \
+    utils/src/PalTimestampClock.cpp \
+    utils/src/PalInitTaskGraph.cpp \
     utils/src/SoundTriggerUtils.cpp \
     utils/src/SignalHandler.cpp
 ifeq ($(strip $(AUDIO_FEATURE_ENABLED_EC_REF_CAPTURE)),true)
@@ -196,6 +200,117 @@ LOCAL_VENDOR_MODULE := true
 
 include $(BUILD_EXECUTABLE)
 
+ifneq ($(QCPATH),)
+
+include $(CLEAR_VARS)
+
+LOCAL_MODULE        := PalRingBufferTest
+LOCAL_MODULE_OWNER  := qti
+LOCAL_MODULE_TAGS   := optional
+LOCAL_VENDOR_MODULE := true
+
+LOCAL_CFLAGS        += -Wall -Werror -Wno-unused-variable -Wno-unused-parameter
+
+LOCAL_SRC_FILES := \
+    test/PalRingBufferTest.cpp \
+    utils/src/PalRingBuffer.cpp
+
+LOCAL_C_INCLUDES := \
+    $(LOCAL_PATH) \
+    $(LOCAL_PATH)/utils/inc
+
+LOCAL_HEADER_LIBRARIES := libarosal_headers
+LOCAL_SHARED_LIBRARIES := liblog liblx-osal
+
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_MODULE        := PalInitTaskGraphTest
+LOCAL_MODULE_OWNER  := qti
+LOCAL_MODULE_TAGS   := optional
+LOCAL_VENDOR_MODULE := true
+
+LOCAL_CFLAGS        += -Wall -Werror -Wno-unused-variable -Wno-unused-parameter
+
+LOCAL_SRC_FILES := \
+    test/PalInitTaskGraphTest.cpp \
+    utils/src/PalInitTaskGraph.cpp
+
+LOCAL_C_INCLUDES := \
+    $(LOCAL_PATH) \
+    $(LOCAL_PATH)/utils/inc
+
+LOCAL_HEADER_LIBRARIES := libarosal_headers
+LOCAL_SHARED_LIBRARIES := liblog liblx-osal
+
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_MODULE        := PalTimestampClockTest
+LOCAL_MODULE_OWNER  := qti
+LOCAL_MODULE_TAGS   := optional
+LOCAL_VENDOR_MODULE := true
+
+LOCAL_CFLAGS        += -Wall -Werror -Wno-unused-variable -Wno-unused-parameter
+
+LOCAL_SRC_FILES := \
+    test/PalTimestampClockTest.cpp \
+    utils/src/PalTimestampClock.cpp
+
+LOCAL_C_INCLUDES := \
+    $(LOCAL_PATH) \
+    $(LOCAL_PATH)/utils/inc
+
+LOCAL_HEADER_LIBRARIES := libarosal_headers
+LOCAL_SHARED_LIBRARIES := liblog liblx-osal libcutils
+
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_MODULE        := PalKvIndexTest
+LOCAL_MODULE_OWNER  := qti
+LOCAL_MODULE_TAGS   := optional
+LOCAL_VENDOR_MODULE := true
+
+LOCAL_CFLAGS        := -D_ANDROID_
+LOCAL_CFLAGS        += -Wno-macro-redefined
+LOCAL_CFLAGS        += -Wall -Werror -Wno-unused-variable -Wno-unused-parameter
+LOCAL_CPPFLAGS      += -fexceptions -frtti
+
+LOCAL_C_INCLUDES := \
+    $(TOP)/system/media/audio_route/include \
+    $(TOP)/system/media/audio/include
+LOCAL_C_INCLUDES += $(TARGET_OUT_INTERMEDIATES)/KERNEL_OBJ/usr/include
+
+LOCAL_SRC_FILES := test/PalKvIndexTest.cpp
+
+LOCAL_HEADER_LIBRARIES := \
+    libspf-headers \
+    libcapiv2_headers \
+    libagm_headers \
+    libacdb_headers \
+    libpal_headers \
+    libarpal_headers
+
+LOCAL_SHARED_LIBRARIES := \
+    libar-pal \
+    liblog \
+    libexpat
+
+ifneq ($(filter 11 R, $(PLATFORM_VERSION)),)
+LOCAL_C_INCLUDES       += $(TOP)/vendor/qcom/opensource/tinyalsa/include
+LOCAL_SHARED_LIBRARIES += libqti-tinyalsa
+else
+LOCAL_SHARED_LIBRARIES += libtinyalsa
+endif
+
+include $(BUILD_EXECUTABLE)
+
+endif
+
 include $(CLEAR_VARS)
 
 include $(PAL_BASE_PATH)/plugins/Android.mk
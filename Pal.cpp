@@ -151,6 +151,13 @@ int32_t pal_stream_open(struct pal_stream_attributes *attributes,
         return status;
     }
 
+    status = rm->waitForInitTasks();
+    if (status) {
+        PAL_ERR(LOG_TAG, "PAL init incomplete, status %d", status);
+        status = -EINVAL;
+        return status;
+    }
+
     if (!attributes) {
         status = -EINVAL;
         PAL_ERR(LOG_TAG, "Invalid input parameters status %d", status);
@@ -183,14 +190,22 @@ int32_t pal_stream_open(struct pal_stream_attributes *attributes,
         goto exit;
     }
 
+    /* handle must be assigned before any callback can be delivered */
+    stream = rm->initStreamUserCounter(s);
+    if (!stream) {
+        status = -ENOMEM;
+        PAL_ERR(LOG_TAG, "no stream handle available, status %d", status);
+        s->close();
+        delete s;
+        goto exit;
+    }
+
     s->getStreamAttributes(&sAttr);
     notify_concurrent_stream(sAttr.type, sAttr.direction, true);
 
     if (cb)
        s->registerCallBack(cb, cookie);
 
-    rm->initStreamUserCounter(s);
-    stream = reinterpret_cast<uint64_t *>(s);
     *stream_handle = stream;
 exit:
     PAL_INFO(LOG_TAG, "Exit. Value of stream_handle %pK, status %d", stream, status);
@@ -217,19 +232,17 @@ int32_t pal_stream_close(pal_stream_handle_t *stream_handle)
         return status;
     }
 
-    rm->lockValidStreamMutex();
-    if (!rm->isActiveStream(stream_handle)) {
+    status = rm->increaseStreamUserCounter(stream_handle, &s);
+    if (0 != status) {
         status = -EINVAL;
-        rm->unlockValidStreamMutex();
         return status;
     }
-    rm->unlockValidStreamMutex();
+    rm->decreaseStreamUserCounter(stream_handle);
 
-    s = reinterpret_cast<Stream *>(stream_handle);
     s->setCachedState(STREAM_IDLE);
     status = s->close();
 
-    if (rm->deactivateStreamUserCounter(s)) {
+    if (rm->deactivateStreamUserCounter(stream_handle)) {
         PAL_ERR(LOG_TAG, "stream is being closed by another client");
         return 0;
     }
@@ -242,7 +255,7 @@ exit:
     s->getStreamAttributes(&sAttr);
     notify_concurrent_stream(sAttr.type, sAttr.direction, false);
     delete s;
-    rm->eraseStreamUserCounter(s);
+    rm->eraseStreamUserCounter(stream_handle);
     PAL_INFO(LOG_TAG, "Exit. status %d", status);
     return status;
 }
@@ -266,27 +279,20 @@ int32_t pal_stream_start(pal_stream_handle_t *stream_handle)
         goto exit;
     }
 
-    rm->lockValidStreamMutex();
     if (!rm->isActiveStream(stream_handle)) {
-        rm->unlockValidStreamMutex();
         status = -EINVAL;
         goto exit;
     }
 
-    s = reinterpret_cast<Stream *>(stream_handle);
-    status = rm->increaseStreamUserCounter(s);
+    status = rm->increaseStreamUserCounter(stream_handle, &s);
     if (0 != status) {
-        rm->unlockValidStreamMutex();
         PAL_ERR(LOG_TAG, "failed to increase stream user count");
         goto exit;
     }
-    rm->unlockValidStreamMutex();
 
     status = s->start();
 
-    rm->lockValidStreamMutex();
-    rm->decreaseStreamUserCounter(s);
-    rm->unlockValidStreamMutex();
+    rm->decreaseStreamUserCounter(stream_handle);
 
     if (0 != status) {
         PAL_ERR(LOG_TAG, "stream start failed. status %d", status);
@@ -317,27 +323,20 @@ int32_t pal_stream_stop(pal_stream_handle_t *stream_handle)
         goto exit;
     }
 
-    rm->lockValidStreamMutex();
     if (!rm->isActiveStream(stream_handle)) {
-        rm->unlockValidStreamMutex();
         status = -EINVAL;
         goto exit;
     }
 
-    s = reinterpret_cast<Stream *>(stream_handle);
-    status = rm->increaseStreamUserCounter(s);
+    status = rm->increaseStreamUserCounter(stream_handle, &s);
     if (0 != status) {
-        rm->unlockValidStreamMutex();
         PAL_ERR(LOG_TAG, "failed to increase stream user count");
         goto exit;
     }
-    rm->unlockValidStreamMutex();
     s->setCachedState(STREAM_STOPPED);
     status = s->stop();
 
-    rm->lockValidStreamMutex();
-    rm->decreaseStreamUserCounter(s);
-    rm->unlockValidStreamMutex();
+    rm->decreaseStreamUserCounter(stream_handle);
 
     if (0 != status) {
         PAL_ERR(LOG_TAG, "stream stop failed. status : %d", status);
@@ -361,32 +360,25 @@ ssize_t pal_stream_write(pal_stream_handle_t *stream_handle, struct pal_buffer *
         status = -EINVAL;
         return status;
     }
-    rm->lockValidStreamMutex();
     if (!stream_handle || !rm->isActiveStream(stream_handle) || !buf) {
-        rm->unlockValidStreamMutex();
         status = -EINVAL;
         PAL_ERR(LOG_TAG, "Invalid input parameters status %d", status);
         return status;
     }
 
     PAL_VERBOSE(LOG_TAG, "Enter. Stream handle :%pK", stream_handle);
-    s =  reinterpret_cast<Stream *>(stream_handle);
-    status = rm->increaseStreamUserCounter(s);
+    status = rm->increaseStreamUserCounter(stream_handle, &s);
     if (0 != status) {
-        rm->unlockValidStreamMutex();
         PAL_ERR(LOG_TAG, "failed to increase stream user count");
         return status;
     }
-    rm->unlockValidStreamMutex();
 
     status = s->write(buf);
     if (status < 0) {
         PAL_ERR(LOG_TAG, "stream write failed status %d", status);
     }
 
-    rm->lockValidStreamMutex();
-    rm->decreaseStreamUserCounter(s);
-    rm->unlockValidStreamMutex();
+    rm->decreaseStreamUserCounter(stream_handle);
 
     PAL_VERBOSE(LOG_TAG, "Exit. status %d", status);
     return status;
@@ -404,32 +396,98 @@ ssize_t pal_stream_read(pal_stream_handle_t *stream_handle, struct pal_buffer *b
         status = -EINVAL;
         return status;
     }
-    rm->lockValidStreamMutex();
     if (!stream_handle || !rm->isActiveStream(stream_handle) || !buf) {
-        rm->unlockValidStreamMutex();
         status = -EINVAL;
         PAL_ERR(LOG_TAG, "Invalid input parameters status %d", status);
         return status;
     }
 
     PAL_VERBOSE(LOG_TAG, "Enter. Stream handle :%pK", stream_handle);
-    s =  reinterpret_cast<Stream *>(stream_handle);
-    status = rm->increaseStreamUserCounter(s);
+    status = rm->increaseStreamUserCounter(stream_handle, &s);
     if (0 != status) {
-        rm->unlockValidStreamMutex();
         PAL_ERR(LOG_TAG, "failed to increase stream user count");
         return status;
     }
-    rm->unlockValidStreamMutex();
 
     status = s->read(buf);
     if (status < 0) {
         PAL_ERR(LOG_TAG, "stream read failed status %d", status);
     }
 
-    rm->lockValidStreamMutex();
-    rm->decreaseStreamUserCounter(s);
-    rm->unlockValidStreamMutex();
+    rm->decreaseStreamUserCounter(stream_handle);
+    PAL_VERBOSE(LOG_TAG, "Exit. status %d", status);
+    return status;
+}
+
+ssize_t pal_stream_writev(pal_stream_handle_t *stream_handle,
+                          const struct pal_iovec *iov, uint32_t iovcnt)
+{
+    Stream *s = NULL;
+    int status;
+    std::shared_ptr<ResourceManager> rm = NULL;
+
+    rm = ResourceManager::getInstance();
+    if (!rm) {
+        PAL_ERR(LOG_TAG, "Invalid resource manager");
+        status = -EINVAL;
+        return status;
+    }
+    if (!stream_handle || !rm->isActiveStream(stream_handle) || !iov || !iovcnt) {
+        status = -EINVAL;
+        PAL_ERR(LOG_TAG, "Invalid input parameters status %d", status);
+        return status;
+    }
+
+    PAL_VERBOSE(LOG_TAG, "Enter. Stream handle :%pK iovcnt %u", stream_handle, iovcnt);
+    status = rm->increaseStreamUserCounter(stream_handle, &s);
+    if (0 != status) {
+        PAL_ERR(LOG_TAG, "failed to increase stream user count");
+        return status;
+    }
+
+    status = s->writev(iov, iovcnt);
+    if (status < 0) {
+        PAL_ERR(LOG_TAG, "stream writev failed status %d", status);
+    }
+
+    rm->decreaseStreamUserCounter(stream_handle);
+
+    PAL_VERBOSE(LOG_TAG, "Exit. status %d", status);
+    return status;
+}
+
+ssize_t pal_stream_readv(pal_stream_handle_t *stream_handle,
+                         const struct pal_iovec *iov, uint32_t iovcnt)
+{
+    Stream *s = NULL;
+    int status;
+    std::shared_ptr<ResourceManager> rm = NULL;
+
+    rm = ResourceManager::getInstance();
+    if (!rm) {
+        PAL_ERR(LOG_TAG, "Invalid resource manager");
+        status = -EINVAL;
+        return status;
+    }
+    if (!stream_handle || !rm->isActiveStream(stream_handle) || !iov || !iovcnt) {
+        status = -EINVAL;
+        PAL_ERR(LOG_TAG, "Invalid input parameters status %d", status);
+        return status;
+    }
+
+    PAL_VERBOSE(LOG_TAG, "Enter. Stream handle :%pK iovcnt %u", stream_handle, iovcnt);
+    status = rm->increaseStreamUserCounter(stream_handle, &s);
+    if (0 != status) {
+        PAL_ERR(LOG_TAG, "failed to increase stream user count");
+        return status;
+    }
+
+    status = s->readv(iov, iovcnt);
+    if (status < 0) {
+        PAL_ERR(LOG_TAG, "stream readv failed status %d", status);
+    }
+
+    rm->decreaseStreamUserCounter(stream_handle);
     PAL_VERBOSE(LOG_TAG, "Exit. status %d", status);
     return status;
 }
@@ -448,32 +506,25 @@ int32_t pal_stream_get_param(pal_stream_handle_t *stream_handle,
         return status;
     }
 
-    rm->lockValidStreamMutex();
     if (!stream_handle || !rm->isActiveStream(stream_handle)) {
-        rm->unlockValidStreamMutex();
         status = -EINVAL;
         PAL_ERR(LOG_TAG,  "Invalid input parameters status %d", status);
         return status;
     }
 
     PAL_DBG(LOG_TAG, "Enter. Stream handle :%pK", stream_handle);
-    s =  reinterpret_cast<Stream *>(stream_handle);
-    status = rm->increaseStreamUserCounter(s);
+    status = rm->increaseStreamUserCounter(stream_handle, &s);
     if (0 != status) {
-        rm->unlockValidStreamMutex();
         PAL_ERR(LOG_TAG, "failed to increase stream user count");
         return status;
     }
-    rm->unlockValidStreamMutex();
 
     status = s->getParameters(param_id, (void **)param_payload);
     if (0 != status) {
         PAL_ERR(LOG_TAG, "get parameters failed status %d param_id %u", status, param_id);
     }
 
-    rm->lockValidStreamMutex();
-    rm->decreaseStreamUserCounter(s);
-    rm->unlockValidStreamMutex();
+    rm->decreaseStreamUserCounter(stream_handle);
     PAL_DBG(LOG_TAG, "Exit. status %d", status);
     return status;
 }
@@ -492,9 +543,7 @@ int32_t pal_stream_set_param(pal_stream_handle_t *stream_handle, uint32_t param_
         return status;
     }
 
-    rm->lockValidStreamMutex();
     if (!stream_handle || !rm->isActiveStream(stream_handle)) {
-        rm->unlockValidStreamMutex();
         status = -EINVAL;
         PAL_ERR(LOG_TAG,  "Invalid stream handle, status %d", status);
         return status;
@@ -502,20 +551,15 @@ int32_t pal_stream_set_param(pal_stream_handle_t *stream_handle, uint32_t param_
 
     PAL_DBG(LOG_TAG, "Enter. Stream handle :%pK param_id %d", stream_handle,
             param_id);
-    s =  reinterpret_cast<Stream *>(stream_handle);
-    status = rm->increaseStreamUserCounter(s);
+    status = rm->increaseStreamUserCounter(stream_handle, &s);
     if (0 != status) {
-        rm->unlockValidStreamMutex();
         PAL_ERR(LOG_TAG, "failed to increase stream user count");
         return status;
     }
-    rm->unlockValidStreamMutex();
 
     status = s->setParameters(param_id, (void *)param_payload);
 
-    rm->lockValidStreamMutex();
-    rm->decreaseStreamUserCounter(s);
-    rm->unlockValidStreamMutex();
+    rm->decreaseStreamUserCounter(stream_handle);
 
     if (0 != status) {
         PAL_ERR(LOG_TAG, "set parameters failed status %d param_id %u", status, param_id);
@@ -551,27 +595,20 @@ int32_t pal_stream_set_volume(pal_stream_handle_t *stream_handle,
     }
     PAL_DBG(LOG_TAG, "Enter. Stream handle :%pK", stream_handle);
 
-    rm->lockValidStreamMutex();
     if (!rm->isActiveStream(stream_handle)) {
-        rm->unlockValidStreamMutex();
         status = -EINVAL;
         return status;
     }
 
-    s =  reinterpret_cast<Stream *>(stream_handle);
-    status = rm->increaseStreamUserCounter(s);
+    status = rm->increaseStreamUserCounter(stream_handle, &s);
     if (0 != status) {
-        rm->unlockValidStreamMutex();
         PAL_ERR(LOG_TAG, "failed to increase stream user count");
         return status;
     }
-    rm->unlockValidStreamMutex();
 
     status = s->setVolume(volume);
 
-    rm->lockValidStreamMutex();
-    rm->decreaseStreamUserCounter(s);
-    rm->unlockValidStreamMutex();
+    rm->decreaseStreamUserCounter(stream_handle);
 
     if (0 != status) {
         PAL_ERR(LOG_TAG, "setVolume failed with status %d", status);
@@ -602,26 +639,19 @@ int32_t pal_stream_set_mute(pal_stream_handle_t *stream_handle, bool state)
 
     PAL_DBG(LOG_TAG, "Enter. Stream handle :%pK", stream_handle);
 
-    rm->lockValidStreamMutex();
     if (!rm->isActiveStream(stream_handle)) {
-        rm->unlockValidStreamMutex();
         status = -EINVAL;
         goto exit;
     }
 
-    s =  reinterpret_cast<Stream *>(stream_handle);
-    status = rm->increaseStreamUserCounter(s);
+    status = rm->increaseStreamUserCounter(stream_handle, &s);
     if (0 != status) {
-        rm->unlockValidStreamMutex();
         PAL_ERR(LOG_TAG, "failed to increase stream user count");
         goto exit;
     }
-    rm->unlockValidStreamMutex();
     status = s->mute(state);
 
-    rm->lockValidStreamMutex();
-    rm->decreaseStreamUserCounter(s);
-    rm->unlockValidStreamMutex();
+    rm->decreaseStreamUserCounter(stream_handle);
 
     if (0 != status) {
         PAL_ERR(LOG_TAG, "mute failed with status %d", status);
@@ -646,31 +676,24 @@ int32_t pal_stream_pause(pal_stream_handle_t *stream_handle)
         return status;
     }
 
-    rm->lockValidStreamMutex();
     if (!stream_handle || !rm->isActiveStream(stream_handle)) {
-        rm->unlockValidStreamMutex();
         status = -EINVAL;
         PAL_ERR(LOG_TAG, "Invalid stream handle status %d", status);
         return status;
     }
 
     PAL_DBG(LOG_TAG, "Enter. Stream handle :%pK", stream_handle);
-    s =  reinterpret_cast<Stream *>(stream_handle);
-    status = rm->increaseStreamUserCounter(s);
+    status = rm->increaseStreamUserCounter(stream_handle, &s);
     if (0 != status) {
-        rm->unlockValidStreamMutex();
         PAL_ERR(LOG_TAG, "failed to increase stream user count");
         return status;
     }
-    rm->unlockValidStreamMutex();
 
     status = s->pause();
     if (0 != status) {
         PAL_ERR(LOG_TAG, "pal_stream_pause failed with status %d", status);
     }
-    rm->lockValidStreamMutex();
-    rm->decreaseStreamUserCounter(s);
-    rm->unlockValidStreamMutex();
+    rm->decreaseStreamUserCounter(stream_handle);
     PAL_DBG(LOG_TAG, "Exit. status %d", status);
     return status;
 }
@@ -688,31 +711,24 @@ int32_t pal_stream_resume(pal_stream_handle_t *stream_handle)
         return status;
     }
 
-    rm->lockValidStreamMutex();
     if (!stream_handle || !rm->isActiveStream(stream_handle)) {
-        rm->unlockValidStreamMutex();
         status = -EINVAL;
         PAL_ERR(LOG_TAG, "Invalid stream handle status %d", status);
         return status;
     }
 
     PAL_DBG(LOG_TAG, "Enter. Stream handle :%pK", stream_handle);
-    s =  reinterpret_cast<Stream *>(stream_handle);
-    status = rm->increaseStreamUserCounter(s);
+    status = rm->increaseStreamUserCounter(stream_handle, &s);
     if (0 != status) {
-        rm->unlockValidStreamMutex();
         PAL_ERR(LOG_TAG, "failed to increase stream user count");
         return status;
     }
-    rm->unlockValidStreamMutex();
 
     status = s->resume();
     if (0 != status) {
         PAL_ERR(LOG_TAG, "resume failed with status %d", status);
     }
-    rm->lockValidStreamMutex();
-    rm->decreaseStreamUserCounter(s);
-    rm->unlockValidStreamMutex();
+    rm->decreaseStreamUserCounter(stream_handle);
     PAL_DBG(LOG_TAG, "Exit. status %d", status);
     return status;
 }
@@ -738,27 +754,20 @@ int32_t pal_stream_drain(pal_stream_handle_t *stream_handle, pal_drain_type_t ty
         goto exit;
     }
 
-    rm->lockValidStreamMutex();
     if (!rm->isActiveStream(stream_handle)) {
-        rm->unlockValidStreamMutex();
         status = -EINVAL;
         goto exit;
     }
 
-    s =  reinterpret_cast<Stream *>(stream_handle);
-    status = rm->increaseStreamUserCounter(s);
+    status = rm->increaseStreamUserCounter(stream_handle, &s);
     if (0 != status) {
-        rm->unlockValidStreamMutex();
         PAL_ERR(LOG_TAG, "failed to increase stream user count");
         goto exit;
     }
-    rm->unlockValidStreamMutex();
 
     status = s->drain(type);
 
-    rm->lockValidStreamMutex();
-    rm->decreaseStreamUserCounter(s);
-    rm->unlockValidStreamMutex();
+    rm->decreaseStreamUserCounter(stream_handle);
 
     if (0 != status) {
         PAL_ERR(LOG_TAG, "drain failed with status %d", status);
@@ -782,32 +791,25 @@ int32_t pal_stream_flush(pal_stream_handle_t *stream_handle)
         return status;
     }
 
-    rm->lockValidStreamMutex();
     if (!stream_handle || !rm->isActiveStream(stream_handle)) {
-        rm->unlockValidStreamMutex();
         status = -EINVAL;
         PAL_ERR(LOG_TAG, "Invalid stream handle status %d", status);
         return status;
     }
 
     PAL_DBG(LOG_TAG, "Enter. Stream handle :%pK", stream_handle);
-    s =  reinterpret_cast<Stream *>(stream_handle);
-    status = rm->increaseStreamUserCounter(s);
+    status = rm->increaseStreamUserCounter(stream_handle, &s);
     if (0 != status) {
-        rm->unlockValidStreamMutex();
         PAL_ERR(LOG_TAG, "failed to increase stream user count");
         return status;
     }
-    rm->unlockValidStreamMutex();
 
     status = s->flush();
     if (0 != status) {
         PAL_ERR(LOG_TAG, "flush failed with status %d", status);
     }
 
-    rm->lockValidStreamMutex();
-    rm->decreaseStreamUserCounter(s);
-    rm->unlockValidStreamMutex();
+    rm->decreaseStreamUserCounter(stream_handle);
     PAL_DBG(LOG_TAG, "Exit. status %d", status);
     return status;
 }
@@ -825,32 +827,25 @@ int32_t pal_stream_suspend(pal_stream_handle_t *stream_handle)
         return status;
     }
 
-    rm->lockValidStreamMutex();
     if (!stream_handle || !rm->isActiveStream(stream_handle)) {
-        rm->unlockValidStreamMutex();
         status = -EINVAL;
         PAL_ERR(LOG_TAG, "Invalid stream handle status %d", status);
         return status;
     }
 
     PAL_DBG(LOG_TAG, "Enter. Stream handle :%pK", stream_handle);
-    s =  reinterpret_cast<Stream *>(stream_handle);
-    status = rm->increaseStreamUserCounter(s);
+    status = rm->increaseStreamUserCounter(stream_handle, &s);
     if (0 != status) {
-        rm->unlockValidStreamMutex();
         PAL_ERR(LOG_TAG, "failed to increase stream user count");
         return status;
     }
-    rm->unlockValidStreamMutex();
 
     status = s->suspend();
     if (0 != status) {
         PAL_ERR(LOG_TAG, "suspend failed with status %d", status);
     }
 
-    rm->lockValidStreamMutex();
-    rm->decreaseStreamUserCounter(s);
-    rm->unlockValidStreamMutex();
+    rm->decreaseStreamUserCounter(stream_handle);
     PAL_DBG(LOG_TAG, "Exit. status %d", status);
     return status;
 }
@@ -870,31 +865,24 @@ int32_t pal_stream_set_buffer_size (pal_stream_handle_t *stream_handle,
         return status;
     }
 
-    rm->lockValidStreamMutex();
     if (!stream_handle || !rm->isActiveStream(stream_handle)) {
-        rm->unlockValidStreamMutex();
         status = -EINVAL;
         PAL_ERR(LOG_TAG, "Invalid stream handle status %d", status);
         return status;
     }
 
     PAL_DBG(LOG_TAG, "Enter. Stream handle :%pK", stream_handle);
-    s =  reinterpret_cast<Stream *>(stream_handle);
-    status = rm->increaseStreamUserCounter(s);
+    status = rm->increaseStreamUserCounter(stream_handle, &s);
     if (0 != status) {
-        rm->unlockValidStreamMutex();
         PAL_ERR(LOG_TAG, "failed to increase stream user count");
         return status;
     }
-    rm->unlockValidStreamMutex();
 
     status = s->setBufInfo(in_buffer_cfg, out_buffer_cfg);
     if (0 != status) {
         PAL_ERR(LOG_TAG, "pal_stream_set_buffer_size failed with status %d", status);
     }
-    rm->lockValidStreamMutex();
-    rm->decreaseStreamUserCounter(s);
-    rm->unlockValidStreamMutex();
+    rm->decreaseStreamUserCounter(stream_handle);
     PAL_DBG(LOG_TAG, "Exit. status %d", status);
     return status;
 }
@@ -913,26 +901,19 @@ int32_t pal_get_timestamp(pal_stream_handle_t *stream_handle,
         return status;
     }
 
-    rm->lockValidStreamMutex();
     if (!stream_handle || !rm->isActiveStream(stream_handle)) {
-        rm->unlockValidStreamMutex();
         status = -EINVAL;
         PAL_ERR(LOG_TAG, "Invalid stream handle status %d", status);
         return status;
     }
-    s =  reinterpret_cast<Stream *>(stream_handle);
-    status = rm->increaseStreamUserCounter(s);
+    status = rm->increaseStreamUserCounter(stream_handle, &s);
     if (0 != status) {
-        rm->unlockValidStreamMutex();
         PAL_ERR(LOG_TAG, "failed to increase stream user count");
         return status;
     }
-    rm->unlockValidStreamMutex();
     status = s->getTimestamp(stime);
 
-    rm->lockValidStreamMutex();
-    rm->decreaseStreamUserCounter(s);
-    rm->unlockValidStreamMutex();
+    rm->decreaseStreamUserCounter(stream_handle);
 
     if (0 != status) {
         PAL_ERR(LOG_TAG, "pal_get_timestamp failed with status %d\n", status);
@@ -961,32 +942,25 @@ int32_t pal_add_remove_effect(pal_stream_handle_t *stream_handle,
         return status;
     }
 
-    rm->lockValidStreamMutex();
     if (!stream_handle || !rm->isActiveStream(stream_handle)) {
-        rm->unlockValidStreamMutex();
         status = -EINVAL;
         PAL_ERR(LOG_TAG, "Invalid stream handle status %d", status);
         return status;
     }
 
     PAL_DBG(LOG_TAG, "Enter. Stream handle :%pK", stream_handle);
-    s =  reinterpret_cast<Stream *>(stream_handle);
-    status = rm->increaseStreamUserCounter(s);
+    status = rm->increaseStreamUserCounter(stream_handle, &s);
     if (0 != status) {
-        rm->unlockValidStreamMutex();
         PAL_ERR(LOG_TAG, "failed to increase stream user count");
         return status;
     }
-    rm->unlockValidStreamMutex();
 
     status = s->addRemoveEffect(effect, enable);
     if (0 != status) {
         PAL_ERR(LOG_TAG, "pal_add_effect failed with status %d", status);
     }
 
-    rm->lockValidStreamMutex();
-    rm->decreaseStreamUserCounter(s);
-    rm->unlockValidStreamMutex();
+    rm->decreaseStreamUserCounter(stream_handle);
     PAL_DBG(LOG_TAG, "Exit. status %d", status);
     return status;
 
@@ -1025,23 +999,18 @@ int32_t pal_stream_set_device(pal_stream_handle_t *stream_handle,
         return status;
     }
 
-    rm->lockValidStreamMutex();
     if (!rm->isActiveStream(stream_handle)) {
-        rm->unlockValidStreamMutex();
         status = -EINVAL;
         return status;
     }
 
     /* Choose best device config for this stream */
     /* TODO: Decide whether to update device config or not based on flag */
-    s = reinterpret_cast<Stream *>(stream_handle);
-    status = rm->increaseStreamUserCounter(s);
+    status = rm->increaseStreamUserCounter(stream_handle, &s);
     if (0 != status) {
-        rm->unlockValidStreamMutex();
         PAL_ERR(LOG_TAG, "failed to increase stream user count");
         return status;
     }
-    rm->unlockValidStreamMutex();
 
     s->getStreamAttributes(&sattr);
 
@@ -1142,9 +1111,7 @@ int32_t pal_stream_set_device(pal_stream_handle_t *stream_handle,
     }
 
 exit:
-    rm->lockValidStreamMutex();
-    rm->decreaseStreamUserCounter(s);
-    rm->unlockValidStreamMutex();
+    rm->decreaseStreamUserCounter(stream_handle);
     if (pDevices)
         free(pDevices);
     PAL_INFO(LOG_TAG, "Exit. status %d", status);
@@ -1165,9 +1132,7 @@ int32_t pal_stream_get_tags_with_module_info(pal_stream_handle_t *stream_handle,
         return status;
     }
 
-    rm->lockValidStreamMutex();
     if (!stream_handle || !rm->isActiveStream(stream_handle)) {
-        rm->unlockValidStreamMutex();
         status = -EINVAL;
         PAL_ERR(LOG_TAG, "Invalid stream handle status %d", status);
         return status;
@@ -1175,20 +1140,15 @@ int32_t pal_stream_get_tags_with_module_info(pal_stream_handle_t *stream_handle,
 
     PAL_DBG(LOG_TAG, "Enter. Stream handle :%pK", stream_handle);
 
-    s =  reinterpret_cast<Stream *>(stream_handle);
-    status = rm->increaseStreamUserCounter(s);
+    status = rm->increaseStreamUserCounter(stream_handle, &s);
     if (0 != status) {
-        rm->unlockValidStreamMutex();
         PAL_ERR(LOG_TAG, "failed to increase stream user count");
         return status;
     }
-    rm->unlockValidStreamMutex();
 
     status = s->getTagsWithModuleInfo(size, payload);
 
-    rm->lockValidStreamMutex();
-    rm->decreaseStreamUserCounter(s);
-    rm->unlockValidStreamMutex();
+    rm->decreaseStreamUserCounter(stream_handle);
     PAL_DBG(LOG_TAG, "Exit. Stream handle: %pK, status %d", stream_handle, status);
     return status;
 }
@@ -1202,6 +1162,7 @@ int32_t pal_set_param(uint32_t param_id, void *param_payload,
 
     rm = ResourceManager::getInstance();
     if (rm) {
+        rm->waitForInitTasks();
         status = rm->setParameter(param_id, param_payload, payload_size);
         if (0 != status) {
             PAL_ERR(LOG_TAG, "Failed to set global parameter %u, status %d",
@@ -1226,6 +1187,7 @@ int32_t pal_get_param(uint32_t param_id, void **param_payload,
     PAL_DBG(LOG_TAG, "Enter:");
 
     if (rm) {
+        rm->waitForInitTasks();
         status = rm->getParameter(param_id, param_payload, payload_size, query);
         if (0 != status) {
             PAL_ERR(LOG_TAG, "Failed to get global parameter %u, status %d",
@@ -1253,32 +1215,25 @@ int32_t pal_stream_get_mmap_position(pal_stream_handle_t *stream_handle,
         return status;
     }
 
-    rm->lockValidStreamMutex();
     if (!stream_handle || !rm->isActiveStream(stream_handle)) {
-        rm->unlockValidStreamMutex();
         status = -EINVAL;
         PAL_ERR(LOG_TAG, "Invalid stream handle status %d", status);
         return status;
     }
 
     PAL_DBG(LOG_TAG, "Enter. Stream handle :%pK", stream_handle);
-    s =  reinterpret_cast<Stream *>(stream_handle);
-    status = rm->increaseStreamUserCounter(s);
+    status = rm->increaseStreamUserCounter(stream_handle, &s);
     if (0 != status) {
-        rm->unlockValidStreamMutex();
         PAL_ERR(LOG_TAG, "failed to increase stream user count");
         return status;
     }
-    rm->unlockValidStreamMutex();
 
     status = s->GetMmapPosition(position);
     if (0 != status) {
         PAL_ERR(LOG_TAG, "pal_stream_get_mmap_position failed with status %d", status);
     }
 
-    rm->lockValidStreamMutex();
-    rm->decreaseStreamUserCounter(s);
-    rm->unlockValidStreamMutex();
+    rm->decreaseStreamUserCounter(stream_handle);
     PAL_DBG(LOG_TAG, "Exit. status %d", status);
     return status;
 }
@@ -1298,32 +1253,25 @@ int32_t pal_stream_create_mmap_buffer(pal_stream_handle_t *stream_handle,
         return status;
     }
 
-    rm->lockValidStreamMutex();
     if (!stream_handle || !rm->isActiveStream(stream_handle)) {
-        rm->unlockValidStreamMutex();
         status = -EINVAL;
         PAL_ERR(LOG_TAG, "Invalid stream handle status %d", status);
         return status;
     }
 
     PAL_DBG(LOG_TAG, "Enter. Stream handle :%pK", stream_handle);
-    s =  reinterpret_cast<Stream *>(stream_handle);
-    status = rm->increaseStreamUserCounter(s);
+    status = rm->increaseStreamUserCounter(stream_handle, &s);
     if (0 != status) {
-        rm->unlockValidStreamMutex();
         PAL_ERR(LOG_TAG, "failed to increase stream user count");
         return status;
     }
-    rm->unlockValidStreamMutex();
 
     status = s->createMmapBuffer(min_size_frames, info);
     if (0 != status) {
         PAL_ERR(LOG_TAG, "pal_stream_create_mmap_buffer failed with status %d", status);
     }
 
-    rm->lockValidStreamMutex();
-    rm->decreaseStreamUserCounter(s);
-    rm->unlockValidStreamMutex();
+    rm->decreaseStreamUserCounter(stream_handle);
     PAL_DBG(LOG_TAG, "Exit. status %d", status);
     return status;
 }
@@ -1355,6 +1303,7 @@ int32_t pal_gef_rw_param(uint32_t param_id, void *param_payload,
     PAL_DBG(LOG_TAG, "Enter.");
 
     if (rm) {
+        rm->waitForInitTasks();
         if (GEF_PARAM_WRITE == dir) {
             status = rm->setParameter(param_id, param_payload, payload_size,
                                         pal_device_id, pal_stream_type);
@@ -1390,6 +1339,7 @@ int32_t pal_gef_rw_param_acdb(uint32_t param_id __unused, void *param_payload,
 
     PAL_DBG(LOG_TAG, "Enter.");
     if (rm) {
+        rm->waitForInitTasks();
         status = rm->rwParameterACDB(param_id, param_payload, payload_size,
                                         pal_device_id, pal_stream_type,
                                         sample_rate, instance_id, dir, is_play);
@@ -300,6 +300,36 @@ ssize_t pal_stream_read(pal_stream_handle_t *stream_handle, struct pal_buffer *b
   */
 ssize_t pal_stream_write(pal_stream_handle_t *stream_handle, struct pal_buffer *buf);
 
+/**
+  * Scatter variant of pal_stream_read. Captured data is placed
+  * into the spans in order without an intermediate buffer.
+  *
+  * \param[in] stream_handle - Valid stream handle obtained
+  *       from pal_stream_open
+  * \param[in] iov - array of spans to fill.
+  * \param[in] iovcnt - number of entries in iov.
+  *
+  * \return - number of bytes read or error code on failure
+  */
+ssize_t pal_stream_readv(pal_stream_handle_t *stream_handle,
+                         const struct pal_iovec *iov, uint32_t iovcnt);
+
+/**
+  * Gather variant of pal_stream_write. The spans are rendered in
+  * order as one contiguous stream, so a client producing audio in
+  * discontiguous chunks does not need to coalesce them first.
+  * Non-blocking streams follow the pal_stream_write rules.
+  *
+  * \param[in] stream_handle - Valid stream handle obtained
+  *       from pal_stream_open
+  * \param[in] iov - array of spans to render.
+  * \param[in] iovcnt - number of entries in iov.
+  *
+  * \return number of bytes written or error code.
+  */
+ssize_t pal_stream_writev(pal_stream_handle_t *stream_handle,
+                          const struct pal_iovec *iov, uint32_t iovcnt);
+
 /**
   * \brief get current device on stream.
   *
@@ -757,6 +757,12 @@ struct pal_buffer {
     pal_extern_alloc_buff_info_t alloc_info; /**< holds info for extern buff */
 };
 
+/** Scatter/gather span used by pal_stream_readv/pal_stream_writev */
+struct pal_iovec {
+    uint8_t *base;                 /**< start of the span */
+    size_t len;                    /**< number of bytes in the span */
+};
+
 /** pal_mmap_buffer flags */
 enum {
     PAL_MMMAP_BUFF_FLAGS_NONE = 0,
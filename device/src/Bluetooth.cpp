@@ -364,9 +364,7 @@ int Bluetooth::configureA2dpEncoderDecoder()
                     copMiid, codecInfo, false /* StreamMapOut */);
             if (paramSize) {
                 dev->updateCustomPayload(paramData, paramSize);
-                delete [] paramData;
-                paramData = NULL;
-                paramSize = 0;
+                builder->releasePayload(&paramData, &paramSize);
             } else {
                 status = -EINVAL;
                 PAL_ERR(LOG_TAG, "Invalid COPv2 module param size");
@@ -377,9 +375,7 @@ int Bluetooth::configureA2dpEncoderDecoder()
                     copMiid, codecInfo, true /* StreamMapIn */);
             if (paramSize) {
                 dev->updateCustomPayload(paramData, paramSize);
-                delete [] paramData;
-                paramData = NULL;
-                paramSize = 0;
+                builder->releasePayload(&paramData, &paramSize);
             } else {
                 status = -EINVAL;
                 PAL_ERR(LOG_TAG, "Invalid COPv2 module param size");
@@ -416,9 +412,7 @@ int Bluetooth::configureA2dpEncoderDecoder()
             builder->payloadPcmCnvConfig(&paramData, &paramSize, cnvMiid, &codecConfig, false /* isRx */);
             if (paramSize) {
                 dev->updateCustomPayload(paramData, paramSize);
-                delete [] paramData;
-                paramData = NULL;
-                paramSize = 0;
+                builder->releasePayload(&paramData, &paramSize);
             } else {
                 status = -EINVAL;
                 PAL_ERR(LOG_TAG, "Invalid PCM CNV module param size");
@@ -440,9 +434,7 @@ int Bluetooth::configureA2dpEncoderDecoder()
         builder->payloadCopV2PackConfig(&paramData, &paramSize, copMiid, codecInfo);
         if (paramSize) {
             dev->updateCustomPayload(paramData, paramSize);
-            delete [] paramData;
-            paramData = NULL;
-            paramSize = 0;
+            builder->releasePayload(&paramData, &paramSize);
         } else {
             status = -EINVAL;
             PAL_ERR(LOG_TAG, "Invalid COPv2 module param size");
@@ -453,9 +445,7 @@ int Bluetooth::configureA2dpEncoderDecoder()
         builder->payloadCopPackConfig(&paramData, &paramSize, copMiid, &deviceAttr.config);
         if (paramSize) {
             dev->updateCustomPayload(paramData, paramSize);
-            delete [] paramData;
-            paramData = NULL;
-            paramSize = 0;
+            builder->releasePayload(&paramData, &paramSize);
         } else {
             status = -EINVAL;
             PAL_ERR(LOG_TAG, "Invalid COP module param size");
@@ -478,9 +468,7 @@ int Bluetooth::configureA2dpEncoderDecoder()
         builder->payloadCopPackConfig(&paramData, &paramSize, copMiid, &deviceAttr.config);
         if (paramSize) {
             dev->updateCustomPayload(paramData, paramSize);
-            delete [] paramData;
-            paramData = NULL;
-            paramSize = 0;
+            builder->releasePayload(&paramData, &paramSize);
         } else {
             status = -EINVAL;
             PAL_ERR(LOG_TAG, "Invalid COP module param size");
@@ -491,9 +479,7 @@ int Bluetooth::configureA2dpEncoderDecoder()
             builder->payloadScramblingConfig(&paramData, &paramSize, copMiid, isScramblingEnabled);
             if (paramSize) {
                 dev->updateCustomPayload(paramData, paramSize);
-                delete [] paramData;
-                paramData = NULL;
-                paramSize = 0;
+                builder->releasePayload(&paramData, &paramSize);
             } else {
                 status = -EINVAL;
                 PAL_ERR(LOG_TAG, "Invalid COP module param size");
@@ -540,9 +526,7 @@ int Bluetooth::configureA2dpEncoderDecoder()
     builder->payloadPcmCnvConfig(&paramData, &paramSize, cnvMiid, &codecConfig, true /* isRx */);
     if (paramSize) {
         dev->updateCustomPayload(paramData, paramSize);
-        delete [] paramData;
-        paramData = NULL;
-        paramSize = 0;
+        builder->releasePayload(&paramData, &paramSize);
     } else {
         status = -EINVAL;
         PAL_ERR(LOG_TAG, "Invalid PCM CNV module param size");
@@ -889,7 +873,7 @@ void Bluetooth::startAbr()
 
             ret = SessionAlsaUtils::setDeviceCustomPayload(rm, backEndName,
                     paramData, paramSize);
-            delete [] paramData;
+            builder->releasePayload(&paramData, &paramSize);
             if (ret) {
                 PAL_ERR(LOG_TAG, "Error: Dev setParam failed for %d", fbDevice.id);
                 goto disconnect_fe;
@@ -951,9 +935,7 @@ void Bluetooth::startAbr()
                 builder->payloadCopV2DepackConfig(&paramData, &paramSize, miid, codecInfo, false /* StreamMapOut */);
                 if (paramSize) {
                     fbDev->updateCustomPayload(paramData, paramSize);
-                    delete [] paramData;
-                    paramData = NULL;
-                    paramSize = 0;
+                    builder->releasePayload(&paramData, &paramSize);
                 } else {
                     ret = -EINVAL;
                     PAL_ERR(LOG_TAG, "Invalid COPv2 module param size");
@@ -963,9 +945,7 @@ void Bluetooth::startAbr()
                 builder->payloadCopV2DepackConfig(&paramData, &paramSize, miid, codecInfo, true /* StreamMapIn */);
                 if (paramSize) {
                     fbDev->updateCustomPayload(paramData, paramSize);
-                    delete [] paramData;
-                    paramData = NULL;
-                    paramSize = 0;
+                    builder->releasePayload(&paramData, &paramSize);
                 } else {
                     ret = -EINVAL;
                     PAL_ERR(LOG_TAG, "Invalid COPv2 module param size");
@@ -985,9 +965,7 @@ void Bluetooth::startAbr()
                 builder->payloadCopV2PackConfig(&paramData, &paramSize, miid, codecInfo);
                 if (paramSize) {
                     fbDev->updateCustomPayload(paramData, paramSize);
-                    delete [] paramData;
-                    paramData = NULL;
-                    paramSize = 0;
+                    builder->releasePayload(&paramData, &paramSize);
                 } else {
                     ret = -EINVAL;
                     PAL_ERR(LOG_TAG, "Invalid COPv2 module param size");
@@ -998,9 +976,7 @@ void Bluetooth::startAbr()
                 builder->payloadCopPackConfig(&paramData, &paramSize, miid, &fbDevice.config);
                 if (paramSize) {
                     fbDev->updateCustomPayload(paramData, paramSize);
-                    delete [] paramData;
-                    paramData = NULL;
-                    paramSize = 0;
+                    builder->releasePayload(&paramData, &paramSize);
                 } else {
                     ret = -EINVAL;
                     PAL_ERR(LOG_TAG, "Invalid COP module param size");
@@ -1039,9 +1015,7 @@ void Bluetooth::startAbr()
                         (codecType == DEC ? true : false) /* isRx */);
                 if (paramSize) {
                     fbDev->updateCustomPayload(paramData, paramSize);
-                    delete [] paramData;
-                    paramData = NULL;
-                    paramSize = 0;
+                    builder->releasePayload(&paramData, &paramSize);
                 } else {
                     ret = -EINVAL;
                     PAL_ERR(LOG_TAG, "Invalid PCM CNV module param size");
@@ -3916,11 +3916,8 @@ int32_t SpeakerProtection::getFTMParameter(void **param)
 
     PAL_DBG(LOG_TAG, "Got FTM value with status %d", ftm_ret[0].status);
 
-    if (payload) {
-        delete payload;
-        payloadSize = 0;
-        payload = NULL;
-    }
+    if (payload)
+        builder->releasePayload(&payload, &payloadSize);
 
     exFtm.num_ch = numberOfChannels;
     builder->payloadSPConfig (&payload, &payloadSize, miid,
@@ -3952,11 +3949,8 @@ int32_t SpeakerProtection::getFTMParameter(void **param)
     }
     PAL_DBG(LOG_TAG, "Got FTM Excursion value with status %d", exFtm_ret[0].status);
 
-    if (payload) {
-        delete payload;
-        payloadSize = 0;
-        payload = NULL;
-    }
+    if (payload)
+        builder->releasePayload(&payload, &payloadSize);
 
     switch(numberOfChannels) {
         case 1 :
@@ -87,6 +87,8 @@
 #include "ACDPlatformInfo.h"
 #include "ContextManager.h"
 #include "SignalHandler.h"
+#include "StreamHandleTable.h"
+#include "PalInitTaskGraph.h"
 #include <fstream>
 
 typedef enum {
@@ -110,6 +112,8 @@ typedef enum {
 #define AUDIO_PARAMETER_KEY_UPD_DEDICATED_BE "upd_dedicated_be"
 #define AUDIO_PARAMETER_KEY_DUAL_MONO "dual_mono"
 #define AUDIO_PARAMETER_KEY_SIGNAL_HANDLER "signal_handler"
+#define AUDIO_PARAMETER_KEY_VOLUME_RAMP_PERIOD "volume_ramp_period_ms"
+#define AUDIO_PARAMETER_KEY_MUTE_RAMP_PERIOD "mute_ramp_period_ms"
 #define MAX_PCM_NAME_SIZE 50
 #define MAX_STREAM_INSTANCES (sizeof(uint64_t) << 3)
 #define MIN_USECASE_PRIORITY 0xFFFFFFFF
@@ -215,6 +219,15 @@ struct xml_userdata {
     resource_xml_tags_t tag;
     bool inCustomConfig;
     XML_Parser parser;
+    const char *xml_file;
+    /* voice UI/ACD platform info section, see isPlatformInfoTagSkipped() */
+    int section_depth;
+    int skip_depth;
+    bool section_deferred;
+    int64_t section_offset;
+    bool deferred_pass;
+    bool deferred_buffered;
+    SoundTriggerXml *deferred_target;
 };
 
 typedef enum {
@@ -481,7 +494,7 @@ protected:
     std::vector <std::pair<std::shared_ptr<Device>, Stream*>> active_devices;
     std::vector <std::shared_ptr<Device>> plugin_devices_;
     std::vector <pal_device_id_t> avail_devices_;
-    std::map<Stream*, std::pair<uint32_t, bool>> mActiveStreamUserCounter;
+    StreamHandleTable mStreamHandles;
     bool bOverwriteFlag;
     bool screen_state_ = true;
     bool charging_state_;
@@ -567,9 +580,14 @@ protected:
     static bool lpi_logging_;
     std::map<int, std::pair<session_callback, uint64_t>> mixerEventCallbackMap;
     static std::thread mixerEventTread;
+    /* bring-up steps off the pal_init critical path, see init() */
+    PalInitTaskGraph initTasks;
+    int32_t usecaseKvTask = -1;
+    int32_t protectionDevicesTask = -1;
+    int initProtectionDevices();
     std::shared_ptr<CaptureProfile> SoundTriggerCaptureProfile;
     ResourceManager();
-    ContextManager *ctxMgr;
+    ContextManager *ctxMgr = nullptr;
     int32_t lpi_counter_;
     int32_t nlpi_counter_;
     int sleepmon_fd_;
@@ -600,6 +618,9 @@ public:
     static bool isDualMonoEnabled;
     static bool isUHQAEnabled;
     static bool isSignalHandlerEnabled;
+    /* soft pause and mute ramp periods in us, see setRampPeriodParams() */
+    static uint32_t volumeRampPeriodUs;
+    static uint32_t muteRampPeriodUs;
     /* Variable to store which speaker side is being used for call audio.
      * Valid for Stereo case only
      */
@@ -619,6 +640,7 @@ public:
     uint64_t cookie;
     int initSndMonitor();
     int initContextManager();
+    int32_t waitForInitTasks();
     void deInitContextManager();
     adm_init_t admInitFn = NULL;
     adm_deinit_t admDeInitFn = NULL;
@@ -658,9 +680,11 @@ public:
     int registerStream(Stream *s);
     int deregisterStream(Stream *s);
     int isActiveStream(pal_stream_handle_t *handle);
-    int initStreamUserCounter(Stream *s);
-    int deactivateStreamUserCounter(Stream *s);
-    int eraseStreamUserCounter(Stream *s);
+    pal_stream_handle_t* initStreamUserCounter(Stream *s);
+    int deactivateStreamUserCounter(pal_stream_handle_t *handle);
+    int eraseStreamUserCounter(pal_stream_handle_t *handle);
+    int increaseStreamUserCounter(pal_stream_handle_t *handle, Stream **s);
+    int decreaseStreamUserCounter(pal_stream_handle_t *handle);
     int increaseStreamUserCounter(Stream* s);
     int decreaseStreamUserCounter(Stream* s);
     int getStreamUserCounter(Stream *s);
@@ -691,6 +715,9 @@ public:
     static void deinit();
     static std::shared_ptr<ResourceManager> getInstance();
     static int XmlParser(std::string xmlFile);
+    static int parseDeferredXmlSection(const std::string &xmlFile, int64_t offset,
+                                       int64_t size, SoundTriggerXml *target,
+                                       bool buffer_char_data);
     static void updatePcmId(int32_t deviceId, int32_t pcmId);
     static void updateLinkName(int32_t deviceId, std::string linkName);
     static void updateSndName(int32_t deviceId, std::string sndName);
@@ -819,6 +846,12 @@ public:
     bool checkStreamMatch(Stream *target, Stream *ref);
 
     static void endTag(void *userdata __unused, const XML_Char *tag_name);
+    static bool isPlatformInfoTagSkipped(struct xml_userdata *data,
+                                         const XML_Char *tag_name, bool start);
+    static void deferredStartTag(void *userdata, const XML_Char *tag_name,
+                                 const XML_Char **attr);
+    static void deferredEndTag(void *userdata, const XML_Char *tag_name);
+    static void deferredDataHandler(void *userdata, const XML_Char *s, int len);
     static void snd_reset_data_buf(struct xml_userdata *data);
     static void snd_process_data_buf(struct xml_userdata *data, const XML_Char *tag_name);
     static void process_device_info(struct xml_userdata *data, const XML_Char *tag_name);
@@ -850,6 +883,9 @@ public:
     static int setUpdDedicatedBeEnableParam(struct str_parms *parms,char *value, int len);
     static int setDualMonoEnableParam(struct str_parms *parms,char *value, int len);
     static int setSignalHandlerEnableParam(struct str_parms *parms,char *value, int len);
+    static int setRampPeriodParams(struct str_parms *parms, char *value, int len);
+    static uint32_t getVolumeRampPeriod();
+    static uint32_t getMuteRampPeriod();
     static bool isLpiLoggingEnabled();
     static void processConfigParams(const XML_Char **attr);
     static bool isValidDevId(int deviceId);
@@ -867,6 +903,8 @@ public:
     static bool isBtScoDevice(pal_device_id_t id);
     static bool isBtDevice(pal_device_id_t id);
     int32_t a2dpSuspend();
+    void waitForMutedStreamsDrain(std::vector<std::pair<Stream *, uint32_t>> &mutedStreams,
+                                  uint32_t maxLatencyMs);
     int32_t a2dpResume();
     int32_t a2dpCaptureSuspend();
     int32_t a2dpCaptureResume();
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef STREAM_HANDLE_TABLE_H
+#define STREAM_HANDLE_TABLE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+#include "PalApi.h"
+
+class Stream;
+
+/*
+ * Client visible stream handles are encoded as (generation << slot bits | slot)
+ * so that a stale handle of a closed stream can never alias a newly opened one.
+ * The generation field is truncated to whatever is left of a pointer after the
+ * slot bits, i.e. 24 bits on 32 bit targets.
+ */
+#define STREAM_HANDLE_SLOT_BITS 8
+#define MAX_STREAM_HANDLES (1 << STREAM_HANDLE_SLOT_BITS)
+
+/*
+ * Per slot state word layout:
+ *   [63:32] generation
+ *   [31]    active, i.e. the handle accepts new users
+ *   [30:0]  number of in-flight users (pal_stream_* calls)
+ */
+#define STREAM_SLOT_ACTIVE     0x80000000ULL
+#define STREAM_SLOT_USER_MASK  0x7FFFFFFFULL
+#define STREAM_SLOT_GEN_SHIFT  32
+
+class StreamHandleTable
+{
+public:
+    StreamHandleTable();
+    ~StreamHandleTable() {};
+    pal_stream_handle_t* insert(Stream *s);
+    int erase(pal_stream_handle_t *handle);
+    bool isValid(pal_stream_handle_t *handle);
+    Stream* acquire(pal_stream_handle_t *handle);
+    int release(pal_stream_handle_t *handle);
+    int deactivate(pal_stream_handle_t *handle);
+    int getUserCount(pal_stream_handle_t *handle);
+    void dump();
+private:
+    struct StreamSlot {
+        std::atomic<uint64_t> state;
+        std::atomic<Stream *> stream;
+    };
+    StreamSlot mSlots[MAX_STREAM_HANDLES];
+    /* free slots, only touched on open and close */
+    std::vector<uint32_t> mFreeSlots;
+    std::mutex mFreeSlotsMutex;
+    /* close waits here for in-flight users to drain */
+    std::mutex mDrainMutex;
+    std::condition_variable mDrainCV;
+    StreamSlot* decode(pal_stream_handle_t *handle, uint32_t *gen);
+    static pal_stream_handle_t* encode(uint32_t slot, uint32_t gen);
+    static uint32_t genMask();
+};
+
+#endif
@@ -63,6 +63,7 @@
 #define LOG_TAG "PAL: ResourceManager"
 #include "ResourceManager.h"
 #include "Session.h"
+#include "SessionAlsaUtils.h"
 #include "Device.h"
 #include "Stream.h"
 #include "StreamPCM.h"
@@ -93,6 +94,7 @@
 #include <unistd.h>
 #include <dlfcn.h>
 #include <mutex>
+#include <chrono>
 #include <sys/ioctl.h>
 #ifdef EC_REF_CAPTURE_ENABLED
 #include "ECRefDevice.h"
@@ -173,6 +175,10 @@
 
 #define CLOCK_SRC_DEFAULT 1
 
+/* a2dp suspend drain monitor, see waitForMutedStreamsDrain() */
+#define A2DP_SUSPEND_LATENCY_MUTE_FACTOR 2
+#define A2DP_SUSPEND_DRAIN_POLL_US 5000
+
 /*this can be over written by the config file settings*/
 uint32_t pal_log_lvl = (PAL_LOG_ERR|PAL_LOG_INFO);
 
@@ -483,6 +489,8 @@ bool ResourceManager::lpi_logging_ = false;
 bool ResourceManager::isUpdDedicatedBeEnabled = false;
 int ResourceManager::max_voice_vol = -1;     /* Variable to store max volume index for voice call */
 bool ResourceManager::isSignalHandlerEnabled = false;
+uint32_t ResourceManager::volumeRampPeriodUs = VOLUME_RAMP_PERIOD;
+uint32_t ResourceManager::muteRampPeriodUs = MUTE_RAMP_PERIOD;
 bool ResourceManager::a2dp_suspended = false;
 
 //TODO:Needs to define below APIs so that functionality won't break
@@ -700,6 +708,24 @@ ResourceManager::ResourceManager()
 
     vsidInfo.loopback_delay = 0;
 
+    /*
+     * Neither needs the sound card or the resource xml, so run them while
+     * the card is discovered and the xml parsed below. Users wait for them
+     * through waitForInitTasks().
+     */
+    usecaseKvTask = initTasks.add("usecase_kv", []() {
+        int32_t status = PayloadBuilder::init();
+        if (status)
+            PAL_ERR(LOG_TAG, "Failed to parse usecase manager xml %d", status);
+        else
+            PAL_INFO(LOG_TAG, "usecase manager xml parsing successful");
+        return status;
+    });
+    initTasks.add("adm_lib", [this]() {
+        loadAdmLib();
+        return 0;
+    });
+
     ret = ResourceManager::XmlParser(SNDPARSER);
     if (ret) {
         PAL_ERR(LOG_TAG, "error in snd xml parsing ret %d", ret);
@@ -826,20 +852,15 @@ ResourceManager::ResourceManager()
     mNTStreamInstancesList[NT_PATH_ENCODE] = encodeMap;
     mNTStreamInstancesList[NT_PATH_DECODE] = decodeMap;
 
-    ResourceManager::loadAdmLib();
     ResourceManager::initWakeLocks();
-    ret = PayloadBuilder::init();
-    if (ret) {
-        throw std::runtime_error("Failed to parse usecase manager xml");
-    } else {
-        PAL_INFO(LOG_TAG, "usecase manager xml parsing successful");
-    }
 
-    PAL_DBG(LOG_TAG, "Creating ContextManager");
-    ctxMgr = new ContextManager();
-    if (!ctxMgr) {
-        throw std::runtime_error("Failed to allocate ContextManager");
+    if (isContextManagerEnabled) {
+        PAL_DBG(LOG_TAG, "Creating ContextManager");
+        ctxMgr = new ContextManager();
+        if (!ctxMgr) {
+            throw std::runtime_error("Failed to allocate ContextManager");
 
+        }
     }
 
     // init use_lpi_ flag
@@ -850,6 +871,8 @@ ResourceManager::ResourceManager()
 
 ResourceManager::~ResourceManager()
 {
+    initTasks.waitAll();
+
     streamTag.clear();
     streamPpTag.clear();
     mixerTag.clear();
@@ -1046,6 +1069,8 @@ void ResourceManager::ssrHandlingLoop(std::shared_ptr<ResourceManager> rm)
                     PAL_DBG(LOG_TAG, "eventdata %d", eventData);
                     rm->globalCb(event, &eventData, cookie);
                 }
+                /* graphs are torn down/rebuilt by ADSP, resolved MIIDs are stale */
+                SessionAlsaUtils::invalidateModuleInstanceIds();
             }
 
             if (rm->mActiveStreams.empty()) {
@@ -1070,9 +1095,7 @@ void ResourceManager::ssrHandlingLoop(std::shared_ptr<ResourceManager> rm)
                 PAL_INFO(LOG_TAG, "%d state already handled", state);
             } else if (state == CARD_STATUS_OFFLINE) {
                 for (auto str: rm->mActiveStreams) {
-                    lockValidStreamMutex();
                     ret = increaseStreamUserCounter(str);
-                    unlockValidStreamMutex();
                     if (0 != ret) {
                         PAL_ERR(LOG_TAG, "Error incrementing the stream counter for the stream handle: %pK", str);
                         continue;
@@ -1088,9 +1111,7 @@ void ResourceManager::ssrHandlingLoop(std::shared_ptr<ResourceManager> rm)
                         if (ret)
                             PAL_DBG(LOG_TAG, "Failed to unvote for stream type %d", type);
                     }
-                    lockValidStreamMutex();
                     ret = decreaseStreamUserCounter(str);
-                    unlockValidStreamMutex();
                     if (0 != ret) {
                         PAL_ERR(LOG_TAG, "Error decrementing the stream counter for the stream handle: %pK", str);
                     }
@@ -1116,9 +1137,7 @@ void ResourceManager::ssrHandlingLoop(std::shared_ptr<ResourceManager> rm)
 
                 SoundTriggerCaptureProfile = GetCaptureProfileByPriority(nullptr);
                 for (auto str: rm->mActiveStreams) {
-                    lockValidStreamMutex();
                     ret = increaseStreamUserCounter(str);
-                    unlockValidStreamMutex();
                     if (0 != ret) {
                         PAL_ERR(LOG_TAG, "Error incrementing the stream counter for the stream handle: %pK", str);
                         continue;
@@ -1128,9 +1147,7 @@ void ResourceManager::ssrHandlingLoop(std::shared_ptr<ResourceManager> rm)
                         PAL_ERR(LOG_TAG, "Ssr up handling failed for %pK ret %d",
                                           str, ret);
                     }
-                    lockValidStreamMutex();
                     ret = decreaseStreamUserCounter(str);
-                    unlockValidStreamMutex();
                     if (0 != ret) {
                         PAL_ERR(LOG_TAG, "Error decrementing the stream counter for the stream handle: %pK", str);
                     }
@@ -1314,6 +1331,12 @@ exit:
     return status;
 }
 
+/*
+ * ContextManager is driven by requests the DSP sends on its proxy stream, so
+ * there is no first use to defer it to. Its Init opens that stream itself,
+ * which leaves no later open to report a failure on, so it stays in pal_init.
+ * The stream open inside it waits for the init tasks.
+ */
 int ResourceManager::initContextManager()
 {
     int ret = 0;
@@ -1336,19 +1359,37 @@ void ResourceManager::deInitContextManager()
     }
 }
 
-int ResourceManager::init()
+int32_t ResourceManager::waitForInitTasks()
+{
+    int32_t status = 0;
+
+    /* a task declares what it needs as dependencies instead */
+    if (PalInitTaskGraph::isWorkerThread())
+        return 0;
+
+    status = initTasks.waitAll();
+    if (status != 0)
+        return status;
+
+    /*
+     * Stream and param calls only need the usecase KVs, which pal_init
+     * used to fail on. Other failures stay with the tasks that depend on
+     * them instead of failing every call.
+     */
+    status = initTasks.wait(usecaseKvTask);
+    if (status != 0)
+        PAL_ERR(LOG_TAG, "usecase KV init failed, status %d", status);
+
+    return status;
+}
+
+int ResourceManager::initProtectionDevices()
 {
     std::shared_ptr<Device> dev = nullptr;
 
     // Initialize Speaker Protection calibration mode
     struct pal_device dattr;
 
-    mixerEventTread = std::thread(mixerEventWaitThreadLoop, rm);
-
-    //Initialize audio_charger_listener
-    if (rm && isChargeConcurrencyEnabled)
-        rm->chargerListenerFeatureInit();
-
     // Get the speaker instance and activate speaker protection
     dattr.id = PAL_DEVICE_OUT_SPEAKER;
     dev = std::dynamic_pointer_cast<Device>(Device::getInstance(&dattr , rm));
@@ -1371,6 +1412,31 @@ int ResourceManager::init()
     return 0;
 }
 
+/*
+ * Only the mixer event thread is started inline, the rest is queued on
+ * initTasks so pal_init returns once the card, mixer and resource xml are
+ * ready, unless ContextManager is enabled and its Init waits for them.
+ * Protection devices build their graphs from the usecase KVs, and charger
+ * events set params on the speaker, so the three run in that order.
+ */
+int ResourceManager::init()
+{
+    mixerEventTread = std::thread(mixerEventWaitThreadLoop, rm);
+
+    rm->protectionDevicesTask = rm->initTasks.add("protection_devices", []() {
+        return rm->initProtectionDevices();
+    }, {rm->usecaseKvTask});
+
+    //Initialize audio_charger_listener
+    if (isChargeConcurrencyEnabled)
+        rm->initTasks.add("charger_listener", []() {
+            rm->chargerListenerFeatureInit();
+            return 0;
+        }, {rm->protectionDevicesTask});
+
+    return 0;
+}
+
 bool ResourceManager::isLpiLoggingEnabled()
 {
     char value[256] = {0};
@@ -1534,6 +1600,7 @@ void ResourceManager::onChargerListenerStatusChanged(int event_type, int status,
             charger_state.is_concurrent_boost_enable = concurrent_state;
             rm = ResourceManager::getInstance();
             if (rm) {
+                rm->waitForInitTasks();
                 result = rm->setParameter(PAL_PARAM_ID_CHARGER_STATE,(void*)&charger_state,
                                           sizeof(pal_param_charger_state_t));
                 if (0 != result) {
@@ -2831,129 +2898,78 @@ bool isStreamActive(T s, std::list<T> &streams)
 }
 
 int ResourceManager::isActiveStream(pal_stream_handle_t *handle) {
-    for (auto &s : mActiveStreams) {
-        if (handle == reinterpret_cast<uint64_t *>(s)) {
-            return true;
-        }
-    }
-    return false;
+    return mStreamHandles.isValid(handle);
 }
 
-int ResourceManager::initStreamUserCounter(Stream *s)
+pal_stream_handle_t* ResourceManager::initStreamUserCounter(Stream *s)
 {
-    lockValidStreamMutex();
-    mActiveStreamUserCounter.insert(std::make_pair(s, std::make_pair(0, true)));
-    s->initStreamSmph();
-    unlockValidStreamMutex();
-    return 0;
+    pal_stream_handle_t *handle = mStreamHandles.insert(s);
+
+    if (handle)
+        s->setStreamHandle(handle);
+    return handle;
 }
 
-int ResourceManager::deactivateStreamUserCounter(Stream *s)
+int ResourceManager::deactivateStreamUserCounter(pal_stream_handle_t *handle)
 {
-    std::map<Stream*, std::pair<uint32_t, bool>>::iterator it;
-    lockValidStreamMutex();
-    printStreamUserCounter(s);
-    it = mActiveStreamUserCounter.find(s);
-    if (it != mActiveStreamUserCounter.end() && it->second.second == true) {
-        PAL_DBG(LOG_TAG, "stream %p is to be deactivated.", s);
-        it->second.second = false;
-        unlockValidStreamMutex();
-        s->waitStreamSmph();
-        PAL_DBG(LOG_TAG, "stream %p is inactive.", s);
-        s->deinitStreamSmph();
-        return 0;
-    } else {
-        PAL_ERR(LOG_TAG, "stream %p is not found or inactive", s);
-        unlockValidStreamMutex();
+    printStreamUserCounter(NULL);
+    if (mStreamHandles.deactivate(handle)) {
+        PAL_ERR(LOG_TAG, "stream handle %pK is not found or inactive", handle);
         return -EINVAL;
     }
+    PAL_DBG(LOG_TAG, "stream handle %pK is inactive.", handle);
+    return 0;
 }
 
-int ResourceManager::eraseStreamUserCounter(Stream *s)
+int ResourceManager::eraseStreamUserCounter(pal_stream_handle_t *handle)
 {
-    std::map<Stream*, std::pair<uint32_t, bool>>::iterator it;
-    lockValidStreamMutex();
-    it = mActiveStreamUserCounter.find(s);
-    if (it != mActiveStreamUserCounter.end()) {
-        mActiveStreamUserCounter.erase(it);
-        PAL_DBG(LOG_TAG, "stream counter for %p is erased.", s);
-        unlockValidStreamMutex();
-        return 0;
-    } else {
-        PAL_ERR(LOG_TAG, "stream counter for %p is not found.", s);
-        unlockValidStreamMutex();
+    if (mStreamHandles.erase(handle)) {
+        PAL_ERR(LOG_TAG, "stream counter for %pK is not found.", handle);
         return -EINVAL;
     }
+    PAL_DBG(LOG_TAG, "stream counter for %pK is erased.", handle);
+    return 0;
 }
 
-int ResourceManager::increaseStreamUserCounter(Stream* s)
+int ResourceManager::increaseStreamUserCounter(pal_stream_handle_t *handle, Stream **s)
 {
-    std::map<Stream*, std::pair<uint32_t, bool>>::iterator it;
-    printStreamUserCounter(s);
-    it = mActiveStreamUserCounter.find(s);
-    if (it != mActiveStreamUserCounter.end() &&
-        it->second.second) {
-        if (0 == it->second.first) {
-            s->waitStreamSmph();
-            PAL_DBG(LOG_TAG, "stream %p in use", s);
-        }
-        PAL_DBG(LOG_TAG, "stream %p counter was %d", s, it->second.first);
-        it->second.first = it->second.first + 1;
-        PAL_DBG(LOG_TAG, "stream %p counter increased to %d", s, it->second.first);
-        return 0;
-    } else {
-        PAL_ERR(LOG_TAG, "stream %p is not found or inactive.", s);
+    *s = mStreamHandles.acquire(handle);
+    if (!(*s)) {
+        PAL_ERR(LOG_TAG, "stream handle %pK is not found or inactive.", handle);
         return -EINVAL;
     }
+    return 0;
 }
 
-int ResourceManager::decreaseStreamUserCounter(Stream* s)
+int ResourceManager::decreaseStreamUserCounter(pal_stream_handle_t *handle)
 {
-    std::map<Stream*, std::pair<uint32_t, bool>>::iterator it;
-    printStreamUserCounter(s);
-    it = mActiveStreamUserCounter.find(s);
-    if (it != mActiveStreamUserCounter.end()) {
-        PAL_DBG(LOG_TAG, "stream %p counter was %d", s, it->second.first);
-        if (0 == it->second.first) {
-            PAL_ERR(LOG_TAG, "counter of stream %p has already been 0.", s);
-            return -EINVAL;
-        }
-
-        it->second.first = it->second.first - 1;
-        if (0 == it->second.first) {
-            PAL_DBG(LOG_TAG, "stream %p not in use", s);
-            s->postStreamSmph();
-        }
-        PAL_DBG(LOG_TAG, "stream %p counter decreased to %d", s, it->second.first);
-        return 0;
-    } else {
-        PAL_ERR(LOG_TAG, "stream %p is not found.", s);
+    if (mStreamHandles.release(handle)) {
+        PAL_ERR(LOG_TAG, "stream handle %pK is not found.", handle);
         return -EINVAL;
     }
+    return 0;
 }
 
-int ResourceManager::getStreamUserCounter(Stream *s)
+int ResourceManager::increaseStreamUserCounter(Stream* s)
 {
-    std::map<Stream*, std::pair<uint32_t, bool>>::iterator it;
-    printStreamUserCounter(s);
-    it = mActiveStreamUserCounter.find(s);
-    if (it != mActiveStreamUserCounter.end()) {
-        return it->second.first;
-    } else {
-        PAL_ERR(LOG_TAG, "stream %p is not found.", s);
-        return -EINVAL;
-    }
+    Stream *str = NULL;
+
+    return increaseStreamUserCounter(s->getStreamHandle(), &str);
 }
 
-int ResourceManager::printStreamUserCounter(Stream *s)
+int ResourceManager::decreaseStreamUserCounter(Stream* s)
 {
-    std::map<Stream*, std::pair<uint32_t, bool>>::iterator it;
-    for (it = mActiveStreamUserCounter.begin();
-            it != mActiveStreamUserCounter.end(); it++) {
-        PAL_VERBOSE(LOG_TAG, "stream = %p count = %d active = %d",
-                    it->first, it->second.first, it->second.second);
-    }
+    return decreaseStreamUserCounter(s->getStreamHandle());
+}
+
+int ResourceManager::getStreamUserCounter(Stream *s)
+{
+    return mStreamHandles.getUserCount(s->getStreamHandle());
+}
 
+int ResourceManager::printStreamUserCounter(Stream *s __unused)
+{
+    mStreamHandles.dump();
     return 0;
 }
 
@@ -5705,7 +5721,10 @@ void ResourceManager::deinit()
 {
     card_status_t state = CARD_STATUS_NONE;
 
+    rm->initTasks.waitAll();
+
     mixerClosed = true;
+    SessionAlsaUtils::clearFeMixerControls();
     mixer_close(audio_virt_mixer);
     mixer_close(audio_hw_mixer);
     if (audio_route) {
@@ -6118,6 +6137,9 @@ const std::vector<int> ResourceManager::allocateFrontEndIds(const struct pal_str
 
 error:
     mListFrontEndsMutex.unlock();
+    /* resolve the FE control families up front, no-op for FE ids seen before */
+    if (!f.empty())
+        SessionAlsaUtils::resolveFeMixerControls(audio_virt_mixer, f);
     return f;
 }
 
@@ -7207,6 +7229,9 @@ int ResourceManager::setConfigParams(struct str_parms *parms)
     ret = setDualMonoEnableParam(parms, value, len);
     ret = setSignalHandlerEnableParam(parms, value, len);
 
+    /* Not checking return value as this is optional */
+    setRampPeriodParams(parms, value, len);
+
     /* Not checking return value as this is optional */
     setLpiLoggingParams(parms, value, len);
 
@@ -7348,6 +7373,49 @@ int ResourceManager::setSignalHandlerEnableParam(struct str_parms *parms,
     return ret;
 }
 
+int ResourceManager::setRampPeriodParams(struct str_parms *parms,
+                                 char *value, int len)
+{
+    int ret = -EINVAL;
+    int period = 0;
+
+    if (!value || !parms)
+        return ret;
+
+    ret = str_parms_get_str(parms, AUDIO_PARAMETER_KEY_VOLUME_RAMP_PERIOD,
+                                value, len);
+    if (ret >= 0) {
+        period = atoi(value);
+        if (period > 0)
+            volumeRampPeriodUs = period * 1000;
+        str_parms_del(parms, AUDIO_PARAMETER_KEY_VOLUME_RAMP_PERIOD);
+    }
+
+    ret = str_parms_get_str(parms, AUDIO_PARAMETER_KEY_MUTE_RAMP_PERIOD,
+                                value, len);
+    if (ret >= 0) {
+        period = atoi(value);
+        if (period > 0)
+            muteRampPeriodUs = period * 1000;
+        str_parms_del(parms, AUDIO_PARAMETER_KEY_MUTE_RAMP_PERIOD);
+    }
+
+    PAL_INFO(LOG_TAG, "volume ramp period %u us, mute ramp period %u us",
+             volumeRampPeriodUs, muteRampPeriodUs);
+
+    return ret;
+}
+
+uint32_t ResourceManager::getVolumeRampPeriod()
+{
+    return volumeRampPeriodUs;
+}
+
+uint32_t ResourceManager::getMuteRampPeriod()
+{
+    return muteRampPeriodUs;
+}
+
 int ResourceManager::setNativeAudioParams(struct str_parms *parms,
                                           char *value, int len)
 {
@@ -7486,6 +7554,112 @@ int ResourceManager::convertCharToHex(std::string num)
     return (int32_t) hexNum;
 }
 
+static uint64_t palTimeUs(const struct pal_time_us *t)
+{
+    return ((uint64_t)t->value_msw << 32) | t->value_lsw;
+}
+
+/*
+ * Sample the SPR session time of a started stream, with mActiveStreamMutex
+ * held. Stop and close tear the session down under the stream mutex before
+ * the stream leaves mActiveStreams, so the sample is taken under it too.
+ * Returns false once the stream is no longer started.
+ */
+static bool sampleStreamSessionTime(Stream *s, bool *clocked, uint64_t *sessUs)
+{
+    struct pal_session_time stime;
+    Session *session = nullptr;
+    bool started = false;
+
+    *clocked = false;
+    s->lockStreamMutex();
+    started = s->isActive();
+    if (started) {
+        memset(&stime, 0, sizeof(stime));
+        s->getAssociatedSession(&session);
+        if (session && !session->getTimestamp(&stime)) {
+            *sessUs = palTimeUs(&stime.session_time);
+            *clocked = true;
+        }
+    }
+    s->unlockStreamMutex();
+
+    return started;
+}
+
+/*
+ * Block until each muted stream has rendered one pipeline latency worth of
+ * audio past the mute point, going by the SPR session time of its session,
+ * i.e. until the unmuted data queued ahead of the volume module is out.
+ * Streams whose session exposes no clock (no SPR in the graph, or the time
+ * does not move) are bounded by latency * A2DP_SUSPEND_LATENCY_MUTE_FACTOR,
+ * which is what every stream used to sleep for unconditionally.
+ */
+void ResourceManager::waitForMutedStreamsDrain(
+        std::vector<std::pair<Stream *, uint32_t>> &mutedStreams,
+        uint32_t maxLatencyMs)
+{
+    struct drainState {
+        Stream *s;
+        uint64_t targetUs;
+        uint64_t startUs;
+        bool clocked;
+        bool done;
+    };
+    std::vector<drainState> pending;
+    uint64_t sessUs = 0;
+    bool clocked = false;
+    bool waiting = false;
+    uint64_t elapsedUs = 0;
+    uint64_t boundUs = (uint64_t)maxLatencyMs * 1000 * A2DP_SUSPEND_LATENCY_MUTE_FACTOR;
+    auto begin = std::chrono::steady_clock::now();
+
+    mActiveStreamMutex.lock();
+    for (auto &ms : mutedStreams) {
+        drainState st = {ms.first, (uint64_t)ms.second * 1000, 0, false, false};
+
+        if (!isStreamActive(ms.first, mActiveStreams) ||
+            !sampleStreamSessionTime(ms.first, &st.clocked, &st.startUs))
+            continue;
+        pending.push_back(st);
+    }
+    mActiveStreamMutex.unlock();
+
+    do {
+        elapsedUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - begin).count();
+        if (elapsedUs >= boundUs)
+            break;
+
+        waiting = false;
+        mActiveStreamMutex.lock();
+        for (auto &st : pending) {
+            if (st.done)
+                continue;
+            if (!isStreamActive(st.s, mActiveStreams) ||
+                elapsedUs >= st.targetUs * A2DP_SUSPEND_LATENCY_MUTE_FACTOR) {
+                st.done = true;
+                continue;
+            }
+            if (st.clocked) {
+                if (!sampleStreamSessionTime(st.s, &clocked, &sessUs) ||
+                    (clocked && sessUs >= st.startUs + st.targetUs)) {
+                    st.done = true;
+                    continue;
+                }
+            }
+            waiting = true;
+        }
+        mActiveStreamMutex.unlock();
+
+        if (waiting)
+            usleep(A2DP_SUSPEND_DRAIN_POLL_US);
+    } while (waiting);
+
+    PAL_INFO(LOG_TAG, "muted streams drained in %llu us, bound %llu us",
+             (unsigned long long)elapsedUs, (unsigned long long)boundUs);
+}
+
 int32_t ResourceManager::a2dpSuspend()
 {
     int status = 0;
@@ -7501,6 +7675,7 @@ int32_t ResourceManager::a2dpSuspend()
     std::vector <Stream *> activeStreams;
     std::vector <Stream*>::iterator sIter;
     std::vector <std::shared_ptr<Device>> associatedDevices;
+    std::vector <std::pair<Stream *, uint32_t>> mutedStreams;
 
     PAL_DBG(LOG_TAG, "enter");
 
@@ -7615,8 +7790,10 @@ int32_t ResourceManager::a2dpSuspend()
                     if (maxLatencyMs < latencyMs)
                         maxLatencyMs = latencyMs;
                     // Mute
-                    if (!(*sIter)->mute_l(true))
+                    if (!(*sIter)->mute_l(true)) {
                         (*sIter)->a2dpMuted = true;
+                        mutedStreams.push_back(std::make_pair(*sIter, latencyMs));
+                    }
                 }
             }
             (*sIter)->unlockStreamMutex();
@@ -7626,12 +7803,8 @@ int32_t ResourceManager::a2dpSuspend()
     mActiveStreamMutex.unlock();
 
     // wait for stale pcm drained before switching to speaker
-    if (maxLatencyMs > 0) {
-        // multiplication factor applied to latency when calculating a safe mute delay
-        // TODO: It's not needed if latency is accurate.
-        const int latencyMuteFactor = 2;
-        usleep(maxLatencyMs * 1000 * latencyMuteFactor);
-    }
+    if (maxLatencyMs > 0)
+        waitForMutedStreamsDrain(mutedStreams, maxLatencyMs);
 
     forceDeviceSwitch(a2dpDev, &switchDevDattr, activeA2dpStreams);
 
@@ -10582,6 +10755,12 @@ void ResourceManager::startTag(void *userdata, const XML_Char *tag_name,
     static std::shared_ptr<SoundTriggerPlatformInfo> st_info = nullptr;
     static std::shared_ptr<ACDPlatformInfo> acd_info = nullptr;
 
+    if ((data->is_parsing_sound_trigger || data->is_parsing_acd) &&
+        isPlatformInfoTagSkipped(data, tag_name, true)) {
+        snd_reset_data_buf(data);
+        return;
+    }
+
     if (data->is_parsing_sound_trigger) {
         if (st_info)
            st_info->HandleStartTag((const char *)tag_name, (const char **)attr);
@@ -10602,12 +10781,18 @@ void ResourceManager::startTag(void *userdata, const XML_Char *tag_name,
 
     if (!strcmp(tag_name, "sound_trigger_platform_info")) {
         data->is_parsing_sound_trigger = true;
+        data->section_depth = 0;
+        data->section_deferred = false;
+        data->section_offset = XML_GetCurrentByteIndex(data->parser);
         st_info = SoundTriggerPlatformInfo::GetInstance();
         return;
     }
 
     if (!strcmp(tag_name, "acd_platform_info")) {
         data->is_parsing_acd = true;
+        data->section_depth = 0;
+        data->section_deferred = false;
+        data->section_offset = XML_GetCurrentByteIndex(data->parser);
         acd_info = ACDPlatformInfo::GetInstance();
         return;
     }
@@ -10719,27 +10904,42 @@ void ResourceManager::startTag(void *userdata, const XML_Char *tag_name,
 void ResourceManager::endTag(void *userdata, const XML_Char *tag_name)
 {
     struct xml_userdata *data = (struct xml_userdata *)userdata;
-    std::shared_ptr<SoundTriggerPlatformInfo> st_info =
-        SoundTriggerPlatformInfo::GetInstance();
-    std::shared_ptr<ACDPlatformInfo> acd_info = ACDPlatformInfo::GetInstance();
+    int64_t section_size = 0;
 
     if (!strcmp(tag_name, "sound_trigger_platform_info")) {
         data->is_parsing_sound_trigger = false;
+        section_size = XML_GetCurrentByteIndex(data->parser) +
+            XML_GetCurrentByteCount(data->parser) - data->section_offset;
+        if (data->section_deferred)
+            SoundTriggerPlatformInfo::GetInstance()->SetDeferredConfig(
+                data->xml_file, data->section_offset, section_size);
         return;
     }
 
-    if (data->is_parsing_sound_trigger) {
-        st_info->HandleEndTag(data, (const char *)tag_name);
+    if (!strcmp(tag_name, "acd_platform_info")) {
+        data->is_parsing_acd = false;
+        section_size = XML_GetCurrentByteIndex(data->parser) +
+            XML_GetCurrentByteCount(data->parser) - data->section_offset;
+        if (data->section_deferred)
+            ACDPlatformInfo::GetInstance()->SetDeferredConfig(
+                data->xml_file, data->section_offset, section_size);
         return;
     }
 
-    if (!strcmp(tag_name, "acd_platform_info")) {
-        data->is_parsing_acd = false;
+    if ((data->is_parsing_sound_trigger || data->is_parsing_acd) &&
+        isPlatformInfoTagSkipped(data, tag_name, false)) {
+        snd_reset_data_buf(data);
+        return;
+    }
+
+    if (data->is_parsing_sound_trigger) {
+        SoundTriggerPlatformInfo::GetInstance()->HandleEndTag(data,
+            (const char *)tag_name);
         return;
     }
 
     if (data->is_parsing_acd) {
-        acd_info->HandleEndTag(data, (const char *)tag_name);
+        ACDPlatformInfo::GetInstance()->HandleEndTag(data, (const char *)tag_name);
         snd_reset_data_buf(data);
         return;
     }
@@ -10778,8 +10978,9 @@ void ResourceManager::snd_data_handler(void *userdata, const XML_Char *s, int le
    struct xml_userdata *data = (struct xml_userdata *)userdata;
 
     if (data->is_parsing_sound_trigger) {
-        SoundTriggerPlatformInfo::GetInstance()->HandleCharData(
-            (const char *)s);
+        if (!data->skip_depth)
+            SoundTriggerPlatformInfo::GetInstance()->HandleCharData(
+                (const char *)s);
         return;
     }
 
@@ -10819,6 +11020,7 @@ int ResourceManager::XmlParser(std::string xmlFile)
     }
 
     data.parser = parser;
+    data.xml_file = xmlFile.c_str();
     XML_SetUserData(parser, &data);
     XML_SetElementHandler(parser, startTag, endTag);
     XML_SetCharacterDataHandler(parser, snd_data_handler);
@@ -10855,6 +11057,164 @@ done:
     return ret;
 }
 
+/*
+ * Split of the voice UI/ACD platform info sections between the resource xml
+ * pass and the deferred pass. The common params (direct <param> children and
+ * <common_config>) are needed by concurrency handling for every stream and
+ * are parsed with the resource xml; the remaining subtrees only matter once
+ * a voice UI/ACD stream exists and are parsed by parseDeferredXmlSection().
+ * Returns true when tag_name is inside a subtree the current pass skips.
+ */
+bool ResourceManager::isPlatformInfoTagSkipped(struct xml_userdata *data,
+    const XML_Char *tag_name, bool start)
+{
+    bool common = false;
+    bool skip = false;
+
+    if (start) {
+        data->section_depth++;
+        /* section root, only seen by the deferred pass */
+        if (data->section_depth == 0)
+            return true;
+        if (!data->skip_depth && data->section_depth == 1) {
+            common = !strcmp(tag_name, "param") ||
+                     !strcmp(tag_name, "common_config");
+            if (common == data->deferred_pass)
+                data->skip_depth = data->section_depth;
+            if (!common)
+                data->section_deferred = true;
+        }
+        return data->skip_depth != 0;
+    }
+
+    if (data->section_depth == 0) {
+        data->section_depth--;
+        return true;
+    }
+    skip = data->skip_depth != 0;
+    if (data->skip_depth == data->section_depth)
+        data->skip_depth = 0;
+    data->section_depth--;
+
+    return skip;
+}
+
+void ResourceManager::deferredStartTag(void *userdata, const XML_Char *tag_name,
+    const XML_Char **attr)
+{
+    struct xml_userdata *data = (struct xml_userdata *)userdata;
+
+    if (isPlatformInfoTagSkipped(data, tag_name, true))
+        return;
+
+    data->deferred_target->HandleStartTag((const char *)tag_name,
+        (const char **)attr);
+    if (data->deferred_buffered)
+        snd_reset_data_buf(data);
+}
+
+void ResourceManager::deferredEndTag(void *userdata, const XML_Char *tag_name)
+{
+    struct xml_userdata *data = (struct xml_userdata *)userdata;
+
+    if (isPlatformInfoTagSkipped(data, tag_name, false))
+        return;
+
+    data->deferred_target->HandleEndTag(data, (const char *)tag_name);
+    if (data->deferred_buffered)
+        snd_reset_data_buf(data);
+}
+
+void ResourceManager::deferredDataHandler(void *userdata, const XML_Char *s, int len)
+{
+    struct xml_userdata *data = (struct xml_userdata *)userdata;
+
+    if (data->skip_depth || data->section_depth <= 0)
+        return;
+
+    if (data->deferred_buffered)
+        snd_data_handler(userdata, s, len);
+    else
+        data->deferred_target->HandleCharData((const char *)s);
+}
+
+int ResourceManager::parseDeferredXmlSection(const std::string &xmlFile,
+    int64_t offset, int64_t size, SoundTriggerXml *target, bool buffer_char_data)
+{
+    XML_Parser parser;
+    FILE *file = NULL;
+    int ret = 0;
+    void *buf = NULL;
+    struct xml_userdata data;
+    memset(&data, 0, sizeof(data));
+
+    if (!target || offset < 0 || size <= 0) {
+        PAL_ERR(LOG_TAG, "invalid section %lld+%lld", (long long)offset,
+                (long long)size);
+        return -EINVAL;
+    }
+
+    PAL_INFO(LOG_TAG, "deferred XML parsing started - file name %s, offset %lld",
+             xmlFile.c_str(), (long long)offset);
+    file = fopen(xmlFile.c_str(), "r");
+    if (!file) {
+        ret = -EINVAL;
+        PAL_ERR(LOG_TAG, "Failed to open xml file name %s ret %d", xmlFile.c_str(), ret);
+        goto done;
+    }
+
+    if (fseeko(file, (off_t)offset, SEEK_SET)) {
+        ret = -EIO;
+        PAL_ERR(LOG_TAG, "Failed to seek xml file name %s ret %d", xmlFile.c_str(), ret);
+        goto closeFile;
+    }
+
+    parser = XML_ParserCreate(NULL);
+    if (!parser) {
+        ret = -EINVAL;
+        PAL_ERR(LOG_TAG, "Failed to create XML ret %d", ret);
+        goto closeFile;
+    }
+
+    data.parser = parser;
+    data.xml_file = xmlFile.c_str();
+    /* root start tag brings this to 0 */
+    data.section_depth = -1;
+    data.deferred_pass = true;
+    data.deferred_buffered = buffer_char_data;
+    data.deferred_target = target;
+    XML_SetUserData(parser, &data);
+    XML_SetElementHandler(parser, deferredStartTag, deferredEndTag);
+    XML_SetCharacterDataHandler(parser, deferredDataHandler);
+
+    buf = XML_GetBuffer(parser, size);
+    if (buf == NULL) {
+        ret = -EINVAL;
+        PAL_ERR(LOG_TAG, "XML_Getbuffer failed ret %d", ret);
+        goto freeParser;
+    }
+
+    if (fread(buf, 1, size, file) != (size_t)size) {
+        ret = -EIO;
+        PAL_ERR(LOG_TAG, "short read of %s section ret %d", xmlFile.c_str(), ret);
+        goto freeParser;
+    }
+
+    if (XML_ParseBuffer(parser, size, 1) == XML_STATUS_ERROR) {
+        ret = -EINVAL;
+        PAL_ERR(LOG_TAG, "XML ParseBuffer failed for %s section ret %d",
+                xmlFile.c_str(), ret);
+        goto freeParser;
+    }
+
+freeParser:
+    XML_ParserFree(parser);
+closeFile:
+    fclose(file);
+done:
+    return ret;
+}
+
 /* Function to get audio vendor configs path */
 void ResourceManager::getVendorConfigPath (char* config_file_path, int path_size)
 {
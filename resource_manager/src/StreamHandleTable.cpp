@@ -0,0 +1,263 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define LOG_TAG "PAL: StreamHandleTable"
+
+#include <errno.h>
+#include <stdint.h>
+#include "StreamHandleTable.h"
+#include "PalCommon.h"
+
+StreamHandleTable::StreamHandleTable()
+{
+    mFreeSlots.reserve(MAX_STREAM_HANDLES);
+    for (int i = MAX_STREAM_HANDLES - 1; i >= 0; i--) {
+        /* generation 0 is never handed out so that a handle is never NULL */
+        mSlots[i].state.store((uint64_t)1 << STREAM_SLOT_GEN_SHIFT);
+        mSlots[i].stream.store(nullptr);
+        mFreeSlots.push_back(i);
+    }
+}
+
+uint32_t StreamHandleTable::genMask()
+{
+    return (uint32_t)(UINTPTR_MAX >> STREAM_HANDLE_SLOT_BITS);
+}
+
+pal_stream_handle_t* StreamHandleTable::encode(uint32_t slot, uint32_t gen)
+{
+    uintptr_t val = ((uintptr_t)(gen & genMask()) << STREAM_HANDLE_SLOT_BITS) | slot;
+
+    return reinterpret_cast<pal_stream_handle_t *>(val);
+}
+
+StreamHandleTable::StreamSlot* StreamHandleTable::decode(pal_stream_handle_t *handle,
+                                                         uint32_t *gen)
+{
+    uintptr_t val = reinterpret_cast<uintptr_t>(handle);
+
+    *gen = (uint32_t)(val >> STREAM_HANDLE_SLOT_BITS);
+    if (!handle || *gen == 0)
+        return nullptr;
+
+    return &mSlots[val & (MAX_STREAM_HANDLES - 1)];
+}
+
+static inline uint32_t slotGen(uint64_t state)
+{
+    return (uint32_t)(state >> STREAM_SLOT_GEN_SHIFT);
+}
+
+pal_stream_handle_t* StreamHandleTable::insert(Stream *s)
+{
+    uint32_t idx;
+    uint32_t gen;
+    uint64_t state;
+
+    mFreeSlotsMutex.lock();
+    if (mFreeSlots.empty()) {
+        mFreeSlotsMutex.unlock();
+        PAL_ERR(LOG_TAG, "no free stream handle for stream %pK", s);
+        return nullptr;
+    }
+    idx = mFreeSlots.back();
+    mFreeSlots.pop_back();
+    mFreeSlotsMutex.unlock();
+
+    state = mSlots[idx].state.load(std::memory_order_relaxed);
+    gen = slotGen(state);
+    mSlots[idx].stream.store(s, std::memory_order_relaxed);
+    /* release: the stream pointer is visible before the handle validates */
+    mSlots[idx].state.store(((uint64_t)gen << STREAM_SLOT_GEN_SHIFT) | STREAM_SLOT_ACTIVE,
+                            std::memory_order_release);
+
+    PAL_DBG(LOG_TAG, "stream %pK slot %u gen %u", s, idx, gen);
+    return encode(idx, gen);
+}
+
+int StreamHandleTable::erase(pal_stream_handle_t *handle)
+{
+    StreamSlot *slot = nullptr;
+    uint32_t gen = 0;
+    uint32_t next = 0;
+    uint64_t state;
+
+    slot = decode(handle, &gen);
+    if (!slot)
+        return -EINVAL;
+
+    state = slot->state.load(std::memory_order_acquire);
+    if ((slotGen(state) & genMask()) != gen ||
+        (state & (STREAM_SLOT_ACTIVE | STREAM_SLOT_USER_MASK))) {
+        PAL_ERR(LOG_TAG, "handle %pK is stale or still in use, state 0x%llx",
+                handle, (unsigned long long)state);
+        return -EINVAL;
+    }
+
+    /* bump generation so that stale copies of this handle stop validating */
+    next = slotGen(state) + 1;
+    if ((next & genMask()) == 0)
+        next = 1;
+    slot->state.store((uint64_t)next << STREAM_SLOT_GEN_SHIFT, std::memory_order_release);
+    slot->stream.store(nullptr, std::memory_order_relaxed);
+
+    mFreeSlotsMutex.lock();
+    mFreeSlots.push_back((uint32_t)(slot - mSlots));
+    mFreeSlotsMutex.unlock();
+    return 0;
+}
+
+bool StreamHandleTable::isValid(pal_stream_handle_t *handle)
+{
+    StreamSlot *slot = nullptr;
+    uint32_t gen = 0;
+    uint64_t state;
+
+    slot = decode(handle, &gen);
+    if (!slot)
+        return false;
+
+    state = slot->state.load(std::memory_order_acquire);
+    return ((slotGen(state) & genMask()) == gen) && (state & STREAM_SLOT_ACTIVE);
+}
+
+Stream* StreamHandleTable::acquire(pal_stream_handle_t *handle)
+{
+    StreamSlot *slot = nullptr;
+    uint32_t gen = 0;
+    uint64_t state;
+
+    slot = decode(handle, &gen);
+    if (!slot)
+        return nullptr;
+
+    state = slot->state.load(std::memory_order_acquire);
+    do {
+        if ((slotGen(state) & genMask()) != gen || !(state & STREAM_SLOT_ACTIVE))
+            return nullptr;
+        if ((state & STREAM_SLOT_USER_MASK) == STREAM_SLOT_USER_MASK)
+            return nullptr;
+    } while (!slot->state.compare_exchange_weak(state, state + 1,
+                                                std::memory_order_acq_rel,
+                                                std::memory_order_acquire));
+
+    return slot->stream.load(std::memory_order_relaxed);
+}
+
+int StreamHandleTable::release(pal_stream_handle_t *handle)
+{
+    StreamSlot *slot = nullptr;
+    uint32_t gen = 0;
+    uint64_t state;
+
+    slot = decode(handle, &gen);
+    if (!slot)
+        return -EINVAL;
+
+    state = slot->state.load(std::memory_order_relaxed);
+    do {
+        if ((slotGen(state) & genMask()) != gen || !(state & STREAM_SLOT_USER_MASK)) {
+            PAL_ERR(LOG_TAG, "handle %pK has no user to release", handle);
+            return -EINVAL;
+        }
+    } while (!slot->state.compare_exchange_weak(state, state - 1,
+                                                std::memory_order_acq_rel,
+                                                std::memory_order_relaxed));
+
+    /* last user of a closing stream wakes up the closer */
+    if ((state & STREAM_SLOT_USER_MASK) == 1 && !(state & STREAM_SLOT_ACTIVE)) {
+        std::lock_guard<std::mutex> lck(mDrainMutex);
+        mDrainCV.notify_all();
+    }
+    return 0;
+}
+
+int StreamHandleTable::deactivate(pal_stream_handle_t *handle)
+{
+    StreamSlot *slot = nullptr;
+    uint32_t gen = 0;
+    uint64_t state;
+
+    slot = decode(handle, &gen);
+    if (!slot)
+        return -EINVAL;
+
+    state = slot->state.load(std::memory_order_acquire);
+    do {
+        if ((slotGen(state) & genMask()) != gen || !(state & STREAM_SLOT_ACTIVE))
+            return -EINVAL;
+    } while (!slot->state.compare_exchange_weak(state, state & ~STREAM_SLOT_ACTIVE,
+                                                std::memory_order_acq_rel,
+                                                std::memory_order_acquire));
+
+    PAL_DBG(LOG_TAG, "handle %pK deactivated, %llu users in flight", handle,
+            (unsigned long long)(state & STREAM_SLOT_USER_MASK));
+    std::unique_lock<std::mutex> lck(mDrainMutex);
+    mDrainCV.wait(lck, [slot] {
+        return !(slot->state.load(std::memory_order_acquire) & STREAM_SLOT_USER_MASK);
+    });
+    return 0;
+}
+
+int StreamHandleTable::getUserCount(pal_stream_handle_t *handle)
+{
+    StreamSlot *slot = nullptr;
+    uint32_t gen = 0;
+    uint64_t state;
+
+    slot = decode(handle, &gen);
+    if (!slot)
+        return -EINVAL;
+
+    state = slot->state.load(std::memory_order_acquire);
+    if ((slotGen(state) & genMask()) != gen)
+        return -EINVAL;
+
+    return (int)(state & STREAM_SLOT_USER_MASK);
+}
+
+void StreamHandleTable::dump()
+{
+    uint64_t state;
+
+    for (uint32_t i = 0; i < MAX_STREAM_HANDLES; i++) {
+        state = mSlots[i].state.load(std::memory_order_relaxed);
+        if (!(state & (STREAM_SLOT_ACTIVE | STREAM_SLOT_USER_MASK)))
+            continue;
+        PAL_VERBOSE(LOG_TAG, "slot %u stream = %p count = %llu active = %d", i,
+                    mSlots[i].stream.load(std::memory_order_relaxed),
+                    (unsigned long long)(state & STREAM_SLOT_USER_MASK),
+                    !!(state & STREAM_SLOT_ACTIVE));
+    }
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PAYLOAD_ARENA_H
+#define PAYLOAD_ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <mutex>
+#include <vector>
+
+/*
+ * Size classes are powers of two from 64 bytes to 4 KB, which covers the
+ * apm_module_param_data_t based payloads set on every volume/MFC/RAT update.
+ * Anything bigger goes straight to the heap.
+ */
+#define PAYLOAD_ARENA_MIN_SHIFT        6
+#define PAYLOAD_ARENA_MAX_SHIFT        12
+#define PAYLOAD_ARENA_NUM_CLASSES      (PAYLOAD_ARENA_MAX_SHIFT - PAYLOAD_ARENA_MIN_SHIFT + 1)
+#define PAYLOAD_ARENA_BLOCKS_PER_CLASS 8
+
+struct payloadArenaStats {
+    uint64_t allocs;       /* total alloc() calls */
+    uint64_t poolHits;     /* served from a freelist */
+    uint64_t heapAllocs;   /* served by malloc */
+    uint64_t releases;     /* total release() calls */
+    uint64_t heapFrees;    /* released blocks that went back to the heap */
+    uint32_t pooledBlocks; /* blocks currently parked in the freelists */
+};
+
+/*
+ * Per session freelist of payload blocks. Blocks are plain malloc() memory
+ * without any header, so a block that never makes it back to release() can
+ * still be given to free() by legacy callers.
+ */
+class PayloadArena
+{
+public:
+    PayloadArena();
+    ~PayloadArena();
+    uint8_t* alloc(size_t size);
+    void release(uint8_t *ptr, size_t size);
+    void getStats(struct payloadArenaStats *stats);
+    void dumpStats(const char *owner);
+private:
+    static int sizeClass(size_t size);
+    std::vector<uint8_t *> mFreeBlocks[PAYLOAD_ARENA_NUM_CLASSES];
+    struct payloadArenaStats mStats;
+    std::mutex mLock;
+};
+
+#endif
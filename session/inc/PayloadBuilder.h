@@ -41,14 +41,19 @@
 #include <set>
 #include <algorithm>
 #include <expat.h>
+#include <list>
 #include <map>
+#include <mutex>
 #include <regex>
 #include <sstream>
+#include <unordered_map>
 #include "Stream.h"
 #include "Device.h"
 #include "ResourceManager.h"
+#include "PayloadArena.h"
 
 #define PAL_ALIGN_8BYTE(x) (((x) + 7) & (~7))
+#define GRAPH_KV_CACHE_MAX_ENTRIES 64
 #define PAL_PADDING_8BYTE_ALIGN(x)  ((((x) + 7) & 7) ^ 7)
 
 #define MSM_MI2S_SD0 (1 << 0)
@@ -148,6 +153,27 @@ struct allKVs {
     std::vector<kvInfo> keys_values;
 };
 
+/* canonical lookup key: table, stream type/dev id and sorted interned selectors */
+struct kvIndexKey {
+    const std::vector<allKVs> *table;
+    uint32_t type;
+    std::vector<std::pair<selector_type_t, uint32_t>> selectors;
+
+    bool operator==(const kvIndexKey &other) const {
+        return table == other.table && type == other.type &&
+               selectors == other.selectors;
+    }
+};
+
+struct kvIndexKeyHash {
+    size_t operator()(const kvIndexKey &key) const {
+        size_t h = std::hash<const void *>()(key.table) ^ (key.type * 0x9e3779b9U);
+        for (auto &sel : key.selectors)
+            h = (h * 31) ^ ((size_t)sel.first << 24) ^ sel.second;
+        return h;
+    }
+};
+
 typedef enum {
     TAG_USECASEXML_ROOT,
     TAG_STREAM_SEL,
@@ -181,8 +207,41 @@ protected:
    static std::vector<allKVs> all_streampps;
    static std::vector<allKVs> all_devices;
    static std::vector<allKVs> all_devicepps;
+   /* matching kvInfo per key, first match of each <stream>/<device> block in xml order */
+   static std::unordered_map<kvIndexKey, std::vector<const kvInfo *>, kvIndexKeyHash> kvIndex;
+   /* <table, type, selector types> combinations already present in kvIndex */
+   static std::set<std::tuple<const std::vector<allKVs> *, uint32_t,
+                              std::vector<selector_type_t>>> kvIndexedSets;
+   static std::unordered_map<std::string, uint32_t> selectorValueIds;
+   static std::mutex kvIndexMutex;
+   static void indexKVs(std::vector<allKVs> &any_type, uint32_t type,
+                        const std::vector<selector_type_t> &selTypes);
+   static void buildKVIndex();
+   /* LRU of resolved graph KVs, keyed on the inputs getSelectorValues() reads */
+   struct kvCacheEntry {
+       int status;
+       std::vector<std::pair<int, int>> kvs;
+   };
+   static std::list<std::pair<std::string, kvCacheEntry>> kvCacheLru;
+   static std::unordered_map<std::string,
+       std::list<std::pair<std::string, kvCacheEntry>>::iterator> kvCacheMap;
+   static std::map<std::pair<const std::vector<allKVs> *, uint32_t>,
+       std::vector<std::string>> kvCacheSelectors;
+   static std::mutex kvCacheMutex;
+   static bool getSelectorCacheKey(std::vector<std::string> &selector_names,
+       Stream *s, struct pal_device *dAttr, std::string &key);
+   static int resolveKVs(uint32_t type, std::vector<allKVs> &any_type, Stream *s,
+       struct pal_device *dAttr, std::vector<std::pair<int, int>> &keyVector);
+   /* binary snapshot of the usecase KV tables, see loadKVSnapshot() */
+   static int loadKVSnapshot(const char *xmlFile);
+   static void storeKVSnapshot(const char *xmlFile);
+   /* backs the module payloads built by this instance, see allocPayload() */
+   PayloadArena payloadArena;
 
 public:
+    uint8_t* allocPayload(size_t size);
+    void releasePayload(uint8_t **payload, size_t *size);
+    void getPayloadArenaStats(struct payloadArenaStats *stats);
     void payloadUsbAudioConfig(uint8_t** payload, size_t* size,
                            uint32_t miid,
                            struct usbAudioConfig *data);
@@ -262,7 +321,7 @@ public:
     int populateStreamCkv(Stream *s, std::vector <std::pair<int,int>> &keyVector, int tag, struct pal_volume_data **);
     int populateCalKeyVector(Stream *s, std::vector <std::pair<int,int>> &ckv, int tag);
     int populateTagKeyVector(Stream *s, std::vector <std::pair<int,int>> &tkv, int tag, uint32_t* gsltag);
-    void payloadTimestamp(std::shared_ptr<std::vector<uint8_t>>& module_payload, size_t *size, uint32_t moduleId);
+    static void payloadTimestamp(std::shared_ptr<std::vector<uint8_t>>& module_payload, size_t *size, uint32_t moduleId);
     static int init();
     static void endTag(void *userdata, const XML_Char *tag_name);
     static void startTag(void *userdata, const XML_Char *tag_name, const XML_Char **attr);
@@ -277,8 +336,6 @@ public:
         std::vector<allKVs> &any_type);
     static std::vector <std::pair<selector_type_t, std::string>> getSelectorValues(
         std::vector<std::string> &selectors, Stream* s, struct pal_device* dAttr);
-    static bool compareSelectorPairs(std::vector <std::pair<selector_type_t, std::string>>
-        &selector_val, std::vector<std::pair<selector_type_t, std::string>> &filled_selector_pairs);
     static int retrieveKVs(std::vector<std::pair<selector_type_t, std::string>>
         &filled_selector_pairs, uint32_t type, std::vector<allKVs> &any_type,
         std::vector<std::pair<int32_t, int32_t>> &keyVector);
@@ -45,6 +45,7 @@
 #include <errno.h>
 #include "PalCommon.h"
 #include "Device.h"
+#include "PalTimestampClock.h"
 
 
 
@@ -99,6 +100,12 @@ protected:
     static int extECRefCnt;
     static std::mutex extECMutex;
     bool frontEndIdAllocated = false;
+    /* module param blocks collected between beginParamBatch and commitParamBatch */
+    std::vector<uint8_t> paramBatch;
+    uint32_t paramBatchCount = 0;
+    bool paramBatchOpen = false;
+    /* extrapolated SPR session time served to getTimestamp */
+    PalTimestampClock tsClock;
 public:
     bool isMixerEventCbRegd;
     bool isPauseRegistrationDone;
@@ -115,6 +122,10 @@ public:
     void setPmQosMixerCtl(pmQosVote vote);
     int getCustomPayload(uint8_t **payload, size_t *payloadSize);
     int freeCustomPayload();
+    int beginParamBatch();
+    int addParamToBatch(void *payload, size_t size);
+    int commitParamBatch(struct mixer *mixer, int device);
+    void abortParamBatch();
     virtual int open(Stream * s) = 0;
     virtual int prepare(Stream * s) = 0;
     virtual int setConfig(Stream * s, configType type, int tag) = 0;
@@ -133,6 +144,8 @@ public:
     virtual int writeBufferInit(Stream *s __unused, size_t noOfBuf __unused, size_t bufSize __unused, int flag __unused) {return 0;};
     virtual int read(Stream *s __unused, int tag __unused, struct pal_buffer *buf __unused, int * size __unused) {return 0;};
     virtual int write(Stream *s __unused, int tag __unused, struct pal_buffer *buf __unused, int * size __unused, int flag __unused) {return 0;};
+    virtual int readv(Stream *s __unused, int tag __unused, const struct pal_iovec *iov __unused, uint32_t iovcnt __unused, int * size __unused) {return -ENOSYS;};
+    virtual int writev(Stream *s __unused, int tag __unused, const struct pal_iovec *iov __unused, uint32_t iovcnt __unused, int * size __unused, int flag __unused) {return -ENOSYS;};
     virtual int getParameters(Stream *s __unused, int tagId __unused, uint32_t param_id __unused, void **payload __unused) {return 0;};
     virtual int setParameters(Stream *s __unused, int tagId __unused, uint32_t param_id __unused, void *payload __unused) {return 0;};
     virtual int registerCallBack(session_callback cb __unused, uint64_t cookie __unused) {return 0;};
@@ -140,6 +153,8 @@ public:
     virtual int flush() {return 0;};
     virtual void setEventPayload(uint32_t event_id __unused, void *payload __unused, size_t payload_size __unused) {  };
     virtual int getTimestamp(struct pal_session_time *stime __unused) {return 0;};
+    /* lock-free extrapolated time, -EAGAIN when getTimestamp must sample */
+    int getExtrapolatedTimestamp(struct pal_session_time *stime) {return tsClock.read(stime);};
     /*TODO need to implement connect/disconnect in basecase*/
     virtual int setupSessionDevice(Stream* streamHandle, pal_stream_type_t streamType,
         std::shared_ptr<Device> deviceToCconnect) = 0;
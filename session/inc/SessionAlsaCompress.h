@@ -46,6 +46,8 @@
 #include <tinycompress/tinycompress.h>
 
 #define EARLY_EOS_DELAY_MS 150
+/* pending offload commands, WAIT_FOR_BUFFER is coalesced to one entry */
+#define OFFLOAD_MSG_QUEUE_SIZE 8
 
 class Stream;
 class Session;
@@ -77,7 +79,7 @@ enum {
 #endif
 
 struct offload_msg {
-    offload_msg(int c)
+    offload_msg(int c = OFFLOAD_CMD_EXIT)
         :cmd(c) {}
     int cmd; /**< command */
 };
@@ -93,7 +95,12 @@ private:
     //  unsigned int compressDevId;
     std::vector<int> compressDevIds;
     std::unique_ptr<std::thread> worker_thread;
-    std::queue<std::shared_ptr<offload_msg>> msg_queue_;
+    /* preallocated ring of offload commands, guarded by cv_mutex_ */
+    struct offload_msg msg_queue_[OFFLOAD_MSG_QUEUE_SIZE];
+    uint32_t msg_head_;
+    uint32_t msg_count_;
+    bool wait_for_buffer_pending_;
+    int postOffloadMsg(int cmd);
     size_t compress_cap_buf_size;
     std::vector<std::pair<std::string, int>> freeDeviceMetadata;
 
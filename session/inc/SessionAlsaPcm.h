@@ -71,6 +71,33 @@ private:
     uint32_t svaMiid;
     static std::mutex pcmLpmRefCntMtx;
     static int pcmLpmRefCnt;
+    /* non-blocking pcm: partial transfers arm a poll on the pcm fd and
+     * readiness is reported to the stream through sessionCb */
+    bool nonBlocking;
+    /* shared with the poll thread, so that a close() issued from sessionCb
+     * on that thread can leave it to exit on its own once the callback
+     * returns, without it touching the session again */
+    struct PcmPollState {
+        std::mutex mutex;
+        int wakeFd;
+        bool armed;
+        bool exit;
+        PcmPollState() : wakeFd(-1), armed(false), exit(false) {}
+        ~PcmPollState();
+    };
+    std::shared_ptr<PcmPollState> pollState;
+    std::thread pollThread;
+    int startPcmPollThread(pal_stream_direction_t dir);
+    void stopPcmPollThread();
+    void armPcmPoll(bool arm);
+    void pcmPollThreadLoop(std::shared_ptr<PcmPollState> state, int pcmFd,
+                           short events, uint32_t eventId);
+    int pcmTransferNonBlock(pal_stream_direction_t dir, void *data,
+                            uint32_t bytes, uint32_t *transferred);
+    /* bounce buffer for periods that straddle two readv/writev spans */
+    std::vector<uint8_t> iovStage;
+    int transferv(pal_stream_direction_t dir, const struct pal_iovec *iov,
+                  uint32_t iovcnt, size_t chunkSize, int *size);
 public:
 
     SessionAlsaPcm(std::shared_ptr<ResourceManager> Rm);
@@ -89,6 +116,10 @@ public:
     int writeBufferInit(Stream *s, size_t noOfBuf, size_t bufSize, int flag) override;
     int read(Stream *s, int tag, struct pal_buffer *buf, int * size) override;
     int write(Stream *s, int tag, struct pal_buffer *buf, int * size, int flag) override;
+    int readv(Stream *s, int tag, const struct pal_iovec *iov, uint32_t iovcnt,
+              int * size) override;
+    int writev(Stream *s, int tag, const struct pal_iovec *iov, uint32_t iovcnt,
+               int * size, int flag) override;
     int setParameters(Stream *s, int tagId, uint32_t param_id, void *payload) override;
     int getParameters(Stream *s, int tagId, uint32_t param_id, void **payload) override;
     int setECRef(Stream *s, std::shared_ptr<Device> rx_dev, bool is_enable) override;
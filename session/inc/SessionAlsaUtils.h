@@ -40,6 +40,9 @@
 
 #include <tinyalsa/asoundlib.h>
 #include <sound/asound.h>
+#include <map>
+#include <mutex>
+#include <tuple>
 
 
 class Stream;
@@ -87,6 +90,19 @@ private:
     static struct mixer_ctl *getBeMixerControl(struct mixer *am, std::string beName,
         uint32_t idx);
     static struct mixer_ctl *getStaticMixerControl(struct mixer *am, std::string name);
+    /* FE controls resolved once per FE id, indexed by FeCtrlsIndex */
+    struct FeMixerCtls {
+        struct mixer *mixer;
+        struct mixer_ctl *ctls[FE_MAX_NUM_MIXER_CONTROLS];
+    };
+    static std::map<int, FeMixerCtls> feMixerCtlTable;
+    static std::mutex feMixerCtlTableMutex;
+    static FeMixerCtls *resolveFeMixerControlsLocked(struct mixer *mixer, int device);
+    /* MIIDs resolved through getTaggedInfo, keyed on <FE device, intf name, tag> */
+    static std::map<std::tuple<int, std::string, int>, uint32_t> miidCache;
+    static std::mutex miidCacheMutex;
+    /* bumped on every invalidation, lookups started before it are not cached */
+    static uint64_t miidCacheGen;
 public:
     ~SessionAlsaUtils();
     static bool isRxDevice(uint32_t devId);
@@ -113,6 +129,13 @@ public:
                     std::vector<std::pair<std::string, int>> &freeDeviceMetaData);
     static int getModuleInstanceId(struct mixer *mixer, int device, const char *intf_name,
                        int tag_id, uint32_t *miid);
+    static int resolveFeMixerControls(struct mixer *mixer, const std::vector<int> &DevIds);
+    static struct mixer_ctl *getFeMixerControlById(struct mixer *mixer, int device,
+                       FeCtrlsIndex idx);
+    static void clearFeMixerControls();
+    static void invalidateModuleInstanceIds(int device);
+    static void invalidateModuleInstanceIds(const std::vector<int> &DevIds);
+    static void invalidateModuleInstanceIds();
     static int getTagsWithModuleInfo(struct mixer *mixer, int device, const char *intf_name,
                        uint8_t *payload);
     static int setMixerParameter(struct mixer *mixer, int device,
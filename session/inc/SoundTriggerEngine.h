@@ -150,6 +150,7 @@ public:
     int32_t CreateBuffer(uint32_t buffer_size, uint32_t engine_size,
         std::vector<PalRingBufferReader *> &reader_list);
     int32_t SetBufferReader(PalRingBufferReader *reader);
+    int32_t SetBufferFanout(std::shared_ptr<PalRingBufferFanout> fanout);
     int32_t ResetBufferReaders(std::vector<PalRingBufferReader *> &reader_list);
     uint32_t UsToBytes(uint64_t input_us);
     uint32_t FrameToBytes(uint32_t frames);
@@ -166,6 +167,8 @@ protected:
     Stream *stream_handle_;
     PalRingBuffer *buffer_;
     PalRingBufferReader *reader_;
+    /* set instead of reader_ when second stage engines share one reader */
+    std::shared_ptr<PalRingBufferFanout> fanout_;
     uint32_t sample_rate_;
     uint32_t bit_width_;
     uint32_t channels_;
@@ -99,6 +99,8 @@ class SoundTriggerEngineCapi : public SoundTriggerEngine {
     int32_t StopSoundEngine();
     int32_t StartKeywordDetection();
     int32_t StartUserVerification();
+    int32_t ReadLabData(uint32_t size, char *linear_buff, char **data,
+                        bool *buffer_advanced);
     static void BufferThreadLoop(SoundTriggerEngineCapi *capi_engine);
 
     std::string lib_name_;
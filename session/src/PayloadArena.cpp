@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define LOG_TAG "PAL: PayloadArena"
+
+#include <stdlib.h>
+#include <string.h>
+#include "PayloadArena.h"
+#include "PalCommon.h"
+
+PayloadArena::PayloadArena()
+{
+    /* freelists are sized on first release, most builders never use some classes */
+    memset(&mStats, 0, sizeof(mStats));
+}
+
+PayloadArena::~PayloadArena()
+{
+    dumpStats(nullptr);
+    for (int i = 0; i < PAYLOAD_ARENA_NUM_CLASSES; i++) {
+        for (auto blk : mFreeBlocks[i])
+            free(blk);
+        mFreeBlocks[i].clear();
+    }
+}
+
+int PayloadArena::sizeClass(size_t size)
+{
+    int cls = 0;
+
+    if (size > ((size_t)1 << PAYLOAD_ARENA_MAX_SHIFT))
+        return -1;
+
+    while (((size_t)1 << (cls + PAYLOAD_ARENA_MIN_SHIFT)) < size)
+        cls++;
+
+    return cls;
+}
+
+uint8_t* PayloadArena::alloc(size_t size)
+{
+    uint8_t *blk = nullptr;
+    int cls = sizeClass(size);
+
+    mLock.lock();
+    mStats.allocs++;
+    if (cls >= 0 && !mFreeBlocks[cls].empty()) {
+        blk = mFreeBlocks[cls].back();
+        mFreeBlocks[cls].pop_back();
+        mStats.poolHits++;
+        mStats.pooledBlocks--;
+    } else {
+        mStats.heapAllocs++;
+    }
+    mLock.unlock();
+
+    if (blk) {
+        /* builders rely on calloc semantics for padding and reserved fields */
+        memset(blk, 0, size);
+        return blk;
+    }
+
+    if (cls >= 0)
+        blk = (uint8_t *)calloc(1, (size_t)1 << (cls + PAYLOAD_ARENA_MIN_SHIFT));
+    else
+        blk = (uint8_t *)calloc(1, size);
+
+    if (!blk)
+        PAL_ERR(LOG_TAG, "failed to allocate %zu bytes", size);
+
+    return blk;
+}
+
+/*
+ * size must be what the block was allocated with, or anything in the same
+ * size class; payload builders report their allocation size back through
+ * the *size argument so the callers can hand both straight back here.
+ */
+void PayloadArena::release(uint8_t *ptr, size_t size)
+{
+    int cls = sizeClass(size);
+
+    if (!ptr)
+        return;
+
+    mLock.lock();
+    mStats.releases++;
+    if (cls >= 0 &&
+        mFreeBlocks[cls].size() < PAYLOAD_ARENA_BLOCKS_PER_CLASS) {
+        if (mFreeBlocks[cls].capacity() == 0)
+            mFreeBlocks[cls].reserve(PAYLOAD_ARENA_BLOCKS_PER_CLASS);
+        mFreeBlocks[cls].push_back(ptr);
+        mStats.pooledBlocks++;
+        ptr = nullptr;
+    } else {
+        mStats.heapFrees++;
+    }
+    mLock.unlock();
+
+    if (ptr)
+        free(ptr);
+}
+
+void PayloadArena::getStats(struct payloadArenaStats *stats)
+{
+    if (!stats)
+        return;
+
+    std::lock_guard<std::mutex> lock(mLock);
+    *stats = mStats;
+}
+
+void PayloadArena::dumpStats(const char *owner)
+{
+    struct payloadArenaStats stats;
+
+    getStats(&stats);
+    PAL_DBG(LOG_TAG, "%s: allocs %llu pool hits %llu heap allocs %llu releases %llu heap frees %llu pooled %u",
+            owner ? owner : "arena",
+            (unsigned long long)stats.allocs, (unsigned long long)stats.poolHits,
+            (unsigned long long)stats.heapAllocs, (unsigned long long)stats.releases,
+            (unsigned long long)stats.heapFrees, stats.pooledBlocks);
+}
@@ -44,6 +44,11 @@
 #include "sp_vi.h"
 #include "sp_rx.h"
 #include "fluence_ffv_common_calibration.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cutils/properties.h>
 
 #if defined(FEATURE_IPQ_OPENWRT) || defined(LINUX_ENABLED)
 #define USECASE_XML_FILE "/etc/usecaseKvManager.xml"
@@ -52,6 +57,16 @@
 #endif
 
 #define USECASE_ARRAX_XML_FILE "/vendor/etc/usecaseKvManager_arrax.xml"
+
+#if defined(FEATURE_IPQ_OPENWRT) || defined(LINUX_ENABLED)
+#define USECASE_KV_SNAPSHOT_FILE "/var/cache/pal_usecase_kv.bin"
+#else
+#define USECASE_KV_SNAPSHOT_FILE "/data/vendor/audio/pal_usecase_kv.bin"
+#endif
+#define USECASE_KV_SNAPSHOT_MAGIC 0x564B4C50 /* "PLKV" */
+/* bump whenever kvInfo/allKVs or the serialized layout changes */
+#define USECASE_KV_SNAPSHOT_VERSION 2
+#define USECASE_KV_SNAPSHOT_BUILD_PROP "ro.vendor.build.fingerprint"
 #define PARAM_ID_CHMIXER_COEFF 0x0800101F
 #define CUSTOM_STEREO_NUM_OUT_CH 0x0002
 #define CUSTOM_STEREO_NUM_IN_CH 0x0002
@@ -170,6 +185,18 @@ std::vector<allKVs> PayloadBuilder::all_streams;
 std::vector<allKVs> PayloadBuilder::all_streampps;
 std::vector<allKVs> PayloadBuilder::all_devices;
 std::vector<allKVs> PayloadBuilder::all_devicepps;
+std::unordered_map<kvIndexKey, std::vector<const kvInfo *>, kvIndexKeyHash> PayloadBuilder::kvIndex;
+std::set<std::tuple<const std::vector<allKVs> *, uint32_t, std::vector<selector_type_t>>>
+    PayloadBuilder::kvIndexedSets;
+std::unordered_map<std::string, uint32_t> PayloadBuilder::selectorValueIds;
+std::mutex PayloadBuilder::kvIndexMutex;
+std::list<std::pair<std::string, PayloadBuilder::kvCacheEntry>> PayloadBuilder::kvCacheLru;
+std::unordered_map<std::string,
+    std::list<std::pair<std::string, PayloadBuilder::kvCacheEntry>>::iterator>
+    PayloadBuilder::kvCacheMap;
+std::map<std::pair<const std::vector<allKVs> *, uint32_t>, std::vector<std::string>>
+    PayloadBuilder::kvCacheSelectors;
+std::mutex PayloadBuilder::kvCacheMutex;
 
 template <typename T>
 void PayloadBuilder::populateChannelMap(T pcmChannel, uint8_t numChannel)
@@ -325,7 +352,7 @@ void PayloadBuilder::payloadVolumeConfig(uint8_t** payload, size_t* size,
     payloadSize = sizeof(struct apm_module_param_data_t) +
                   sizeof(struct volume_ctrl_master_gain_t);
     padBytes = PAL_PADDING_8BYTE_ALIGN(payloadSize);
-    payloadInfo = new uint8_t[payloadSize + padBytes]();
+    payloadInfo = allocPayload(payloadSize + padBytes);
     if (!payloadInfo) {
         PAL_ERR(LOG_TAG, "payloadInfo malloc failed %s", strerror(errno));
         return;
@@ -360,7 +387,7 @@ void PayloadBuilder::payloadMultichVolumemConfig(uint8_t** payload, size_t* size
                    sizeof(struct volume_ctrl_multichannel_gain_t) +
                    numChannels * sizeof(volume_ctrl_channels_gain_config_t);
      padBytes = PAL_PADDING_8BYTE_ALIGN(payloadSize);
-     payloadInfo = (uint8_t*) calloc(1, payloadSize + padBytes);
+     payloadInfo = allocPayload(payloadSize + padBytes);
      if (!payloadInfo) {
          PAL_ERR(LOG_TAG, "payloadInfo malloc failed %s", strerror(errno));
          return;
@@ -410,7 +437,7 @@ void PayloadBuilder::payloadMFCConfig(uint8_t** payload, size_t* size,
                   sizeof(uint16_t)*numChannels;
     padBytes = PAL_PADDING_8BYTE_ALIGN(payloadSize);
 
-    payloadInfo = (uint8_t*) calloc(1, payloadSize + padBytes);
+    payloadInfo = allocPayload(payloadSize + padBytes);
     if (!payloadInfo) {
         PAL_ERR(LOG_TAG, "payloadInfo malloc failed %s", strerror(errno));
         return;
@@ -469,7 +496,7 @@ int PayloadBuilder::payloadPopSuppressorConfig(uint8_t** payload, size_t* size,
                   sizeof(struct param_id_pop_suppressor_mute_config_t);
     padBytes = PAL_PADDING_8BYTE_ALIGN(payloadSize);
 
-    payloadInfo = (uint8_t*) calloc(1, payloadSize + padBytes);
+    payloadInfo = allocPayload(payloadSize + padBytes);
     if (!payloadInfo) {
         PAL_ERR(LOG_TAG, "payloadInfo malloc failed %s", strerror(errno));
         status = -ENOMEM;
@@ -506,6 +533,39 @@ PayloadBuilder::~PayloadBuilder()
 
 }
 
+/*
+ * Zeroed block for a module payload. The returned memory is plain heap
+ * memory, callers that still free() it keep working, but handing it back
+ * through releasePayload() lets the next payload of the same size class
+ * (e.g. the next volume step of a ramp) reuse it.
+ */
+uint8_t* PayloadBuilder::allocPayload(size_t size)
+{
+    return payloadArena.alloc(size);
+}
+
+/*
+ * Only for payloads built by payloadVolumeConfig, payloadMultichVolumemConfig,
+ * payloadMFCConfig, payloadPopSuppressorConfig, payloadRATConfig,
+ * payloadPcmCnvConfig, payloadCopPackConfig, payloadCopV2PackConfig,
+ * payloadCopV2DepackConfig, payloadScramblingConfig, payloadSPConfig and
+ * payloadCustomParam, with the size they reported.
+ */
+void PayloadBuilder::releasePayload(uint8_t **payload, size_t *size)
+{
+    if (!payload || !size)
+        return;
+
+    payloadArena.release(*payload, *size);
+    *payload = NULL;
+    *size = 0;
+}
+
+void PayloadBuilder::getPayloadArenaStats(struct payloadArenaStats *stats)
+{
+    payloadArena.getStats(stats);
+}
+
 uint16_t numOfBitsSet(uint32_t lines)
 {
     uint16_t numBitsSet = 0;
@@ -592,8 +652,19 @@ void PayloadBuilder::processGraphKVData(struct user_xml_data *data, const XML_Ch
 
 std::string PayloadBuilder::removeSpaces(const std::string& str)
 {
-    /* Remove leading and trailing spaces */
-    return std::regex_replace(str, std::regex("^ +| +$|( ) +"), "$1");
+    /* Remove leading and trailing spaces, collapse inner runs to one */
+    std::string out;
+
+    out.reserve(str.size());
+    for (char c : str) {
+        if (c == ' ' && (out.empty() || out.back() == ' '))
+            continue;
+        out.push_back(c);
+    }
+    if (!out.empty() && out.back() == ' ')
+        out.pop_back();
+
+    return out;
 }
 
 std::vector<std::string> PayloadBuilder::splitStrings(const std::string& str)
@@ -850,6 +921,286 @@ void PayloadBuilder::handleData(void *userdata, const char *s, int len)
    }
 }
 
+/*
+ * Snapshot layout: header, source path, vendor build fingerprint, then
+ * all_streams, all_streampps, all_devices and all_devicepps. Each table is a
+ * u32 count of allKVs, each allKVs is id_type and keys_values as counted
+ * arrays, strings are u32 length + bytes. The snapshot is only used while
+ * the source xml has the size and content hash recorded in the header and
+ * the vendor build is the same. Vendor images carry one fixed mtime for all
+ * files, so an OTA can change the xml without changing its mtime.
+ */
+struct usecaseKvSnapshotHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t srcSize;
+    uint64_t srcHash;
+    uint32_t pathLen;
+    uint32_t buildIdLen;
+    uint32_t numTables;
+};
+
+/* size and FNV-1a hash of the xml, a few hundred us against a full parse */
+static int kvSnapshotHashSource(const char *xmlFile, uint64_t *size, uint64_t *hash)
+{
+    struct stat srcStat;
+    const uint8_t *data = NULL;
+    void *map = MAP_FAILED;
+    uint64_t h = 0xcbf29ce484222325ULL;
+    int fd = -1;
+
+    fd = open(xmlFile, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return -ENOENT;
+
+    if (fstat(fd, &srcStat) != 0 || srcStat.st_size <= 0) {
+        close(fd);
+        return -EINVAL;
+    }
+
+    map = mmap(NULL, srcStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return -ENOMEM;
+
+    data = (const uint8_t *)map;
+    for (off_t i = 0; i < srcStat.st_size; i++) {
+        h ^= data[i];
+        h *= 0x100000001b3ULL;
+    }
+    munmap(map, srcStat.st_size);
+
+    *size = srcStat.st_size;
+    *hash = h;
+    return 0;
+}
+
+static std::string kvSnapshotBuildId()
+{
+#ifndef FEATURE_IPQ_OPENWRT
+    char value[PROPERTY_VALUE_MAX] = {0};
+
+    if (property_get(USECASE_KV_SNAPSHOT_BUILD_PROP, value, "") > 0)
+        return std::string(value);
+#endif
+    return std::string();
+}
+
+struct usecaseKvSnapshotReader {
+    const uint8_t *cur;
+    const uint8_t *end;
+    bool ok;
+
+    bool get(void *dst, size_t size) {
+        if (!ok || (size_t)(end - cur) < size) {
+            ok = false;
+            return false;
+        }
+        memcpy(dst, cur, size);
+        cur += size;
+        return true;
+    }
+    uint32_t getU32() {
+        uint32_t val = 0;
+        get(&val, sizeof(val));
+        return val;
+    }
+    /* counts are bounded by the bytes left so a corrupt file cannot
+     * make us reserve huge vectors */
+    uint32_t getCount(size_t minElemSize) {
+        uint32_t count = getU32();
+        if (ok && (size_t)count * minElemSize > (size_t)(end - cur))
+            ok = false;
+        return ok ? count : 0;
+    }
+    std::string getString() {
+        uint32_t len = getCount(1);
+        std::string str;
+        if (ok) {
+            str.assign((const char *)cur, len);
+            cur += len;
+        }
+        return str;
+    }
+};
+
+static void kvSnapshotPutU32(std::vector<uint8_t> &out, uint32_t val)
+{
+    out.insert(out.end(), (uint8_t *)&val, (uint8_t *)&val + sizeof(val));
+}
+
+static void kvSnapshotPutString(std::vector<uint8_t> &out, const std::string &str)
+{
+    kvSnapshotPutU32(out, str.size());
+    out.insert(out.end(), str.begin(), str.end());
+}
+
+static void kvSnapshotPutTable(std::vector<uint8_t> &out, const std::vector<allKVs> &table)
+{
+    kvSnapshotPutU32(out, table.size());
+    for (auto &kvs : table) {
+        kvSnapshotPutU32(out, kvs.id_type.size());
+        for (int id : kvs.id_type)
+            kvSnapshotPutU32(out, (uint32_t)id);
+        kvSnapshotPutU32(out, kvs.keys_values.size());
+        for (auto &info : kvs.keys_values) {
+            kvSnapshotPutU32(out, info.selector_names.size());
+            for (auto &name : info.selector_names)
+                kvSnapshotPutString(out, name);
+            kvSnapshotPutU32(out, info.selector_pairs.size());
+            for (auto &sel : info.selector_pairs) {
+                kvSnapshotPutU32(out, (uint32_t)sel.first);
+                kvSnapshotPutString(out, sel.second);
+            }
+            kvSnapshotPutU32(out, info.kv_pairs.size());
+            for (auto &kv : info.kv_pairs) {
+                kvSnapshotPutU32(out, kv.key);
+                kvSnapshotPutU32(out, kv.value);
+            }
+        }
+    }
+}
+
+static bool kvSnapshotGetTable(usecaseKvSnapshotReader &in, std::vector<allKVs> &table)
+{
+    uint32_t count = in.getCount(2 * sizeof(uint32_t));
+
+    table.resize(count);
+    for (auto &kvs : table) {
+        kvs.id_type.resize(in.getCount(sizeof(uint32_t)));
+        for (auto &id : kvs.id_type)
+            id = (int)in.getU32();
+        kvs.keys_values.resize(in.getCount(3 * sizeof(uint32_t)));
+        for (auto &info : kvs.keys_values) {
+            info.selector_names.resize(in.getCount(sizeof(uint32_t)));
+            for (auto &name : info.selector_names)
+                name = in.getString();
+            info.selector_pairs.resize(in.getCount(2 * sizeof(uint32_t)));
+            for (auto &sel : info.selector_pairs) {
+                sel.first = (selector_type_t)in.getU32();
+                sel.second = in.getString();
+            }
+            info.kv_pairs.resize(in.getCount(sizeof(kvPairs)));
+            for (auto &kv : info.kv_pairs) {
+                kv.key = in.getU32();
+                kv.value = in.getU32();
+            }
+        }
+        if (!in.ok)
+            break;
+    }
+    return in.ok;
+}
+
+int PayloadBuilder::loadKVSnapshot(const char *xmlFile)
+{
+    struct stat cacheStat;
+    struct usecaseKvSnapshotHeader hdr;
+    usecaseKvSnapshotReader in;
+    std::string buildId = kvSnapshotBuildId();
+    uint64_t srcSize = 0;
+    uint64_t srcHash = 0;
+    void *map = MAP_FAILED;
+    int fd = -1;
+    int ret = -EINVAL;
+
+    if (kvSnapshotHashSource(xmlFile, &srcSize, &srcHash) != 0)
+        return -ENOENT;
+
+    fd = open(USECASE_KV_SNAPSHOT_FILE, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return -ENOENT;
+
+    if (fstat(fd, &cacheStat) != 0 || cacheStat.st_size < (off_t)sizeof(hdr))
+        goto exit;
+
+    map = mmap(NULL, cacheStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED)
+        goto exit;
+
+    in.cur = (const uint8_t *)map;
+    in.end = in.cur + cacheStat.st_size;
+    in.ok = true;
+    in.get(&hdr, sizeof(hdr));
+    if (hdr.magic != USECASE_KV_SNAPSHOT_MAGIC ||
+        hdr.version != USECASE_KV_SNAPSHOT_VERSION ||
+        hdr.numTables != 4 ||
+        hdr.srcSize != srcSize ||
+        hdr.srcHash != srcHash ||
+        hdr.pathLen != strlen(xmlFile) ||
+        hdr.buildIdLen != buildId.size() ||
+        (size_t)(in.end - in.cur) < (size_t)hdr.pathLen + hdr.buildIdLen ||
+        memcmp(in.cur, xmlFile, hdr.pathLen) ||
+        memcmp(in.cur + hdr.pathLen, buildId.data(), hdr.buildIdLen)) {
+        PAL_INFO(LOG_TAG, "usecase KV snapshot is stale");
+        goto exit;
+    }
+    in.cur += hdr.pathLen + hdr.buildIdLen;
+
+    if (!kvSnapshotGetTable(in, all_streams) || !kvSnapshotGetTable(in, all_streampps) ||
+        !kvSnapshotGetTable(in, all_devices) || !kvSnapshotGetTable(in, all_devicepps) ||
+        in.cur != in.end) {
+        PAL_ERR(LOG_TAG, "usecase KV snapshot is corrupt");
+        goto exit;
+    }
+    ret = 0;
+
+exit:
+    if (ret) {
+        all_streams.clear();
+        all_streampps.clear();
+        all_devices.clear();
+        all_devicepps.clear();
+    }
+    if (map != MAP_FAILED)
+        munmap(map, cacheStat.st_size);
+    close(fd);
+    return ret;
+}
+
+void PayloadBuilder::storeKVSnapshot(const char *xmlFile)
+{
+    struct usecaseKvSnapshotHeader hdr;
+    std::vector<uint8_t> out;
+    std::string tmpFile = std::string(USECASE_KV_SNAPSHOT_FILE) + ".tmp";
+    std::string buildId = kvSnapshotBuildId();
+    ssize_t written = 0;
+    int fd = -1;
+
+    memset(&hdr, 0, sizeof(hdr));
+    if (kvSnapshotHashSource(xmlFile, &hdr.srcSize, &hdr.srcHash) != 0)
+        return;
+
+    hdr.magic = USECASE_KV_SNAPSHOT_MAGIC;
+    hdr.version = USECASE_KV_SNAPSHOT_VERSION;
+    hdr.pathLen = strlen(xmlFile);
+    hdr.buildIdLen = buildId.size();
+    hdr.numTables = 4;
+    out.insert(out.end(), (uint8_t *)&hdr, (uint8_t *)&hdr + sizeof(hdr));
+    out.insert(out.end(), xmlFile, xmlFile + hdr.pathLen);
+    out.insert(out.end(), buildId.begin(), buildId.end());
+    kvSnapshotPutTable(out, all_streams);
+    kvSnapshotPutTable(out, all_streampps);
+    kvSnapshotPutTable(out, all_devices);
+    kvSnapshotPutTable(out, all_devicepps);
+
+    /* write aside and rename so a reader never maps a partial snapshot */
+    fd = open(tmpFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        PAL_DBG(LOG_TAG, "cannot create %s, errno %d", tmpFile.c_str(), errno);
+        return;
+    }
+    written = write(fd, out.data(), out.size());
+    close(fd);
+    if (written != (ssize_t)out.size() ||
+        rename(tmpFile.c_str(), USECASE_KV_SNAPSHOT_FILE) != 0) {
+        PAL_ERR(LOG_TAG, "failed to store usecase KV snapshot, errno %d", errno);
+        unlink(tmpFile.c_str());
+        return;
+    }
+    PAL_INFO(LOG_TAG, "stored usecase KV snapshot, %zu bytes", out.size());
+}
+
 int PayloadBuilder::init()
 {
     XML_Parser parser;
@@ -858,19 +1209,23 @@ int PayloadBuilder::init()
     int bytes_read;
     void *buf = NULL;
     struct user_xml_data tag_data;
+    const char *xmlFile = USECASE_XML_FILE;
     memset(&tag_data, 0, sizeof(tag_data));
     all_streams.clear();
     all_streampps.clear();
     all_devices.clear();
     all_devicepps.clear();
 
-    if (getSocId() == ARRAX_SOC_ID) {
-        PAL_INFO(LOG_TAG, "XML parsing started %s", USECASE_ARRAX_XML_FILE);
-        file = fopen(USECASE_ARRAX_XML_FILE, "r");
-    } else {
-        PAL_INFO(LOG_TAG, "XML parsing started %s", USECASE_XML_FILE);
-        file = fopen(USECASE_XML_FILE, "r");
+    if (getSocId() == ARRAX_SOC_ID)
+        xmlFile = USECASE_ARRAX_XML_FILE;
+
+    if (loadKVSnapshot(xmlFile) == 0) {
+        PAL_INFO(LOG_TAG, "usecase KVs loaded from %s", USECASE_KV_SNAPSHOT_FILE);
+        goto done;
     }
+
+    PAL_INFO(LOG_TAG, "XML parsing started %s", xmlFile);
+    file = fopen(xmlFile, "r");
     if (!file) {
         PAL_ERR(LOG_TAG, "Failed to open xml");
         ret = -EINVAL;
@@ -909,15 +1264,143 @@ int PayloadBuilder::init()
         if (bytes_read == 0)
             break;
     }
+    storeKVSnapshot(xmlFile);
 
 freeParser:
     XML_ParserFree(parser);
 closeFile:
     fclose(file);
 done:
+    buildKVIndex();
     return ret;
 }
 
+/*
+ * Add all kvInfo of the given stream type/dev id to kvIndex, keyed on every
+ * combination of values they accept for the selector types in selTypes.
+ * A kvInfo matches filled selectors when each filled pair is one of its
+ * selector pairs, and only kvInfo without selectors match an empty set.
+ * Caller holds kvIndexMutex.
+ */
+void PayloadBuilder::indexKVs(std::vector<allKVs> &any_type, uint32_t type,
+                              const std::vector<selector_type_t> &selTypes)
+{
+    std::set<const kvIndexKey *> keysOfBlock;
+    std::vector<std::vector<uint32_t>> values;
+    std::vector<size_t> pos;
+    kvIndexKey key;
+    bool hasAllTypes;
+
+    if (!kvIndexedSets.insert(std::make_tuple(&any_type, type, selTypes)).second)
+        return;
+
+    key.table = &any_type;
+    key.type = type;
+    for (int32_t i = 0; i < any_type.size(); i++) {
+        if (!isIdTypeAvailable(type, any_type[i].id_type))
+            continue;
+        keysOfBlock.clear();
+        for (int32_t j = 0; j < any_type[i].keys_values.size(); j++) {
+            struct kvInfo &info = any_type[i].keys_values[j];
+
+            if (selTypes.empty() && !info.selector_pairs.empty())
+                continue;
+            values.assign(selTypes.size(), std::vector<uint32_t>());
+            hasAllTypes = true;
+            for (int32_t t = 0; t < selTypes.size(); t++) {
+                for (auto &pair : info.selector_pairs) {
+                    if (pair.first != selTypes[t])
+                        continue;
+                    auto id = selectorValueIds.emplace(pair.second,
+                                  selectorValueIds.size()).first->second;
+                    values[t].push_back(id);
+                }
+                if (values[t].empty()) {
+                    hasAllTypes = false;
+                    break;
+                }
+            }
+            if (!hasAllTypes)
+                continue;
+
+            /* walk the cartesian product of the accepted values */
+            pos.assign(selTypes.size(), 0);
+            while (true) {
+                key.selectors.clear();
+                for (int32_t t = 0; t < selTypes.size(); t++)
+                    key.selectors.push_back(std::make_pair(selTypes[t], values[t][pos[t]]));
+
+                auto entry = kvIndex.emplace(key, std::vector<const kvInfo *>()).first;
+                /* only the first match of a block counts, as in the xml order scan */
+                if (keysOfBlock.insert(&entry->first).second)
+                    entry->second.push_back(&info);
+
+                int32_t t = selTypes.size() - 1;
+                for (; t >= 0; t--) {
+                    if (++pos[t] < values[t].size())
+                        break;
+                    pos[t] = 0;
+                }
+                if (t < 0)
+                    break;
+            }
+        }
+    }
+}
+
+void PayloadBuilder::buildKVIndex()
+{
+    std::vector<std::vector<allKVs> *> tables = {&all_streams, &all_streampps,
+                                                 &all_devices, &all_devicepps};
+    std::set<int> types;
+    std::set<selector_type_t> selTypes;
+    std::vector<selector_type_t> selTypesNoCustom;
+
+    kvCacheMutex.lock();
+    kvCacheLru.clear();
+    kvCacheMap.clear();
+    kvCacheSelectors.clear();
+    kvCacheMutex.unlock();
+
+    std::lock_guard<std::mutex> lock(kvIndexMutex);
+    kvIndex.clear();
+    kvIndexedSets.clear();
+    selectorValueIds.clear();
+
+    /* intern every selector value so unknown filled values fail fast in findKVs */
+    for (auto table : tables)
+        for (auto &block : *table)
+            for (auto &info : block.keys_values)
+                for (auto &pair : info.selector_pairs)
+                    selectorValueIds.emplace(pair.second, selectorValueIds.size());
+
+    for (auto table : tables) {
+        types.clear();
+        for (auto &block : *table)
+            types.insert(block.id_type.begin(), block.id_type.end());
+
+        /* pre-index the selector sets populate* resolve, with and without custom config */
+        for (auto type : types) {
+            selTypes.clear();
+            for (auto &block : *table) {
+                if (!isIdTypeAvailable(type, block.id_type))
+                    continue;
+                for (auto &info : block.keys_values)
+                    for (auto &pair : info.selector_pairs)
+                        selTypes.insert(pair.first);
+            }
+            indexKVs(*table, type, std::vector<selector_type_t>(selTypes.begin(),
+                                                               selTypes.end()));
+            if (selTypes.erase(CUSTOM_CONFIG_SEL)) {
+                selTypesNoCustom.assign(selTypes.begin(), selTypes.end());
+                indexKVs(*table, type, selTypesNoCustom);
+            }
+        }
+    }
+    PAL_INFO(LOG_TAG, "graph kv index has %zu keys, %zu selector values",
+             kvIndex.size(), selectorValueIds.size());
+}
+
 void PayloadBuilder::payloadTimestamp(std::shared_ptr<std::vector<uint8_t>>& payload,
                                       size_t *size, uint32_t moduleId)
 {
@@ -1354,7 +1837,7 @@ int PayloadBuilder::payloadCustomParam(uint8_t **alsaPayload, size_t *size,
     if (paramId) {
         alsaPayloadSize = PAL_ALIGN_8BYTE(sizeof(struct apm_module_param_data_t)
                                             + customPayloadSize);
-        payloadInfo = (uint8_t *)calloc(1, (size_t)alsaPayloadSize);
+        payloadInfo = allocPayload(alsaPayloadSize);
         if (!payloadInfo) {
             PAL_ERR(LOG_TAG, "failed to allocate memory.");
             return -ENOMEM;
@@ -1374,7 +1857,7 @@ int PayloadBuilder::payloadCustomParam(uint8_t **alsaPayload, size_t *size,
         *alsaPayload = payloadInfo;
     } else {
         // make sure memory is big enough to handle padding
-        uint8_t *repackedData = (uint8_t *)calloc(1, customPayloadSize * 2);
+        uint8_t *repackedData = allocPayload((size_t)customPayloadSize * 2);
         if (!repackedData) {
             PAL_ERR(LOG_TAG, "failed to allocate memory of 0x%x bytes",
                         customPayloadSize * 2);
@@ -1713,7 +2196,7 @@ void PayloadBuilder::payloadRATConfig(uint8_t** payload, size_t* size,
                   sizeof(uint16_t)*numChannel;
     padBytes = PAL_PADDING_8BYTE_ALIGN(payloadSize);
 
-    payloadInfo = (uint8_t*) calloc(1, payloadSize + padBytes);
+    payloadInfo = allocPayload(payloadSize + padBytes);
     if (!payloadInfo) {
         PAL_ERR(LOG_TAG, "payloadInfo malloc failed %s", strerror(errno));
         return;
@@ -1775,7 +2258,7 @@ void PayloadBuilder::payloadPcmCnvConfig(uint8_t** payload, size_t* size,
                   sizeof(uint8_t)*numChannels;
     padBytes = PAL_PADDING_8BYTE_ALIGN(payloadSize);
 
-    payloadInfo = new uint8_t[payloadSize + padBytes]();
+    payloadInfo = allocPayload(payloadSize + padBytes);
     if (!payloadInfo) {
         PAL_ERR(LOG_TAG, "payloadInfo malloc failed %s", strerror(errno));
         return;
@@ -1821,7 +2304,7 @@ void PayloadBuilder::payloadPcmCnvConfig(uint8_t** payload, size_t* size,
         mediaFmtPayload->alignment       = PCM_MSB_ALIGNED;
     } else {
         PAL_ERR(LOG_TAG, "invalid bit width %d", data->bit_width);
-        delete[] payloadInfo;
+        payloadArena.release(payloadInfo, payloadSize + padBytes);
         *size = 0;
         *payload = NULL;
         return;
@@ -1859,7 +2342,7 @@ void PayloadBuilder::payloadCopPackConfig(uint8_t** payload, size_t* size,
                   sizeof(uint16_t)*numChannel;
     padBytes = PAL_PADDING_8BYTE_ALIGN(payloadSize);
 
-    payloadInfo = new uint8_t[payloadSize + padBytes]();
+    payloadInfo = allocPayload(payloadSize + padBytes);
     if (!payloadInfo) {
         PAL_ERR(LOG_TAG, "payloadInfo alloc failed %s", strerror(errno));
         return;
@@ -1903,7 +2386,7 @@ void PayloadBuilder::payloadScramblingConfig(uint8_t** payload, size_t* size,
                   sizeof(struct param_id_cop_pack_enable_scrambling_t);
     padBytes = PAL_PADDING_8BYTE_ALIGN(payloadSize);
 
-    payloadInfo = new uint8_t[payloadSize + padBytes]();
+    payloadInfo = allocPayload(payloadSize + padBytes);
     if (!payloadInfo) {
         PAL_ERR(LOG_TAG, "payloadInfo alloc failed %s", strerror(errno));
         return;
@@ -1951,7 +2434,7 @@ void PayloadBuilder::payloadCopV2PackConfig(uint8_t** payload, size_t* size,
                   sizeof(struct cop_v2_stream_info_map_t) * bleCfg->enc_cfg.stream_map_size;
     padBytes = PAL_PADDING_8BYTE_ALIGN(payloadSize);
 
-    payloadInfo = new uint8_t[payloadSize + padBytes]();
+    payloadInfo = allocPayload(payloadSize + padBytes);
     if (!payloadInfo) {
         PAL_ERR(LOG_TAG, "payloadInfo alloc failed %s", strerror(errno));
         return;
@@ -2018,7 +2501,7 @@ void PayloadBuilder::payloadCopV2DepackConfig(uint8_t** payload, size_t* size,
 
     padBytes = PAL_PADDING_8BYTE_ALIGN(payloadSize);
 
-    payloadInfo = new uint8_t[payloadSize + padBytes]();
+    payloadInfo = allocPayload(payloadSize + padBytes);
     if (!payloadInfo) {
         PAL_ERR(LOG_TAG, "payloadInfo alloc failed %s", strerror(errno));
         return;
@@ -2103,7 +2586,6 @@ int PayloadBuilder::populateStreamKV(Stream* s, std::vector<std::pair<int,int>>
 {
     int status = 0;
     struct pal_stream_attributes *sattr = NULL;
-    std::vector<std::string> selector_names;
     std::vector<std::pair<selector_type_t, std::string>> filled_selector_pairs;
 
 
@@ -2137,10 +2619,7 @@ int PayloadBuilder::populateStreamKV(Stream* s, std::vector<std::pair<int,int>>
         } else if (sattr->info.opt_stream_info.loopback_type == PAL_STREAM_LOOPBACK_HFP_TX) {
            /* no StreamKV for HFP TX */
         } else {
-            selector_names = retrieveSelectors(sattr->type, all_streams);
-            if (selector_names.empty() != true)
-               filled_selector_pairs = getSelectorValues(selector_names, s, NULL);
-            retrieveKVs(filled_selector_pairs ,sattr->type, all_streams, keyVectorRx);
+            resolveKVs(sattr->type, all_streams, s, NULL, keyVectorRx);
         }
     } else if (sattr->type == PAL_STREAM_VOICE_CALL) {
         filled_selector_pairs.push_back(std::make_pair(DIRECTION_SEL, "RX"));
@@ -2169,8 +2648,6 @@ int PayloadBuilder::populateStreamPPKV(Stream* s, std::vector <std::pair<int,int
 {
     int status = 0;
     struct pal_stream_attributes *sattr = NULL;
-    std::vector <std::string> selectors;
-    std::vector <std::pair<selector_type_t, std::string>> filled_selector_pairs;
 
     PAL_DBG(LOG_TAG, "Enter");
     sattr = new struct pal_stream_attributes();
@@ -2189,10 +2666,7 @@ int PayloadBuilder::populateStreamPPKV(Stream* s, std::vector <std::pair<int,int
     PAL_INFO(LOG_TAG, "stream type %d", sattr->type);
 
     if (sattr->type == PAL_STREAM_VOICE_CALL) {
-        selectors = retrieveSelectors(sattr->type, all_streampps);
-        if (selectors.empty() != true)
-            filled_selector_pairs = getSelectorValues(selectors, s, NULL);
-        retrieveKVs(filled_selector_pairs ,sattr->type, all_streampps, keyVectorRx);
+        resolveKVs(sattr->type, all_streampps, s, NULL, keyVectorRx);
     } else {
         PAL_DBG(LOG_TAG, "KVs not provided for stream type:%d", sattr->type);
     }
@@ -2204,83 +2678,44 @@ exit:
     return status;
 }
 
-bool PayloadBuilder::compareSelectorPairs(
-    std::vector<std::pair<selector_type_t, std::string>>& selector_pairs,
-    std::vector<std::pair<selector_type_t, std::string>>& filled_selector_pairs)
-{
-    int count = 0;
-    bool result = false;
-
-    PAL_DBG(LOG_TAG, "Enter: selector size: %zu filled_sel size: %zu",
-        selector_pairs.size(), filled_selector_pairs.size());
-    if (selector_pairs.size() == filled_selector_pairs.size()) {
-        std::sort(filled_selector_pairs.begin(), filled_selector_pairs.end());
-        std::sort(selector_pairs.begin(), selector_pairs.end());
-        result = std::equal(selector_pairs.begin(), selector_pairs.end(),
-            filled_selector_pairs.begin());
-        if (result) {
-            PAL_DBG(LOG_TAG,"Return True");
-            goto exit;
-        }
-    } else {
-        for (int i = 0; i < filled_selector_pairs.size(); i++) {
-            if (selector_pairs.end() != std::find(selector_pairs.begin(),
-                selector_pairs.end(), filled_selector_pairs[i])) {
-                count++;
-                PAL_DBG(LOG_TAG,"Inside the find loop count=%d", count);
-            }
-        }
-        PAL_DBG(LOG_TAG, "After find count:%d", count);
-        if (filled_selector_pairs.size() == count) {
-            result = true;
-            PAL_DBG(LOG_TAG,"Return True");
-            goto exit;
-        }
-    }
-exit:
-    PAL_DBG(LOG_TAG, "Exit result: %d", result);
-    return result;
-}
-
 bool PayloadBuilder::findKVs(std::vector<std::pair<selector_type_t, std::string>>
     &filled_selector_pairs, uint32_t type, std::vector<allKVs> &any_type,
     std::vector<std::pair<int, int>> &keyVector)
 {
     bool found = false;
-
-    for (int32_t i = 0; i < any_type.size(); i++) {
-        if (isIdTypeAvailable(type, any_type[i].id_type)) {
-            for (int32_t j = 0; j < any_type[i].keys_values.size(); j++) {
-                if (filled_selector_pairs.empty() != true) {
-                    if (compareSelectorPairs(any_type[i].keys_values[j].selector_pairs,
-                           filled_selector_pairs)) {
-                        for (int32_t k = 0; k < any_type[i].keys_values[j].kv_pairs.size(); k++) {
-                            keyVector.push_back(
-                                std::make_pair(any_type[i].keys_values[j].kv_pairs[k].key,
-                                any_type[i].keys_values[j].kv_pairs[k].value));
-                            PAL_INFO(LOG_TAG, "key: 0x%x value: 0x%x\n",
-                                any_type[i].keys_values[j].kv_pairs[k].key,
-                                any_type[i].keys_values[j].kv_pairs[k].value);
-                        }
-                        found = true;
-                        break;
-                    }
-                } else {
-                    if (any_type[i].keys_values[j].selector_pairs.empty()) {
-                        for (int32_t k = 0; k < any_type[i].keys_values[j].kv_pairs.size(); k++) {
-                            keyVector.push_back(
-                                std::make_pair(any_type[i].keys_values[j].kv_pairs[k].key,
-                                any_type[i].keys_values[j].kv_pairs[k].value));
-                            PAL_INFO(LOG_TAG, "key: 0x%x value: 0x%x\n",
-                                any_type[i].keys_values[j].kv_pairs[k].key,
-                                any_type[i].keys_values[j].kv_pairs[k].value);
-                        }
-                        found = true;
-                        break;
-                    }
-                }
-            }
+    kvIndexKey key;
+    std::vector<selector_type_t> selTypes;
+
+    /* getSelectorValues() fills at most one value per selector type */
+    std::lock_guard<std::mutex> lock(kvIndexMutex);
+    key.table = &any_type;
+    key.type = type;
+    for (auto &pair : filled_selector_pairs) {
+        auto id = selectorValueIds.find(pair.second);
+        if (id == selectorValueIds.end()) {
+            PAL_DBG(LOG_TAG, "selector value %s not used by any kv", pair.second.c_str());
+            return false;
         }
+        key.selectors.push_back(std::make_pair(pair.first, id->second));
+    }
+    std::sort(key.selectors.begin(), key.selectors.end());
+    for (auto &sel : key.selectors)
+        selTypes.push_back(sel.first);
+
+    indexKVs(any_type, type, selTypes);
+
+    auto entry = kvIndex.find(key);
+    if (entry == kvIndex.end())
+        return false;
+
+    for (auto info : entry->second) {
+        for (int32_t k = 0; k < info->kv_pairs.size(); k++) {
+            keyVector.push_back(std::make_pair(info->kv_pairs[k].key,
+                info->kv_pairs[k].value));
+            PAL_INFO(LOG_TAG, "key: 0x%x value: 0x%x\n",
+                info->kv_pairs[k].key, info->kv_pairs[k].value);
+        }
+        found = true;
     }
     return found;
 }
@@ -2326,6 +2761,128 @@ exit:
     return status;
 }
 
+/*
+ * Build a key from the stream/device fields getSelectorValues() would read
+ * for these selectors. Returns false when the inputs cannot be read, in
+ * which case the caller resolves without the cache.
+ */
+bool PayloadBuilder::getSelectorCacheKey(std::vector<std::string> &selector_names,
+    Stream *s, struct pal_device *dAttr, std::string &key)
+{
+    struct pal_stream_attributes sattr;
+    std::shared_ptr<ResourceManager> rm = ResourceManager::getInstance();
+    int instance_id = 0;
+
+    if (!s) {
+        /* getSelectorValues() fills nothing without a stream */
+        key.append("|-");
+        return true;
+    }
+
+    memset(&sattr, 0, sizeof(struct pal_stream_attributes));
+    if (s->getStreamAttributes(&sattr))
+        return false;
+
+    for (int i = 0; i < selector_names.size(); i++) {
+        key.push_back('|');
+        switch (selectorstypeLUT.at(selector_names[i])) {
+            case DIRECTION_SEL:
+                key.append(std::to_string(sattr.direction));
+                break;
+            case INSTANCE_SEL:
+                if (sattr.type == PAL_STREAM_VOICE_UI)
+                    instance_id = dynamic_cast<StreamSoundTrigger *>(s)->GetInstanceId();
+                else
+                    instance_id = rm->getStreamInstanceID(s);
+                key.append(std::to_string(instance_id));
+                break;
+            case SUB_TYPE_SEL:
+                key.append(std::to_string(sattr.type) + "," +
+                           std::to_string(sattr.direction) + "," +
+                           std::to_string(sattr.info.opt_stream_info.tx_proxy_type) + "," +
+                           std::to_string(sattr.info.opt_stream_info.loopback_type));
+                break;
+            case VUI_MODULE_TYPE_SEL:
+            case ACD_MODULE_TYPE_SEL:
+                key.append(s->getStreamSelector());
+                break;
+            case DEVICEPP_TYPE_SEL:
+                key.append(s->getDevicePPSelector());
+                break;
+            case STREAM_TYPE_SEL:
+                key.append(std::to_string(sattr.type));
+                break;
+            case AUD_FMT_SEL:
+                key.append(isPalPCMFormat(sattr.out_media_config.aud_fmt_id) ? "P" : "N");
+                break;
+            case CUSTOM_CONFIG_SEL:
+                if (dAttr)
+                    key.append(dAttr->custom_config.custom_key);
+                break;
+            default:
+                break;
+        }
+    }
+    return true;
+}
+
+int PayloadBuilder::resolveKVs(uint32_t type, std::vector<allKVs> &any_type, Stream *s,
+    struct pal_device *dAttr, std::vector<std::pair<int, int>> &keyVector)
+{
+    int status = 0;
+    std::vector<std::string> selectors;
+    std::vector<std::pair<selector_type_t, std::string>> filled_selector_pairs;
+    std::vector<std::pair<int, int>> kvs;
+    std::string key;
+    bool cacheable = false;
+
+    kvCacheMutex.lock();
+    auto sel = kvCacheSelectors.find(std::make_pair(&any_type, type));
+    if (sel != kvCacheSelectors.end()) {
+        selectors = sel->second;
+    } else {
+        selectors = retrieveSelectors(type, any_type);
+        kvCacheSelectors[std::make_pair(&any_type, type)] = selectors;
+    }
+    kvCacheMutex.unlock();
+
+    key = std::to_string((uintptr_t)&any_type) + ":" + std::to_string(type);
+    if (!selectors.empty())
+        cacheable = getSelectorCacheKey(selectors, s, dAttr, key);
+    else
+        cacheable = true;
+
+    if (cacheable) {
+        std::lock_guard<std::mutex> lock(kvCacheMutex);
+        auto it = kvCacheMap.find(key);
+        if (it != kvCacheMap.end()) {
+            kvCacheLru.splice(kvCacheLru.begin(), kvCacheLru, it->second);
+            keyVector.insert(keyVector.end(), it->second->second.kvs.begin(),
+                             it->second->second.kvs.end());
+            PAL_DBG(LOG_TAG, "graph KVs for type %d served from cache", type);
+            return it->second->second.status;
+        }
+    }
+
+    if (!selectors.empty())
+        filled_selector_pairs = getSelectorValues(selectors, s, dAttr);
+    status = retrieveKVs(filled_selector_pairs, type, any_type, kvs);
+    keyVector.insert(keyVector.end(), kvs.begin(), kvs.end());
+
+    if (cacheable) {
+        std::lock_guard<std::mutex> lock(kvCacheMutex);
+        if (kvCacheMap.find(key) == kvCacheMap.end()) {
+            kvCacheLru.emplace_front(key, kvCacheEntry{status, kvs});
+            kvCacheMap[key] = kvCacheLru.begin();
+            if (kvCacheLru.size() > GRAPH_KV_CACHE_MAX_ENTRIES) {
+                kvCacheMap.erase(kvCacheLru.back().first);
+                kvCacheLru.pop_back();
+            }
+        }
+    }
+    return status;
+}
+
 std::vector<std::pair<selector_type_t, std::string>> PayloadBuilder::getSelectorValues(
     std::vector<std::string> &selector_names, Stream* s, struct pal_device* dAttr)
 {
@@ -2525,8 +3082,6 @@ int PayloadBuilder::populateStreamKV(Stream* s,
 {
     int status = -EINVAL;
     struct pal_stream_attributes *sattr = NULL;
-    std::vector <std::string> selectors;
-    std::vector <std::pair<selector_type_t, std::string>> filled_selector_pairs;
 
     PAL_DBG(LOG_TAG, "enter");
     sattr = new struct pal_stream_attributes;
@@ -2543,11 +3098,7 @@ int PayloadBuilder::populateStreamKV(Stream* s,
         goto free_sattr;
     }
     PAL_INFO(LOG_TAG, "stream type %d", sattr->type);
-    selectors = retrieveSelectors(sattr->type, all_streams);
-    if (selectors.empty() != true)
-        filled_selector_pairs = getSelectorValues(selectors, s, NULL);
-
-    retrieveKVs(filled_selector_pairs ,sattr->type, all_streams, keyVector);
+    resolveKVs(sattr->type, all_streams, s, NULL, keyVector);
 
 free_sattr:
     delete sattr;
@@ -2646,8 +3197,6 @@ int PayloadBuilder::populateDeviceKV(Stream* s, int32_t beDevId,
         std::vector <std::pair<int,int>> &keyVector)
 {
     int status = 0;
-    std::vector <std::string> selectors;
-    std::vector <std::pair<selector_type_t, std::string>> filled_selector_pairs;
     struct pal_device dAttr;
     std::shared_ptr<Device> dev = nullptr;
     std::shared_ptr<ResourceManager> rm = ResourceManager::getInstance();
@@ -2676,10 +3225,7 @@ int PayloadBuilder::populateDeviceKV(Stream* s, int32_t beDevId,
         dev = Device::getInstance(&dAttr, rm);
         if (dev) {
             status = dev->getDeviceAttributes(&dAttr);
-            selectors = retrieveSelectors(beDevId, all_devices);
-            if (selectors.empty() != true)
-                filled_selector_pairs = getSelectorValues(selectors, s, &dAttr);
-            retrieveKVs(filled_selector_pairs, beDevId, all_devices, keyVector);
+            resolveKVs(beDevId, all_devices, s, &dAttr, keyVector);
         }
     }
 
@@ -2727,8 +3273,6 @@ int PayloadBuilder::populateDeviceKVTunnel(Stream* s, int32_t beDevId,
         std::vector <std::pair<int,int>> &keyVector)
 {
     int status = 0;
-    std::vector <std::string> selectors;
-    std::vector <std::pair<selector_type_t, std::string>> filled_selector_pairs;
     struct pal_device dAttr;
     std::shared_ptr<ResourceManager> rm = ResourceManager::getInstance();
 
@@ -2745,10 +3289,7 @@ int PayloadBuilder::populateDeviceKVTunnel(Stream* s, int32_t beDevId,
     if (beDevId > 0) {
         memset (&dAttr, 0, sizeof(struct pal_device));
         dAttr.id = (pal_device_id_t)beDevId;
-        selectors = retrieveSelectors(beDevId, all_devices);
-        if (selectors.empty() != true)
-            filled_selector_pairs = getSelectorValues(selectors, s, &dAttr);
-        retrieveKVs(filled_selector_pairs, beDevId, all_devices, keyVector);
+        resolveKVs(beDevId, all_devices, s, &dAttr, keyVector);
     }
 
     PAL_INFO(LOG_TAG, "Exit device id:%d, status %d", beDevId, status);
@@ -2762,8 +3303,6 @@ int PayloadBuilder::populateDevicePPKVTunnel(Stream* s, int32_t rxBeDevId,
     int status = 0;
     struct pal_device dAttr;
     std::shared_ptr<ResourceManager> rm = ResourceManager::getInstance();
-    std::vector <std::string> selectors;
-    std::vector <std::pair<selector_type_t, std::string>> filled_selector_pairs;
 
     /* Populate Rx Device PP KV */
     if (rxBeDevId > 0) {
@@ -2771,12 +3310,7 @@ int PayloadBuilder::populateDevicePPKVTunnel(Stream* s, int32_t rxBeDevId,
         memset (&dAttr, 0, sizeof(struct pal_device));
         dAttr.id = (pal_device_id_t)rxBeDevId;
 
-        selectors = retrieveSelectors(dAttr.id, all_devicepps);
-        if (selectors.empty() != true)
-            filled_selector_pairs = getSelectorValues(selectors, s, &dAttr);
-
-        retrieveKVs(filled_selector_pairs, rxBeDevId, all_devicepps,
-            keyVectorRx);
+        resolveKVs(rxBeDevId, all_devicepps, s, &dAttr, keyVectorRx);
     }
 
     PAL_DBG(LOG_TAG, "Exit, status: %d", status);
@@ -2791,8 +3325,6 @@ int PayloadBuilder::populateDevicePPKV(Stream* s, int32_t rxBeDevId,
     struct pal_device dAttr;
     std::shared_ptr<Device> dev = nullptr;
     std::shared_ptr<ResourceManager> rm = ResourceManager::getInstance();
-    std::vector <std::string> selectors;
-    std::vector <std::pair<selector_type_t, std::string>> filled_selector_pairs;
 
     PAL_DBG(LOG_TAG, "Enter");
 
@@ -2804,17 +3336,10 @@ int PayloadBuilder::populateDevicePPKV(Stream* s, int32_t rxBeDevId,
         dev = Device::getInstance(&dAttr, rm);
         if (dev) {
             status = dev->getDeviceAttributes(&dAttr);
-            selectors = retrieveSelectors(dAttr.id, all_devicepps);
-            if (selectors.empty() != true)
-                filled_selector_pairs = getSelectorValues(selectors, s, &dAttr);
-            retrieveKVs(filled_selector_pairs, rxBeDevId, all_devicepps,
-                keyVectorRx);
+            resolveKVs(rxBeDevId, all_devicepps, s, &dAttr, keyVectorRx);
         }
     }
 
-    filled_selector_pairs.clear();
-    selectors.clear();
-
     /* Populate Tx Device PP KV */
     if (txBeDevId > 0) {
         PAL_INFO(LOG_TAG, "Tx device id:%d", txBeDevId);
@@ -2823,11 +3348,7 @@ int PayloadBuilder::populateDevicePPKV(Stream* s, int32_t rxBeDevId,
         dev = Device::getInstance(&dAttr, rm);
         if (dev) {
             status = dev->getDeviceAttributes(&dAttr);
-            selectors = retrieveSelectors(dAttr.id, all_devicepps);
-            if (selectors.empty() != true)
-                filled_selector_pairs = getSelectorValues(selectors, s, &dAttr);
-            retrieveKVs(filled_selector_pairs, txBeDevId, all_devicepps,
-                keyVectorTx);
+            resolveKVs(txBeDevId, all_devicepps, s, &dAttr, keyVectorTx);
         }
     }
     PAL_DBG(LOG_TAG, "Exit, status: %d", status);
@@ -3411,7 +3932,7 @@ void PayloadBuilder::payloadSPConfig(uint8_t** payload, size_t* size, uint32_t m
                               sizeof(vi_r0t0_cfg_t) * data->num_speakers;
 
                 padBytes = PAL_PADDING_8BYTE_ALIGN(payloadSize);
-                payloadInfo = (uint8_t*) calloc(1, payloadSize + padBytes);
+                payloadInfo = allocPayload(payloadSize + padBytes);
                 if (!payloadInfo) {
                     PAL_ERR(LOG_TAG, "payloadInfo malloc failed %s", strerror(errno));
                     return;
@@ -3444,7 +3965,7 @@ void PayloadBuilder::payloadSPConfig(uint8_t** payload, size_t* size, uint32_t m
                               sizeof(uint32_t) * data->num_speakers;
 
                 padBytes = PAL_PADDING_8BYTE_ALIGN(payloadSize);
-                payloadInfo = (uint8_t*) calloc(1, payloadSize + padBytes);
+                payloadInfo = allocPayload(payloadSize + padBytes);
                 if (!payloadInfo) {
                     PAL_ERR(LOG_TAG, "payloadInfo malloc failed %s", strerror(errno));
                     return;
@@ -3485,7 +4006,7 @@ void PayloadBuilder::payloadSPConfig(uint8_t** payload, size_t* size, uint32_t m
 
                 padBytes = PAL_PADDING_8BYTE_ALIGN(payloadSize);
 
-                payloadInfo = (uint8_t*) calloc(1, payloadSize + padBytes);
+                payloadInfo = allocPayload(payloadSize + padBytes);
                 if (!payloadInfo) {
                     PAL_ERR(LOG_TAG, "payloadInfo malloc failed %s", strerror(errno));
                     return;
@@ -3515,7 +4036,7 @@ void PayloadBuilder::payloadSPConfig(uint8_t** payload, size_t* size, uint32_t m
 
                 padBytes = PAL_PADDING_8BYTE_ALIGN(payloadSize);
 
-                payloadInfo = (uint8_t*) calloc(1, payloadSize + padBytes);
+                payloadInfo = allocPayload(payloadSize + padBytes);
                 if (!payloadInfo) {
                     PAL_ERR(LOG_TAG, "payloadInfo malloc failed %s", strerror(errno));
                     return;
@@ -3539,7 +4060,7 @@ void PayloadBuilder::payloadSPConfig(uint8_t** payload, size_t* size, uint32_t m
 
                 padBytes = PAL_PADDING_8BYTE_ALIGN(payloadSize);
 
-                payloadInfo = (uint8_t*) calloc(1, payloadSize + padBytes);
+                payloadInfo = allocPayload(payloadSize + padBytes);
                 if (!payloadInfo) {
                     PAL_ERR(LOG_TAG, "payloadInfo malloc failed %s", strerror(errno));
                     return;
@@ -3567,7 +4088,7 @@ void PayloadBuilder::payloadSPConfig(uint8_t** payload, size_t* size, uint32_t m
                                     sizeof(vi_th_ftm_cfg_t) * data->num_ch;
 
                 padBytes = PAL_PADDING_8BYTE_ALIGN(payloadSize);
-                payloadInfo = (uint8_t*) calloc(1, payloadSize + padBytes);
+                payloadInfo = allocPayload(payloadSize + padBytes);
                 if (!payloadInfo) {
                     PAL_ERR(LOG_TAG, "payloadInfo malloc failed %s", strerror(errno));
                     return;
@@ -3596,7 +4117,7 @@ void PayloadBuilder::payloadSPConfig(uint8_t** payload, size_t* size, uint32_t m
                                     sizeof(param_id_sp_th_vi_ftm_params_t) +
                                     sizeof(vi_th_ftm_params_t) * data->num_ch;
                 padBytes = PAL_PADDING_8BYTE_ALIGN(payloadSize);
-                payloadInfo = (uint8_t*) calloc(1, payloadSize + padBytes);
+                payloadInfo = allocPayload(payloadSize + padBytes);
                 if (!payloadInfo) {
                     PAL_ERR(LOG_TAG, "payloadInfo malloc failed %s", strerror(errno));
                     return;
@@ -3612,7 +4133,7 @@ void PayloadBuilder::payloadSPConfig(uint8_t** payload, size_t* size, uint32_t m
                                     sizeof(param_id_sp_ex_vi_ftm_params_t) +
                                     sizeof(vi_ex_ftm_params_t) * data->num_ch;
                 padBytes = PAL_PADDING_8BYTE_ALIGN(payloadSize);
-                payloadInfo = (uint8_t*) calloc(1, payloadSize + padBytes);
+                payloadInfo = allocPayload(payloadSize + padBytes);
                 if (!payloadInfo) {
                     PAL_ERR(LOG_TAG, "payloadInfo malloc failed %s", strerror(errno));
                     return;
@@ -3632,7 +4153,7 @@ void PayloadBuilder::payloadSPConfig(uint8_t** payload, size_t* size, uint32_t m
                                     sizeof(uint32_t);
                 padBytes = PAL_PADDING_8BYTE_ALIGN(payloadSize);
 
-                payloadInfo = (uint8_t*) calloc(1, payloadSize + padBytes);
+                payloadInfo = allocPayload(payloadSize + padBytes);
                 if (!payloadInfo) {
                     PAL_ERR(LOG_TAG, "payloadInfo malloc failed %s", strerror(errno));
                     return;
@@ -3659,7 +4180,7 @@ void PayloadBuilder::payloadSPConfig(uint8_t** payload, size_t* size, uint32_t m
                                     (sizeof(cps_reg_wr_values_t) * data->num_spkr);
                 padBytes = PAL_PADDING_8BYTE_ALIGN(payloadSize);
 
-                payloadInfo = (uint8_t*) calloc(1, payloadSize + padBytes);
+                payloadInfo = allocPayload(payloadSize + padBytes);
                 if (!payloadInfo) {
                     PAL_ERR(LOG_TAG, "payloadInfo malloc failed %s", strerror(errno));
                     return;
@@ -3681,7 +4202,7 @@ void PayloadBuilder::payloadSPConfig(uint8_t** payload, size_t* size, uint32_t m
                                 sizeof(param_id_sp_vi_ch_enable_t) +
                                 (sizeof(int32_t) * data->num_ch);
                 padBytes = PAL_PADDING_8BYTE_ALIGN(payloadSize);
-                payloadInfo = (uint8_t*) calloc(1, payloadSize + padBytes);
+                payloadInfo = allocPayload(payloadSize + padBytes);
                 if (!payloadInfo) {
                     PAL_ERR(LOG_TAG, "payloadInfo malloc failed %s",
                                                             strerror(errno));
@@ -3705,7 +4226,7 @@ void PayloadBuilder::payloadSPConfig(uint8_t** payload, size_t* size, uint32_t m
                                 sizeof(param_id_sp_rx_ch_enable_t) +
                                 (sizeof(int32_t) * data->num_ch);
                 padBytes = PAL_PADDING_8BYTE_ALIGN(payloadSize);
-                payloadInfo = (uint8_t*) calloc(1, payloadSize + padBytes);
+                payloadInfo = allocPayload(payloadSize + padBytes);
                 if (!payloadInfo) {
                     PAL_ERR(LOG_TAG, "payloadInfo malloc failed %s",
                                                             strerror(errno));
@@ -434,6 +434,95 @@ int Session::freeCustomPayload()
     return 0;
 }
 
+/*
+ * Param batch: apm_module_param_data_t blocks for several modules are packed
+ * back to back (8 byte aligned) and sent with a single setParam, so that a
+ * device bring-up or an effect toggle touching N modules costs one round
+ * trip to AGM/GSL instead of N.
+ */
+int Session::beginParamBatch()
+{
+    if (paramBatchOpen)
+        PAL_ERR(LOG_TAG, "dropping unfinished param batch of %u modules", paramBatchCount);
+
+    paramBatch.clear();
+    paramBatchCount = 0;
+    paramBatchOpen = true;
+    return 0;
+}
+
+int Session::addParamToBatch(void *payload, size_t size)
+{
+    struct apm_module_param_data_t *header = NULL;
+    size_t offset = 0, blockSize = 0, oldSize = 0;
+    uint32_t count = 0;
+
+    if (!paramBatchOpen) {
+        PAL_ERR(LOG_TAG, "no param batch open");
+        return -EINVAL;
+    }
+
+    if (!payload || !size)
+        return 0;
+
+    /* payload may hold several blocks, e.g. a customPayload, make sure it parses */
+    while (offset < size) {
+        if (size - offset < sizeof(struct apm_module_param_data_t)) {
+            PAL_ERR(LOG_TAG, "truncated param header at offset %zu size %zu",
+                    offset, size);
+            return -EINVAL;
+        }
+        header = (struct apm_module_param_data_t *)((uint8_t *)payload + offset);
+        blockSize = sizeof(struct apm_module_param_data_t) + header->param_size;
+        if (blockSize > size - offset) {
+            PAL_ERR(LOG_TAG, "param 0x%x size %u exceeds payload at offset %zu",
+                    header->param_id, header->param_size, offset);
+            return -EINVAL;
+        }
+        /* last block may come without its trailing padding */
+        blockSize = std::min(PAL_ALIGN_8BYTE(blockSize), size - offset);
+        offset += blockSize;
+        count++;
+    }
+
+    oldSize = paramBatch.size();
+    paramBatch.resize(oldSize + PAL_ALIGN_8BYTE(size), 0);
+    memcpy(paramBatch.data() + oldSize, payload, size);
+    paramBatchCount += count;
+    return 0;
+}
+
+int Session::commitParamBatch(struct mixer *mixer, int device)
+{
+    int status = 0;
+
+    if (!paramBatchOpen) {
+        PAL_ERR(LOG_TAG, "no param batch open");
+        return -EINVAL;
+    }
+
+    if (!paramBatch.empty()) {
+        PAL_DBG(LOG_TAG, "setting %u modules in one call, size %zu",
+                paramBatchCount, paramBatch.size());
+        status = SessionAlsaUtils::setMixerParameter(mixer, device,
+                                                     paramBatch.data(),
+                                                     paramBatch.size());
+        if (status)
+            PAL_ERR(LOG_TAG, "batched setParam of %u modules failed %d",
+                    paramBatchCount, status);
+    }
+
+    abortParamBatch();
+    return status;
+}
+
+void Session::abortParamBatch()
+{
+    paramBatch.clear();
+    paramBatchCount = 0;
+    paramBatchOpen = false;
+}
+
 int Session::pause(Stream * s __unused)
 {
     return 0;
@@ -470,10 +559,12 @@ int Session::handleDeviceRotation(Stream *s, pal_speaker_rotation_type rotation_
             return status;
         }
 
+        beginParamBatch();
         for (int i = 0; i < associatedDevices.size(); i++) {
              status = associatedDevices[i]->getDeviceAttributes(&dAttr);
              if (0 != status) {
                  PAL_ERR(LOG_TAG, "get Device Attributes Failed\n");
+                 abortParamBatch();
                  return status;
              }
 
@@ -497,6 +588,7 @@ int Session::handleDeviceRotation(Stream *s, pal_speaker_rotation_type rotation_
                                                               mfc_tag, &miid);
                 if (status != 0) {
                     PAL_ERR(LOG_TAG, "getModuleInstanceId failed");
+                    abortParamBatch();
                     return status;
                 }
                 PAL_DBG(LOG_TAG, "miid : %x id = %d, data %s, dev id = %d\n", miid,
@@ -517,24 +609,22 @@ int Session::handleDeviceRotation(Stream *s, pal_speaker_rotation_type rotation_
                                            &alsaPayloadSize, miid, &deviceData);
 
                 if (alsaPayloadSize) {
-                    status = updateCustomPayload(alsaParamData, alsaPayloadSize);
-                    delete alsaParamData;
+                    status = addParamToBatch(alsaParamData, alsaPayloadSize);
+                    builder->releasePayload(&alsaParamData, &alsaPayloadSize);
                     if (0 != status) {
-                        PAL_ERR(LOG_TAG, "updateCustomPayload Failed\n");
+                        PAL_ERR(LOG_TAG, "addParamToBatch Failed\n");
+                        abortParamBatch();
                         return status;
                     }
                 }
-                status = SessionAlsaUtils::setMixerParameter(mixer,
-                                                             device,
-                                                             customPayload,
-                                                             customPayloadSize);
-                freeCustomPayload();
-                if (status != 0) {
-                    PAL_ERR(LOG_TAG, "setMixerParameter failed");
-                    return status;
-                }
             }
         }
+        /* one setParam for the MFCs of all speaker backends */
+        status = commitParamBatch(mixer, device);
+        if (status != 0) {
+            PAL_ERR(LOG_TAG, "setMixerParameter failed");
+            return status;
+        }
     }
     return status;
 }
@@ -669,7 +759,7 @@ int Session::configureMFC(const std::shared_ptr<ResourceManager>& rm, struct pal
                 goto exit;
             }
             status = updateCustomPayload(payload, payloadSize);
-            freeCustomPayload(&payload, &payloadSize);
+            builder->releasePayload(&payload, &payloadSize);
             if (0 != status) {
                 PAL_ERR(LOG_TAG, "updateCustomPayload Failed\n");
                 goto exit;
@@ -745,7 +835,7 @@ int Session::configureMFC(const std::shared_ptr<ResourceManager>& rm, struct pal
         }
 
         status = updateCustomPayload(payload, payloadSize);
-        freeCustomPayload(&payload, &payloadSize);
+        builder->releasePayload(&payload, &payloadSize);
         if (0 != status) {
             PAL_ERR(LOG_TAG, "updateCustomPayload Failed\n");
             goto exit;
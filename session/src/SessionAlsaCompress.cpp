@@ -576,7 +576,7 @@ int SessionAlsaCompress::setCustomFormatParam(pal_audio_fmt_t audio_fmt)
             }
             status = SessionAlsaUtils::setMixerParameter(mixer,
                             compressDevIds.at(0), payload, payloadSize);
-            freeCustomPayload(&payload, &payloadSize);
+            builder->releasePayload(&payload, &payloadSize);
             if (status != 0) {
                 PAL_ERR(LOG_TAG, "setMixerParameter failed");
                 return status;
@@ -588,32 +588,38 @@ int SessionAlsaCompress::setCustomFormatParam(pal_audio_fmt_t audio_fmt)
 
 void SessionAlsaCompress::offloadThreadLoop(SessionAlsaCompress* compressObj)
 {
-    std::shared_ptr<offload_msg> msg;
+    struct offload_msg msg;
     uint32_t event_id = 0;
     int ret = 0;
     bool is_drain_called = false;
     std::unique_lock<std::mutex> lock(compressObj->cv_mutex_);
 
     while (1) {
-        if (compressObj->msg_queue_.empty())
+        if (compressObj->msg_count_ == 0)
             compressObj->cv_.wait(lock);  /* wait for incoming requests */
 
-        if (!compressObj->msg_queue_.empty()) {
-            msg = compressObj->msg_queue_.front();
-            compressObj->msg_queue_.pop();
+        if (compressObj->msg_count_ != 0) {
+            msg = compressObj->msg_queue_[compressObj->msg_head_];
+            compressObj->msg_head_ =
+                (compressObj->msg_head_ + 1) % OFFLOAD_MSG_QUEUE_SIZE;
+            compressObj->msg_count_--;
             lock.unlock();
 
-            if (msg && msg->cmd == OFFLOAD_CMD_EXIT)
+            if (msg.cmd == OFFLOAD_CMD_EXIT)
                 break; // exit the thread
 
-            if (msg && msg->cmd == OFFLOAD_CMD_WAIT_FOR_BUFFER) {
+            if (msg.cmd == OFFLOAD_CMD_WAIT_FOR_BUFFER) {
                 if (compressObj->rm->cardState == CARD_STATUS_ONLINE) {
                     PAL_VERBOSE(LOG_TAG, "calling compress_wait");
                     ret = compress_wait(compressObj->compress, -1);
                     PAL_VERBOSE(LOG_TAG, "out of compress_wait, ret %d", ret);
                     event_id = PAL_STREAM_CBK_EVENT_WRITE_READY;
                 }
-            } else if (msg && msg->cmd == OFFLOAD_CMD_DRAIN) {
+                /* writes failing from here on need a new wait */
+                lock.lock();
+                compressObj->wait_for_buffer_pending_ = false;
+                lock.unlock();
+            } else if (msg.cmd == OFFLOAD_CMD_DRAIN) {
                 if (!is_drain_called) {
                     PAL_INFO(LOG_TAG, "calling compress_drain");
                     if (compressObj->rm->cardState == CARD_STATUS_ONLINE &&
@@ -629,7 +635,7 @@ void SessionAlsaCompress::offloadThreadLoop(SessionAlsaCompress* compressObj)
                 }
                 is_drain_called = false;
                 event_id = PAL_STREAM_CBK_EVENT_DRAIN_READY;
-            } else if (msg && msg->cmd == OFFLOAD_CMD_PARTIAL_DRAIN) {
+            } else if (msg.cmd == OFFLOAD_CMD_PARTIAL_DRAIN) {
                 if (compressObj->rm->cardState == CARD_STATUS_ONLINE) {
                     if (compressObj->isGaplessFmt) {
                         PAL_DBG(LOG_TAG, "calling partial compress_drain");
@@ -653,7 +659,7 @@ void SessionAlsaCompress::offloadThreadLoop(SessionAlsaCompress* compressObj)
                     lock.lock();
                     continue;
                 }
-            }  else if (msg && msg->cmd == OFFLOAD_CMD_ERROR) {
+            }  else if (msg.cmd == OFFLOAD_CMD_ERROR) {
                 PAL_ERR(LOG_TAG, "Sending error to PAL client");
                 event_id = PAL_STREAM_CBK_EVENT_ERROR;
             }
@@ -667,6 +673,31 @@ void SessionAlsaCompress::offloadThreadLoop(SessionAlsaCompress* compressObj)
     PAL_DBG(LOG_TAG, "exit offloadThreadLoop");
 }
 
+int SessionAlsaCompress::postOffloadMsg(int cmd)
+{
+    std::lock_guard<std::mutex> lock(cv_mutex_);
+
+    if (cmd == OFFLOAD_CMD_WAIT_FOR_BUFFER) {
+        /* one wait already covers every write that found the buffer full */
+        if (wait_for_buffer_pending_)
+            return 0;
+        wait_for_buffer_pending_ = true;
+    }
+
+    if (msg_count_ == OFFLOAD_MSG_QUEUE_SIZE) {
+        PAL_ERR(LOG_TAG, "offload msg queue full, dropping cmd %d", cmd);
+        if (cmd == OFFLOAD_CMD_WAIT_FOR_BUFFER)
+            wait_for_buffer_pending_ = false;
+        return -ENOSPC;
+    }
+
+    msg_queue_[(msg_head_ + msg_count_) % OFFLOAD_MSG_QUEUE_SIZE].cmd = cmd;
+    msg_count_++;
+    cv_.notify_all();
+
+    return 0;
+}
+
 SessionAlsaCompress::SessionAlsaCompress(std::shared_ptr<ResourceManager> Rm)
 {
     rm = Rm;
@@ -684,6 +715,9 @@ SessionAlsaCompress::SessionAlsaCompress(std::shared_ptr<ResourceManager> Rm)
     sessionCb = NULL;
     this->cbCookie = 0;
     playback_started = false;
+    msg_head_ = 0;
+    msg_count_ = 0;
+    wait_for_buffer_pending_ = false;
     capture_started = false;
     playback_paused = false;
     capture_paused = false;
@@ -1067,6 +1101,9 @@ int SessionAlsaCompress::setConfig(Stream * s, configType type, int tag)
     int ckv_size = 0;
 
     PAL_DBG(LOG_TAG, "Enter");
+    /* session time stops and restarts across pause */
+    if (tag == PAUSE_TAG || tag == RESUME_TAG)
+        tsClock.reset();
     status = s->getStreamAttributes(&sAttr);
     if (0 != status) {
         PAL_ERR(LOG_TAG, "getStreamAttributes Failed \n");
@@ -1220,7 +1257,7 @@ int SessionAlsaCompress::configureEarlyEOSDelay(void)
     }
     if (payloadSize) {
         status = updateCustomPayload(payload, payloadSize);
-        freeCustomPayload(&payload, &payloadSize);
+        builder->releasePayload(&payload, &payloadSize);
         if(0 != status) {
             PAL_ERR(LOG_TAG, "%s: updateCustomPayload Failed\n", __func__);
             return status;
@@ -1248,6 +1285,7 @@ int SessionAlsaCompress::start(Stream * s)
     memset(&streamData, 0, sizeof(struct sessionToPayloadParam));
 
     PAL_DBG(LOG_TAG, "Enter");
+    tsClock.reset();
 
     rm->voteSleepMonitor(s, true);
     s->getStreamAttributes(&sAttr);
@@ -1397,7 +1435,7 @@ int SessionAlsaCompress::start(Stream * s)
             builder->payloadMFCConfig(&payload, &payloadSize, miid, &streamData);
             if (payloadSize && payload) {
                 status = updateCustomPayload(payload, payloadSize);
-                freeCustomPayload(&payload, &payloadSize);
+                builder->releasePayload(&payload, &payloadSize);
                 if (0 != status) {
                     PAL_ERR(LOG_TAG, "updateCustomPayload Failed\n");
                     goto exit;
@@ -1464,6 +1502,7 @@ int SessionAlsaCompress::pause(Stream * s )
     int32_t status = 0;
 
     PAL_DBG(LOG_TAG, "Enter");
+    tsClock.reset();
 
     if (compress && playback_started) {
         status = compress_pause(compress);
@@ -1479,6 +1518,7 @@ int SessionAlsaCompress::resume(Stream * s __unused)
     int32_t status = 0;
 
     PAL_DBG(LOG_TAG, "Enter");
+    tsClock.reset();
 
     if (compress && playback_paused) {
         status = compress_resume(compress);
@@ -1497,6 +1537,7 @@ int SessionAlsaCompress::stop(Stream * s __unused)
     struct pal_stream_attributes sAttr;
 
     PAL_DBG(LOG_TAG, "Enter");
+    tsClock.reset();
     status = s->getStreamAttributes(&sAttr);
     if (status != 0) {
         PAL_ERR(LOG_TAG, "stream get attributes failed");
@@ -1582,16 +1623,14 @@ int SessionAlsaCompress::close(Stream * s)
     }
     if (compress) {
         compress_close(compress);
-        if (rm->cardState == CARD_STATUS_OFFLINE) {
-            std::shared_ptr<offload_msg> msg = std::make_shared<offload_msg>(OFFLOAD_CMD_ERROR);
-            std::lock_guard<std::mutex> lock(cv_mutex_);
-            msg_queue_.push(msg);
-            cv_.notify_all();
-        }
-        {
-            std::shared_ptr<offload_msg> msg = std::make_shared<offload_msg>(OFFLOAD_CMD_EXIT);
+        if (rm->cardState == CARD_STATUS_OFFLINE)
+            postOffloadMsg(OFFLOAD_CMD_ERROR);
+        if (postOffloadMsg(OFFLOAD_CMD_EXIT)) {
+            /* the exit request must get through, drop what is pending */
             std::lock_guard<std::mutex> lock(cv_mutex_);
-            msg_queue_.push(msg);
+            msg_head_ = 0;
+            msg_queue_[0].cmd = OFFLOAD_CMD_EXIT;
+            msg_count_ = 1;
             cv_.notify_all();
         }
 
@@ -1600,8 +1639,9 @@ int SessionAlsaCompress::close(Stream * s)
         worker_thread.reset(NULL);
 
         /* empty the pending messages in queue */
-        while (!msg_queue_.empty())
-            msg_queue_.pop();
+        msg_head_ = 0;
+        msg_count_ = 0;
+        wait_for_buffer_pending_ = false;
     }
     PAL_DBG(LOG_TAG, "out of compress close");
 
@@ -1722,11 +1762,7 @@ int SessionAlsaCompress::write(Stream *s __unused, int tag __unused, struct pal_
 
     if (bytes_written >= 0 && bytes_written < (ssize_t)buf->size && non_blocking) {
         PAL_DBG(LOG_TAG, "No space available in compress driver, post msg to cb thread");
-        std::shared_ptr<offload_msg> msg = std::make_shared<offload_msg>(OFFLOAD_CMD_WAIT_FOR_BUFFER);
-        std::lock_guard<std::mutex> lock(cv_mutex_);
-        msg_queue_.push(msg);
-
-        cv_.notify_all();
+        postOffloadMsg(OFFLOAD_CMD_WAIT_FOR_BUFFER);
     }
 
     if (!playback_started && bytes_written > 0) {
@@ -1839,7 +1875,7 @@ int SessionAlsaCompress::setParameters(Stream *s __unused, int tagId, uint32_t p
                                                              alsaParamData,
                                                              alsaPayloadSize);
                 PAL_INFO(LOG_TAG, "mixer set param status=%d\n", status);
-                freeCustomPayload(&alsaParamData, &alsaPayloadSize);
+                builder->releasePayload(&alsaParamData, &alsaPayloadSize);
             }
             break;
         }
@@ -1960,7 +1996,7 @@ int SessionAlsaCompress::setParameters(Stream *s __unused, int tagId, uint32_t p
                 status = SessionAlsaUtils::setMixerParameter(mixer, device,
                                                alsaParamData, alsaPayloadSize);
                 PAL_INFO(LOG_TAG, "mixer set volume config status=%d\n", status);
-                freeCustomPayload(&alsaParamData, &alsaPayloadSize);
+                builder->releasePayload(&alsaParamData, &alsaPayloadSize);
             }
             break;
         }
@@ -1984,6 +2020,7 @@ int SessionAlsaCompress::flush()
 {
     int status = 0;
     PAL_VERBOSE(LOG_TAG, "Enter flush");
+    tsClock.reset();
 
     if (playback_started) {
         if (compressDevIds.size() > 0) {
@@ -2000,8 +2037,6 @@ int SessionAlsaCompress::flush()
 
 int SessionAlsaCompress::drain(pal_drain_type_t type)
 {
-    std::shared_ptr<offload_msg> msg;
-
     if (!compress) {
        PAL_ERR(LOG_TAG, "compress is invalid");
        return -EINVAL;
@@ -2011,22 +2046,12 @@ int SessionAlsaCompress::drain(pal_drain_type_t type)
 
     switch (type) {
     case PAL_DRAIN:
-    {
-        msg = std::make_shared<offload_msg>(OFFLOAD_CMD_DRAIN);
-        std::lock_guard<std::mutex> drain_lock(cv_mutex_);
-        msg_queue_.push(msg);
-        cv_.notify_all();
-    }
-    break;
+        postOffloadMsg(OFFLOAD_CMD_DRAIN);
+        break;
 
     case PAL_DRAIN_PARTIAL:
-    {
-        msg = std::make_shared<offload_msg>(OFFLOAD_CMD_PARTIAL_DRAIN);
-        std::lock_guard<std::mutex> partial_lock(cv_mutex_);
-        msg_queue_.push(msg);
-        cv_.notify_all();
-    }
-    break;
+        postOffloadMsg(OFFLOAD_CMD_PARTIAL_DRAIN);
+        break;
 
     default:
         PAL_ERR(LOG_TAG, "invalid drain type = %d", type);
@@ -2044,11 +2069,16 @@ int SessionAlsaCompress::getParameters(Stream *s __unused, int tagId __unused, u
 int SessionAlsaCompress::getTimestamp(struct pal_session_time *stime)
 {
     int status = 0;
+    uint64_t sampleUs = PalTimestampClock::nowUs();
+
     status = SessionAlsaUtils::getTimestamp(mixer, compressDevIds, spr_miid, stime);
     if (0 != status) {
        PAL_ERR(LOG_TAG, "getTimestamp failed status = %d", status);
        return status;
     }
+    /* pair the sample with the middle of the getParam round trip */
+    sampleUs += (PalTimestampClock::nowUs() - sampleUs) / 2;
+    tsClock.update(stime, sampleUs);
     return status;
 }
 
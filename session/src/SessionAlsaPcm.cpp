@@ -79,6 +79,9 @@
 #include "apm_api.h"
 #include "us_detect_api.h"
 #include <sys/ioctl.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <poll.h>
 
 std::mutex SessionAlsaPcm::pcmLpmRefCntMtx;
 int SessionAlsaPcm::pcmLpmRefCnt = 0;
@@ -103,6 +106,9 @@ SessionAlsaPcm::SessionAlsaPcm(std::shared_ptr<ResourceManager> Rm)
    mState = SESSION_IDLE;
    ecRefDevId = PAL_DEVICE_OUT_MIN;
    streamHandle = NULL;
+   sessionCb = NULL;
+   cbCookie = 0;
+   nonBlocking = false;
 }
 
 SessionAlsaPcm::~SessionAlsaPcm()
@@ -424,7 +430,7 @@ uint32_t SessionAlsaPcm::getMIID(const char *backendName, uint32_t tagId, uint32
         }
         device = pcmDevIds.at(0);
     }
-    /* REPLACE THIS WITH STORED INFO DURING INITIAL SETUP */
+    /* served from the SessionAlsaUtils MIID cache after the first lookup */
     if (backendName) {
         status = SessionAlsaUtils::getModuleInstanceId(mixer,
             device, backendName, tagId, miid);
@@ -458,6 +464,10 @@ int SessionAlsaPcm::setConfig(Stream * s, configType type, int tag)
     int tag_config_size = 0;
     int cal_config_size = 0;
 
+    /* session time stops and restarts across soft pause */
+    if (tag == PAUSE_TAG || tag == RESUME_TAG)
+        tsClock.reset();
+
     status = s->getStreamAttributes(&sAttr);
     if (status != 0) {
         PAL_ERR(LOG_TAG, "stream get attributes failed");
@@ -818,6 +828,7 @@ int SessionAlsaPcm::start(Stream * s)
     PAL_DBG(LOG_TAG, "Enter");
 
     rm->voteSleepMonitor(s, true);
+    tsClock.reset();
     status = s->getStreamAttributes(&sAttr);
     if (status != 0) {
         PAL_ERR(LOG_TAG, "stream get attributes failed");
@@ -828,6 +839,10 @@ int SessionAlsaPcm::start(Stream * s)
         s->getBufInfo(&in_buf_size,&in_buf_count,&out_buf_size,&out_buf_count);
         memset(&config, 0, sizeof(config));
 
+        nonBlocking = (sAttr.flags & PAL_STREAM_FLAG_NON_BLOCKING_MASK) &&
+                      !SessionAlsaUtils::isMmapUsecase(sAttr) &&
+                      (sAttr.direction == PAL_AUDIO_INPUT ||
+                       sAttr.direction == PAL_AUDIO_OUTPUT);
         if (sAttr.direction == PAL_AUDIO_INPUT) {
             config.rate = sAttr.in_media_config.sample_rate;
             config.format =
@@ -865,7 +880,8 @@ int SessionAlsaPcm::start(Stream * s)
                     pcm = pcm_open(rm->getVirtualSndCard(), pcmDevIds.at(0),
                         PCM_IN |PCM_MMAP| PCM_NOIRQ, &config);
                 } else {
-                    pcm = pcm_open(rm->getVirtualSndCard(), pcmDevIds.at(0), PCM_IN, &config);
+                    pcm = pcm_open(rm->getVirtualSndCard(), pcmDevIds.at(0),
+                        PCM_IN | (nonBlocking ? PCM_NONBLOCK : 0), &config);
                 }
 
                 if (!pcm) {
@@ -895,7 +911,8 @@ int SessionAlsaPcm::start(Stream * s)
                     pcm = pcm_open(rm->getVirtualSndCard(), pcmDevIds.at(0),
                         PCM_OUT |PCM_MMAP| PCM_NOIRQ, &config);
                 } else {
-                    pcm = pcm_open(rm->getVirtualSndCard(), pcmDevIds.at(0), PCM_OUT, &config);
+                    pcm = pcm_open(rm->getVirtualSndCard(), pcmDevIds.at(0),
+                        PCM_OUT | (nonBlocking ? PCM_NONBLOCK : 0), &config);
                 }
 
                 if (!pcm) {
@@ -944,6 +961,14 @@ int SessionAlsaPcm::start(Stream * s)
         }
         mState = SESSION_OPENED;
 
+        if (nonBlocking) {
+            status = startPcmPollThread(sAttr.direction);
+            if (status) {
+                PAL_ERR(LOG_TAG, "failed to start pcm poll thread %d", status);
+                goto exit;
+            }
+        }
+
         if (SessionAlsaUtils::isMmapUsecase(sAttr) &&
                 !(sAttr.flags & PAL_STREAM_FLAG_MMAP_NO_IRQ_MASK))
             registerAdmStream(s, sAttr.direction, sAttr.flags, pcm, &config);
@@ -1046,7 +1071,7 @@ int SessionAlsaPcm::start(Stream * s)
                 builder->payloadMFCConfig(&payload, &payloadSize, miid, &streamData);
                 if (payloadSize && payload) {
                     status = updateCustomPayload(payload, payloadSize);
-                    freeCustomPayload(&payload, &payloadSize);
+                    builder->releasePayload(&payload, &payloadSize);
                     if (0 != status) {
                         PAL_ERR(LOG_TAG, "updateCustomPayload Failed\n");
                         goto exit;
@@ -1093,7 +1118,7 @@ int SessionAlsaPcm::start(Stream * s)
                         builder->payloadMFCConfig(&payload, &payloadSize, miid, &streamData);
                         if (payloadSize && payload) {
                             status = updateCustomPayload(payload, payloadSize);
-                            freeCustomPayload(&payload, &payloadSize);
+                            builder->releasePayload(&payload, &payloadSize);
                             if (0 != status) {
                                 PAL_ERR(LOG_TAG,"updateCustomPayload Failed\n");
                                 goto set_mixer;
@@ -1103,18 +1128,21 @@ int SessionAlsaPcm::start(Stream * s)
                 }
 
 set_mixer:
-                status = SessionAlsaUtils::setMixerParameter(mixer, pcmDevIds.at(0),
-                                                             customPayload, customPayloadSize);
+                beginParamBatch();
+                status = addParamToBatch(customPayload, customPayloadSize);
                 freeCustomPayload();
                 if (status != 0) {
-                    PAL_ERR(LOG_TAG, "setMixerParameter failed");
+                    PAL_ERR(LOG_TAG, "addParamToBatch failed");
+                    abortParamBatch();
                     goto exit;
                 }
                 if (sAttr.type == PAL_STREAM_VOICE_CALL_RECORD) {
+                    /* RAT render goes out in the same setParam as the stream MFC */
                     status = SessionAlsaUtils::getModuleInstanceId(mixer, pcmDevIds.at(0),
                                                                 "ZERO", RAT_RENDER, &miid);
                     if (status != 0) {
                         PAL_ERR(LOG_TAG, "getModuleInstanceId failed");
+                        abortParamBatch();
                         goto exit;
                     }
                     PAL_INFO(LOG_TAG, "miid : %x id = %d\n", miid, pcmDevIds.at(0));
@@ -1136,20 +1164,21 @@ set_mixer:
                     }
                     builder->payloadRATConfig(&payload, &payloadSize, miid, &codecConfig);
                     if (payloadSize && payload) {
-                        status = updateCustomPayload(payload, payloadSize);
-                        freeCustomPayload(&payload, &payloadSize);
+                        status = addParamToBatch(payload, payloadSize);
+                        builder->releasePayload(&payload, &payloadSize);
                         if (0 != status) {
-                            PAL_ERR(LOG_TAG, "updateCustomPayload Failed\n");
+                            PAL_ERR(LOG_TAG, "addParamToBatch Failed\n");
+                            abortParamBatch();
                             goto exit;
                         }
                     }
-                    status = SessionAlsaUtils::setMixerParameter(mixer, pcmDevIds.at(0),
-                                                                 customPayload, customPayloadSize);
-                    freeCustomPayload();
-                    if (status != 0) {
-                        PAL_ERR(LOG_TAG, "setMixerParameter failed for RAT render");
-                        goto exit;
-                    }
+                }
+                status = commitParamBatch(mixer, pcmDevIds.at(0));
+                if (status != 0) {
+                    PAL_ERR(LOG_TAG, "setMixerParameter failed");
+                    goto exit;
+                }
+                if (sAttr.type == PAL_STREAM_VOICE_CALL_RECORD) {
                     switch (sAttr.info.voice_rec_info.record_direction) {
                         case INCALL_RECORD_VOICE_UPLINK:
                             tagId = INCALL_RECORD_UPLINK;
@@ -1192,7 +1221,7 @@ set_mixer:
                        builder->payloadMFCConfig(&payload, &payloadSize, miid, &streamData);
                        if (payloadSize && payload) {
                            status = updateCustomPayload(payload, payloadSize);
-                           freeCustomPayload(&payload, &payloadSize);
+                           builder->releasePayload(&payload, &payloadSize);
                            if (0 != status) {
                                PAL_ERR(LOG_TAG, "updateCustomPayload Failed\n");
                                goto exit;
@@ -1229,10 +1258,18 @@ set_mixer:
                 PAL_ERR(LOG_TAG, "getAssociatedDevices Failed\n");
                 goto exit;
             }
+            if (pcmDevIds.size() == 0) {
+                PAL_ERR(LOG_TAG, "frontendIDs is not available.");
+                status = -EINVAL;
+                goto exit;
+            }
+            /* MFCs of all backends go to the DSP in one setParam */
+            beginParamBatch();
             for (int i = 0; i < associatedDevices.size();i++) {
                 status = associatedDevices[i]->getDeviceAttributes(&dAttr);
                 if (0 != status) {
                     PAL_ERR(LOG_TAG, "get Device Attributes Failed\n");
+                    abortParamBatch();
                     goto exit;
                 }
 
@@ -1240,23 +1277,24 @@ set_mixer:
                             rxAifBackEnds[i].second.data());
                 if (status != 0) {
                     PAL_ERR(LOG_TAG, "configure MFC failed");
+                    abortParamBatch();
                     goto exit;
                 }
                 if (customPayload) {
-                    if (pcmDevIds.size() == 0) {
-                        PAL_ERR(LOG_TAG, "frontendIDs is not available.");
-                        status = -EINVAL;
-                        goto exit;
-                    }
-                    status = SessionAlsaUtils::setMixerParameter(mixer, pcmDevIds.at(0),
-                                                     customPayload, customPayloadSize);
+                    status = addParamToBatch(customPayload, customPayloadSize);
                     freeCustomPayload();
                     if (status != 0) {
-                        PAL_ERR(LOG_TAG, "setMixerParameter failed");
+                        PAL_ERR(LOG_TAG, "addParamToBatch failed");
+                        abortParamBatch();
                         goto exit;
                     }
                 }
             }
+            status = commitParamBatch(mixer, pcmDevIds.at(0));
+            if (status != 0) {
+                PAL_ERR(LOG_TAG, "setMixerParameter failed");
+                goto exit;
+            }
 
 pcm_start:
             memset(&lpm_info, 0, sizeof(struct disable_lpm_info));
@@ -1422,6 +1460,10 @@ int SessionAlsaPcm::stop(Stream * s)
         PAL_ERR(LOG_TAG, "stream get attributes failed");
         return status;
     }
+    if (nonBlocking)
+        armPcmPoll(false);
+    tsClock.reset();
+
     switch (sAttr.direction) {
         case PAL_AUDIO_INPUT:
             if (pcm && isActive()) {
@@ -1579,6 +1621,7 @@ int SessionAlsaPcm::close(Stream * s)
         }
     }
     freeDeviceMetadata.clear();
+    stopPcmPollThread();
 
     switch (sAttr.direction) {
         case PAL_AUDIO_INPUT:
@@ -1897,6 +1940,24 @@ int SessionAlsaPcm::read(Stream *s, int tag __unused, struct pal_buffer *buf, in
         PAL_ERR(LOG_TAG, "stream get attributes failed");
         return status;
     }
+
+    if (nonBlocking) {
+        uint32_t transferred = 0;
+
+        if (!pcm || buf->offset > buf->size) {
+            PAL_ERR(LOG_TAG, "invalid pcm %pK or buffer offset", pcm);
+            return -EINVAL;
+        }
+        status = pcmTransferNonBlock(PAL_AUDIO_INPUT,
+                static_cast<char *>(buf->buffer) + buf->offset,
+                buf->size - buf->offset, &transferred);
+        if (status)
+            PAL_ERR(LOG_TAG, "non-blocking read failed %d", status);
+        *size = transferred;
+        PAL_VERBOSE(LOG_TAG, "exit bytesRead:%u status:%d ", transferred, status);
+        return status;
+    }
+
     while (1) {
         offset = bytesRead + buf->offset;
         bytesToRead = buf->size - offset;
@@ -1924,6 +1985,8 @@ int SessionAlsaPcm::read(Stream *s, int tag __unused, struct pal_buffer *buf, in
 
         if ((0 != status) || (pcmReadSize == 0)) {
             PAL_ERR(LOG_TAG, "Failed to read data %d bytes read %d", status, pcmReadSize);
+            /* an xrun stalls the session clock */
+            tsClock.reset();
             break;
         }
 
@@ -1958,6 +2021,18 @@ int SessionAlsaPcm::write(Stream *s, int tag, struct pal_buffer *buf, int * size
 
     void *data = nullptr;
 
+    if (nonBlocking) {
+        status = pcmTransferNonBlock(PAL_AUDIO_OUTPUT,
+                static_cast<char *>(buf->buffer) + buf->offset,
+                buf->size, &sizeWritten);
+        if (status) {
+            PAL_ERR(LOG_TAG, "non-blocking write failed %d", status);
+            goto exit;
+        }
+        *size = sizeWritten;
+        goto exit;
+    }
+
     bytesRemaining = buf->size;
 
     while ((bytesRemaining / out_buf_size) > 1) {
@@ -2028,10 +2103,138 @@ int SessionAlsaPcm::write(Stream *s, int tag, struct pal_buffer *buf, int * size
     bytesWritten += sizeWritten;
     *size = bytesWritten;
 exit:
+    /* an xrun stalls the session clock */
+    if (status)
+        tsClock.reset();
     PAL_VERBOSE(LOG_TAG, "exit status: %d", status);
     return status;
 }
 
+/* copy len bytes between the staging buffer and the spans starting at
+ * span idx, offset off; gather copies spans into stage, scatter the reverse
+ */
+static void copyIovec(const struct pal_iovec *iov, uint32_t iovcnt, uint32_t idx,
+                      size_t off, uint8_t *stage, size_t len, bool gather)
+{
+    size_t chunk = 0;
+
+    for (; idx < iovcnt && len; idx++, off = 0) {
+        chunk = std::min(iov[idx].len - off, len);
+        if (gather)
+            ar_mem_cpy(stage, len, iov[idx].base + off, chunk);
+        else
+            ar_mem_cpy(iov[idx].base + off, chunk, stage, chunk);
+        stage += chunk;
+        len -= chunk;
+    }
+}
+
+static void advanceIovec(const struct pal_iovec *iov, uint32_t iovcnt, uint32_t *idx,
+                         size_t *off, size_t len)
+{
+    size_t chunk = 0;
+
+    while (*idx < iovcnt && len) {
+        chunk = std::min(iov[*idx].len - *off, len);
+        *off += chunk;
+        len -= chunk;
+        if (*off == iov[*idx].len) {
+            (*idx)++;
+            *off = 0;
+        }
+    }
+}
+
+/* Transfers the spans period by period. A period that lies inside one span
+ * goes to tinyalsa straight from client memory, only periods straddling a
+ * span boundary are bounced through iovStage.
+ */
+int SessionAlsaPcm::transferv(pal_stream_direction_t dir, const struct pal_iovec *iov,
+                              uint32_t iovcnt, size_t chunkSize, int *size)
+{
+    int status = 0;
+    size_t total = Stream::getIovecSize(iov, iovcnt);
+    size_t done = 0, chunk = 0;
+    uint32_t transferred = 0;
+    uint32_t idx = 0;
+    size_t off = 0;
+    uint8_t *data = NULL;
+    bool staged = false;
+
+    *size = 0;
+    if (!pcm || !chunkSize) {
+        PAL_ERR(LOG_TAG, "invalid pcm %pK or period size %zu", pcm, chunkSize);
+        return -EINVAL;
+    }
+    if (iovStage.size() < chunkSize)
+        iovStage.resize(chunkSize);
+
+    while (done < total) {
+        /* skip empty spans, done < total keeps idx in range */
+        while (off == iov[idx].len) {
+            idx++;
+            off = 0;
+        }
+        chunk = std::min(chunkSize, total - done);
+        staged = (iov[idx].len - off) < chunk;
+        if (!staged) {
+            data = iov[idx].base + off;
+        } else {
+            data = iovStage.data();
+            if (dir == PAL_AUDIO_OUTPUT)
+                copyIovec(iov, iovcnt, idx, off, data, chunk, true);
+        }
+
+        if (nonBlocking) {
+            status = pcmTransferNonBlock(dir, data, chunk, &transferred);
+        } else {
+            if (dir == PAL_AUDIO_INPUT)
+                status = pcm_read(pcm, data, chunk);
+            else
+                status = pcm_write(pcm, data, chunk);
+            transferred = status ? 0 : chunk;
+        }
+        if (status) {
+            PAL_ERR(LOG_TAG, "failed to transfer %zu bytes, status %d", chunk, status);
+            /* an xrun stalls the session clock */
+            tsClock.reset();
+            break;
+        }
+
+        if (staged && dir == PAL_AUDIO_INPUT)
+            copyIovec(iov, iovcnt, idx, off, data, transferred, false);
+        advanceIovec(iov, iovcnt, &idx, &off, transferred);
+        done += transferred;
+        if (transferred < chunk)
+            break;
+    }
+
+    *size = done;
+    return status;
+}
+
+int SessionAlsaPcm::readv(Stream *s __unused, int tag __unused, const struct pal_iovec *iov,
+                          uint32_t iovcnt, int * size)
+{
+    int status = 0;
+
+    PAL_VERBOSE(LOG_TAG, "Enter iovcnt:%u", iovcnt);
+    status = transferv(PAL_AUDIO_INPUT, iov, iovcnt, in_buf_size, size);
+    PAL_VERBOSE(LOG_TAG, "exit bytesRead:%d status:%d", *size, status);
+    return status;
+}
+
+int SessionAlsaPcm::writev(Stream *s __unused, int tag __unused, const struct pal_iovec *iov,
+                           uint32_t iovcnt, int * size, int flag __unused)
+{
+    int status = 0;
+
+    PAL_VERBOSE(LOG_TAG, "Enter iovcnt:%u", iovcnt);
+    status = transferv(PAL_AUDIO_OUTPUT, iov, iovcnt, out_buf_size, size);
+    PAL_VERBOSE(LOG_TAG, "exit bytesWritten:%d status:%d", *size, status);
+    return status;
+}
+
 int SessionAlsaPcm::readBufferInit(Stream * /*streamHandle*/, size_t /*noOfBuf*/, size_t /*bufSize*/,
                                    int /*flag*/)
 {
@@ -2043,6 +2246,191 @@ int SessionAlsaPcm::writeBufferInit(Stream * /*streamHandle*/, size_t /*noOfBuf*
     return 0;
 }
 
+int SessionAlsaPcm::pcmTransferNonBlock(pal_stream_direction_t dir, void *data,
+                                        uint32_t bytes, uint32_t *transferred)
+{
+    int frames = 0;
+    int err = 0;
+    unsigned int reqFrames = pcm_bytes_to_frames(pcm, bytes);
+
+    *transferred = 0;
+    if (!reqFrames)
+        return 0;
+
+    if (dir == PAL_AUDIO_INPUT)
+        frames = pcm_readi(pcm, data, reqFrames);
+    else
+        frames = pcm_writei(pcm, data, reqFrames);
+
+    if (frames < 0) {
+        /* tinyalsa returns either -errno or -1 with errno set */
+        err = (frames == -1) ? errno : -frames;
+        if (err != EAGAIN)
+            return -err;
+        frames = 0;
+    }
+
+    *transferred = pcm_frames_to_bytes(pcm, frames);
+    /* kernel buffer is full (playback) or drained (capture), let the
+     * poll thread tell the client when it can make progress again
+     */
+    if ((unsigned int)frames < reqFrames)
+        armPcmPoll(true);
+
+    return 0;
+}
+
+void SessionAlsaPcm::armPcmPoll(bool arm)
+{
+    uint64_t val = 1;
+
+    if (!pollState)
+        return;
+
+    std::lock_guard<std::mutex> lock(pollState->mutex);
+    if (pollState->armed == arm)
+        return;
+
+    pollState->armed = arm;
+    if (::write(pollState->wakeFd, &val, sizeof(val)) != sizeof(val))
+        PAL_ERR(LOG_TAG, "failed to wake pcm poll thread, errno %d", errno);
+}
+
+SessionAlsaPcm::PcmPollState::~PcmPollState()
+{
+    if (wakeFd >= 0)
+        ::close(wakeFd);
+}
+
+void SessionAlsaPcm::pcmPollThreadLoop(std::shared_ptr<PcmPollState> state,
+                                       int pcmFd, short events, uint32_t eventId)
+{
+    struct pollfd pfd[2];
+    struct pal_event_read_write_done_payload payload;
+    session_callback cb = NULL;
+    uint64_t cookie = 0;
+    uint64_t val = 0;
+    nfds_t nfds = 0;
+    int ret = 0;
+
+    PAL_DBG(LOG_TAG, "Enter pcm fd %d event %d", pcmFd, eventId);
+    memset(&payload, 0, sizeof(payload));
+    pfd[0].fd = state->wakeFd;
+    pfd[0].events = POLLIN;
+    pfd[1].fd = pcmFd;
+    pfd[1].events = events;
+
+    /* once state->exit is set the session may be gone, only state is used */
+    std::unique_lock<std::mutex> lock(state->mutex);
+    while (!state->exit) {
+        /* only watch the pcm fd while a partial transfer is pending,
+         * otherwise a writable playback fd would spin this loop
+         */
+        nfds = state->armed ? 2 : 1;
+        pfd[0].revents = 0;
+        pfd[1].revents = 0;
+        lock.unlock();
+        ret = poll(pfd, nfds, -1);
+        lock.lock();
+
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+            PAL_ERR(LOG_TAG, "poll failed, errno %d", errno);
+            break;
+        }
+
+        if (pfd[0].revents & POLLIN) {
+            if (::read(state->wakeFd, &val, sizeof(val)) != sizeof(val))
+                PAL_ERR(LOG_TAG, "failed to drain wake fd, errno %d", errno);
+            continue;
+        }
+
+        if (nfds < 2 || !state->armed || !pfd[1].revents)
+            continue;
+
+        /* POLLERR means xrun; report readiness anyway so that the next
+         * transfer runs the tinyalsa recovery
+         */
+        if (pfd[1].revents & (POLLERR | POLLNVAL))
+            PAL_ERR(LOG_TAG, "pcm poll error revents 0x%x", pfd[1].revents);
+
+        state->armed = false;
+        cb = sessionCb;
+        cookie = cbCookie;
+        lock.unlock();
+        if (cb)
+            cb(cookie, eventId, (void *)&payload, sizeof(payload));
+        lock.lock();
+    }
+    PAL_DBG(LOG_TAG, "Exit");
+}
+
+int SessionAlsaPcm::startPcmPollThread(pal_stream_direction_t dir)
+{
+    int pcmFd = -1;
+    short events = POLLERR | POLLNVAL;
+    uint32_t eventId = 0;
+    int status = 0;
+
+    if (pollThread.joinable())
+        return 0;
+
+    pcmFd = pcm_get_poll_fd(pcm);
+    if (pcmFd < 0) {
+        PAL_ERR(LOG_TAG, "invalid pcm poll fd");
+        return -EINVAL;
+    }
+
+    pollState = std::make_shared<PcmPollState>();
+    pollState->wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (pollState->wakeFd < 0) {
+        status = -errno;
+        PAL_ERR(LOG_TAG, "eventfd failed, errno %d", errno);
+        pollState.reset();
+        return status;
+    }
+
+    if (dir == PAL_AUDIO_INPUT) {
+        events |= POLLIN;
+        eventId = PAL_STREAM_CBK_EVENT_READ_DONE;
+    } else {
+        events |= POLLOUT;
+        eventId = PAL_STREAM_CBK_EVENT_WRITE_READY;
+    }
+
+    pollThread = std::thread(&SessionAlsaPcm::pcmPollThreadLoop, this,
+                             pollState, pcmFd, events, eventId);
+    return 0;
+}
+
+void SessionAlsaPcm::stopPcmPollThread()
+{
+    uint64_t val = 1;
+
+    if (!pollThread.joinable())
+        return;
+
+    pollState->mutex.lock();
+    pollState->exit = true;
+    pollState->armed = false;
+    if (::write(pollState->wakeFd, &val, sizeof(val)) != sizeof(val))
+        PAL_ERR(LOG_TAG, "failed to wake pcm poll thread, errno %d", errno);
+    pollState->mutex.unlock();
+
+    /* a client closing from its callback runs on the poll thread itself,
+     * joining would deadlock; the loop ends when the callback returns and
+     * the last reference to the state closes the wake fd
+     */
+    if (pollThread.get_id() == std::this_thread::get_id()) {
+        PAL_DBG(LOG_TAG, "stopped from the poll thread, detach it");
+        pollThread.detach();
+    } else {
+        pollThread.join();
+    }
+    pollState.reset();
+}
+
 void SessionAlsaPcm::setEventPayload(uint32_t event_id, void *payload, size_t payload_size)
 {
     eventId = event_id;
@@ -2289,7 +2677,7 @@ int SessionAlsaPcm::setParameters(Stream *streamHandle, int tagId, uint32_t para
                 status = SessionAlsaUtils::setMixerParameter(mixer, device,
                                                paramData, paramSize);
                 PAL_INFO(LOG_TAG, "mixer set volume config status=%d\n", status);
-                freeCustomPayload(&paramData, &paramSize);
+                builder->releasePayload(&paramData, &paramSize);
             }
             return 0;
 
@@ -2642,6 +3030,7 @@ int SessionAlsaPcm::registerCallBack(session_callback cb, uint64_t cookie)
 int SessionAlsaPcm::getTimestamp(struct pal_session_time *stime)
 {
     int status = 0;
+    uint64_t sampleUs = 0;
 
     if (pcmDevIds.size() == 0) {
         PAL_ERR(LOG_TAG, "frontendIDs is not available.");
@@ -2658,9 +3047,15 @@ int SessionAlsaPcm::getTimestamp(struct pal_session_time *stime)
             return status;
         }
     }
+    sampleUs = PalTimestampClock::nowUs();
     status = SessionAlsaUtils::getTimestamp(mixer, pcmDevIds, spr_miid, stime);
-    if (0 != status)
+    if (0 != status) {
        PAL_ERR(LOG_TAG, "getTimestamp failed status = %d", status);
+       return status;
+    }
+    /* pair the sample with the middle of the getParam round trip */
+    sampleUs += (PalTimestampClock::nowUs() - sampleUs) / 2;
+    tsClock.update(stime, sampleUs);
 
     return status;
 }
@@ -55,6 +55,32 @@ static constexpr const char* const COMPRESS_SND_DEV_NAME_PREFIX = "COMPRESS";
 static constexpr const char* const PCM_SND_DEV_NAME_PREFIX = "PCM";
 static constexpr const char* const PCM_SND_VOICE_DEV_NAME_PREFIX = "VOICEMMODE";
 
+std::map<int, SessionAlsaUtils::FeMixerCtls> SessionAlsaUtils::feMixerCtlTable;
+std::mutex SessionAlsaUtils::feMixerCtlTableMutex;
+std::map<std::tuple<int, std::string, int>, uint32_t> SessionAlsaUtils::miidCache;
+std::mutex SessionAlsaUtils::miidCacheMutex;
+uint64_t SessionAlsaUtils::miidCacheGen = 0;
+
+/*
+ * Drops cached MIIDs of the FEs both when a graph change starts and once it
+ * has finished, so a lookup racing with the change can never leave behind
+ * an MIID of the old graph.
+ */
+class MiidCacheGraphChange {
+public:
+    explicit MiidCacheGraphChange(const std::vector<int> &DevIds)
+        : devIds(DevIds)
+    {
+        SessionAlsaUtils::invalidateModuleInstanceIds(devIds);
+    }
+    ~MiidCacheGraphChange()
+    {
+        SessionAlsaUtils::invalidateModuleInstanceIds(devIds);
+    }
+private:
+    const std::vector<int> devIds;
+};
+
 static const char *feCtrlNames[] = {
     " control",
     " metadata",
@@ -330,6 +356,79 @@ struct mixer_ctl *SessionAlsaUtils::getBeMixerControl(struct mixer *am, std::str
     return mixer_get_ctl_by_name(am, cntrlName.str().data());
 }
 
+SessionAlsaUtils::FeMixerCtls *SessionAlsaUtils::resolveFeMixerControlsLocked(
+        struct mixer *mixer, int device)
+{
+    std::ostringstream cntrlName;
+    char *pcmDeviceName = NULL;
+    FeMixerCtls *entry = NULL;
+    std::shared_ptr<ResourceManager> rm = ResourceManager::getInstance();
+
+    auto it = feMixerCtlTable.find(device);
+    if (it != feMixerCtlTable.end() && it->second.mixer == mixer)
+        return &it->second;
+
+    pcmDeviceName = rm->getDeviceNameFromID(device);
+    if (!pcmDeviceName) {
+        PAL_ERR(LOG_TAG, "Device name from id %d not found", device);
+        return NULL;
+    }
+
+    entry = &feMixerCtlTable[device];
+    entry->mixer = mixer;
+    for (uint32_t i = FE_CONTROL; i < FE_MAX_NUM_MIXER_CONTROLS; i++) {
+        cntrlName.str("");
+        cntrlName << pcmDeviceName << feCtrlNames[i];
+        /* not every FE exposes every control family, keep NULL for those */
+        entry->ctls[i] = mixer_get_ctl_by_name(mixer, cntrlName.str().data());
+    }
+    PAL_DBG(LOG_TAG, "resolved mixer controls for %s", pcmDeviceName);
+
+    return entry;
+}
+
+int SessionAlsaUtils::resolveFeMixerControls(struct mixer *mixer, const std::vector<int> &DevIds)
+{
+    int status = 0;
+
+    if (!mixer) {
+        PAL_ERR(LOG_TAG, "invalid mixer");
+        return -EINVAL;
+    }
+
+    std::lock_guard<std::mutex> lock(feMixerCtlTableMutex);
+    for (auto device : DevIds) {
+        if (!resolveFeMixerControlsLocked(mixer, device))
+            status = -EINVAL;
+    }
+    return status;
+}
+
+struct mixer_ctl *SessionAlsaUtils::getFeMixerControlById(struct mixer *mixer, int device,
+        FeCtrlsIndex idx)
+{
+    FeMixerCtls *entry = NULL;
+    struct mixer_ctl *ctl = NULL;
+
+    if (!mixer || idx >= FE_MAX_NUM_MIXER_CONTROLS)
+        return NULL;
+
+    std::lock_guard<std::mutex> lock(feMixerCtlTableMutex);
+    entry = resolveFeMixerControlsLocked(mixer, device);
+    if (entry)
+        ctl = entry->ctls[idx];
+    if (!ctl)
+        PAL_ERR(LOG_TAG, "Invalid mixer control:%s for FE %d", feCtrlNames[idx], device);
+
+    return ctl;
+}
+
+void SessionAlsaUtils::clearFeMixerControls()
+{
+    std::lock_guard<std::mutex> lock(feMixerCtlTableMutex);
+    feMixerCtlTable.clear();
+}
+
 int SessionAlsaUtils::open(Stream * streamHandle, std::shared_ptr<ResourceManager> rmHandle,
     const std::vector<int> &DevIds, const std::vector<std::pair<int32_t, std::string>> &BackEnds)
 {
@@ -359,6 +458,8 @@ int SessionAlsaUtils::open(Stream * streamHandle, std::shared_ptr<ResourceManage
     struct pal_device dAttr;
     PayloadBuilder* builder = nullptr;
 
+    MiidCacheGraphChange miidGuard(DevIds);
+
     PAL_DBG(LOG_TAG, "Entry \n");
 
     memset(&dAttr, 0, sizeof(pal_device));
@@ -573,6 +674,8 @@ int SessionAlsaUtils::close(Stream * streamHandle, std::shared_ptr<ResourceManag
     struct mixer_ctl *beMetaDataMixerCtrl = nullptr;
     struct mixer *mixerHandle = nullptr;
 
+    MiidCacheGraphChange miidGuard(DevIds);
+
     status = streamHandle->getStreamAttributes(&sAttr);
     if(0 != status) {
         PAL_ERR(LOG_TAG, "getStreamAttributes Failed \n");
@@ -970,35 +1073,21 @@ int SessionAlsaUtils::getTimestamp(struct mixer *mixer, const std::vector<int> &
                                    uint32_t spr_miid, struct pal_session_time *stime)
 {
     int status = 0;
-    const char *getParamControl = "getParam";
-    char *pcmDeviceName = NULL;
-    std::ostringstream CntrlName;
     struct mixer_ctl *ctl;
     struct param_id_spr_session_time_t *spr_session_time;
     std::shared_ptr<std::vector<uint8_t>> payload = nullptr;
     size_t payloadSize = 0;
-    std::shared_ptr<ResourceManager> rm = ResourceManager::getInstance();
 
-    if (DevIds.size() > 0) {
-        pcmDeviceName = rm->getDeviceNameFromID(DevIds.at(0));
-    } else {
+    if (DevIds.size() <= 0) {
         PAL_ERR(LOG_TAG, "DevIds size is invalid");
         return -EINVAL;
     }
 
-    if(!pcmDeviceName){
-        PAL_ERR(LOG_TAG, "Device name from id not found");
-        return -EINVAL;
-    }
-    CntrlName<<pcmDeviceName<<" "<<getParamControl;
-    ctl = mixer_get_ctl_by_name(mixer, CntrlName.str().data());
-    if (!ctl) {
-        PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", CntrlName.str().data());
+    ctl = getFeMixerControlById(mixer, DevIds.at(0), FE_GETPARAM);
+    if (!ctl)
         return -ENOENT;
-    }
 
-    PayloadBuilder* builder = new PayloadBuilder();
-    builder->payloadTimestamp(payload, &payloadSize, spr_miid);
+    PayloadBuilder::payloadTimestamp(payload, &payloadSize, spr_miid);
     if (!payload) {
         PAL_ERR(LOG_TAG, "Timestamp payload formation failed");
         status = -EINVAL;
@@ -1025,63 +1114,53 @@ int SessionAlsaUtils::getTimestamp(struct mixer *mixer, const std::vector<int> &
     stime->timestamp.value_msw = spr_session_time->timestamp.value_msw;
     //flags from Spf are igonred
 exit:
-    if(builder) {
-       delete builder;
-       builder = NULL;
-    }
     return status;
 }
 
 int SessionAlsaUtils::getModuleInstanceId(struct mixer *mixer, int device, const char *intf_name,
                        int tag_id, uint32_t *miid)
 {
-    char *pcmDeviceName = NULL;
-    char const *control = "getTaggedInfo";
-    char *mixer_str;
     struct mixer_ctl *ctl;
-    int ctl_len = 0,ret = 0, i;
+    int ret = 0, i;
     void *payload;
     struct gsl_tag_module_info *tag_info;
     struct gsl_tag_module_info_entry *tag_entry;
     int offset = 0;
-    std::shared_ptr<ResourceManager> rm = ResourceManager::getInstance();
-
-    pcmDeviceName = rm->getDeviceNameFromID(device);
-    if(!pcmDeviceName){
-        PAL_ERR(LOG_TAG, "Device name from id %d not found", device);
-        return -EINVAL;
-    }
 
     ret = setStreamMetadataType(mixer, device, intf_name);
     if (ret)
         return ret;
 
-    ctl_len = strlen(pcmDeviceName) + 1 + strlen(control) + 1;
-    mixer_str = (char *)calloc(1, ctl_len);
-    if (!mixer_str)
-        return -ENOMEM;
-
-    snprintf(mixer_str, ctl_len, "%s %s", pcmDeviceName, control);
+    /*
+     * The control selection above is kept on a cache hit since callers
+     * issue tagged writes on the same FE right after resolving the MIID.
+     */
+    std::tuple<int, std::string, int> key(device, intf_name, tag_id);
+    uint64_t gen;
+    {
+        std::lock_guard<std::mutex> lock(miidCacheMutex);
+        gen = miidCacheGen;
+        auto it = miidCache.find(key);
+        if (it != miidCache.end()) {
+            *miid = it->second;
+            PAL_VERBOSE(LOG_TAG, "cached MIID 0x%x for tag 0x%x on %s",
+                        *miid, tag_id, intf_name);
+            return 0;
+        }
+    }
 
-    PAL_DBG(LOG_TAG, "- mixer -%s-\n", mixer_str);
-    ctl = mixer_get_ctl_by_name(mixer, mixer_str);
-    if (!ctl) {
-        PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", mixer_str);
-        free(mixer_str);
+    ctl = getFeMixerControlById(mixer, device, FE_GETTAGGEDINFO);
+    if (!ctl)
         return ENOENT;
-    }
 
     payload = calloc(1024, sizeof(char));
-    if (!payload) {
-        free(mixer_str);
+    if (!payload)
         return -ENOMEM;
-    }
 
     ret = mixer_ctl_get_array(ctl, payload, 1024);
     if (ret < 0) {
         PAL_ERR(LOG_TAG, "Failed to mixer_ctl_get_array\n");
         free(payload);
-        free(mixer_str);
         return ret;
     }
     tag_info = (struct gsl_tag_module_info *)payload;
@@ -1110,13 +1189,43 @@ int SessionAlsaUtils::getModuleInstanceId(struct mixer *mixer, int device, const
     if (*miid == 0) {
          ret = -EINVAL;
          PAL_ERR(LOG_TAG, "No matching MIID found for tag: 0x%x, error:%d", tag_id, ret);
+    } else if (ret == 0) {
+        std::lock_guard<std::mutex> lock(miidCacheMutex);
+        /* a graph change invalidated the cache while AGM was queried */
+        if (gen == miidCacheGen)
+            miidCache[key] = *miid;
     }
 
     free(payload);
-    free(mixer_str);
     return ret;
 }
 
+void SessionAlsaUtils::invalidateModuleInstanceIds(int device)
+{
+    std::lock_guard<std::mutex> lock(miidCacheMutex);
+    miidCacheGen++;
+    for (auto it = miidCache.begin(); it != miidCache.end();) {
+        if (std::get<0>(it->first) == device)
+            it = miidCache.erase(it);
+        else
+            ++it;
+    }
+}
+
+void SessionAlsaUtils::invalidateModuleInstanceIds(const std::vector<int> &DevIds)
+{
+    for (auto device : DevIds)
+        invalidateModuleInstanceIds(device);
+}
+
+void SessionAlsaUtils::invalidateModuleInstanceIds()
+{
+    std::lock_guard<std::mutex> lock(miidCacheMutex);
+    PAL_DBG(LOG_TAG, "dropping %zu cached MIIDs", miidCache.size());
+    miidCacheGen++;
+    miidCache.clear();
+}
+
 int SessionAlsaUtils::getTagsWithModuleInfo(struct mixer *mixer, int device, const char *intf_name,
                                             uint8_t *payload)
 {
@@ -1178,74 +1287,28 @@ int SessionAlsaUtils::getTagsWithModuleInfo(struct mixer *mixer, int device, con
 int SessionAlsaUtils::setMixerParameter(struct mixer *mixer, int device,
                                         void *payload, int size)
 {
-    char *pcmDeviceName = NULL;
-    char const *control = "setParam";
-    char *mixer_str;
     struct mixer_ctl *ctl;
-    int ctl_len = 0,ret = 0;
-    std::shared_ptr<ResourceManager> rm = ResourceManager::getInstance();
-
-    pcmDeviceName = rm->getDeviceNameFromID(device);
-    if(!pcmDeviceName){
-        PAL_ERR(LOG_TAG, "Device name from id %d not found", device);
-        return -EINVAL;
-    }
-
-    PAL_DBG(LOG_TAG, "- mixer -%s-\n", pcmDeviceName);
-    ctl_len = strlen(pcmDeviceName) + 1 + strlen(control) + 1;
-    mixer_str = (char *)calloc(1, ctl_len);
-    if (!mixer_str) {
-        return -ENOMEM;
-    }
-    snprintf(mixer_str, ctl_len, "%s %s", pcmDeviceName, control);
+    int ret = 0;
 
-    PAL_DBG(LOG_TAG, "- mixer -%s-\n", mixer_str);
-    ctl = mixer_get_ctl_by_name(mixer, mixer_str);
-    if (!ctl) {
-        PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", mixer_str);
-        free(mixer_str);
+    ctl = getFeMixerControlById(mixer, device, FE_SETPARAM);
+    if (!ctl)
         return ENOENT;
-    }
+
     ret = mixer_ctl_set_array(ctl, payload, size);
 
     PAL_DBG(LOG_TAG, "ret = %d, cnt = %d\n", ret, size);
-    free(mixer_str);
     return ret;
 }
 
 int SessionAlsaUtils::setStreamMetadataType(struct mixer *mixer, int device, const char *val)
 {
-    char *pcmDeviceName = NULL;
-    char const *control = "control";
-    char *mixer_str;
     struct mixer_ctl *ctl;
-    int ctl_len = 0,ret = 0;
-    std::shared_ptr<ResourceManager> rm = ResourceManager::getInstance();
 
-    pcmDeviceName = rm->getDeviceNameFromID(device);
-    if(!pcmDeviceName){
-        PAL_ERR(LOG_TAG, "Device name from id %d not found", device);
-        return -EINVAL;
-    }
-    ctl_len = strlen(pcmDeviceName) + 1 + strlen(control) + 1;
-    mixer_str = (char *)calloc(1, ctl_len);
-    if(mixer_str == NULL) {
-        ret = -ENOMEM;
-        PAL_ERR(LOG_TAG, "calloc failed");
-        return ret;
-    }
-    snprintf(mixer_str, ctl_len, "%s %s", pcmDeviceName, control);
-    PAL_DBG(LOG_TAG, "- mixer -%s-\n", mixer_str);
-    ctl = mixer_get_ctl_by_name(mixer, mixer_str);
-    if (!ctl) {
-        PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", mixer_str);
-        free(mixer_str);
+    ctl = getFeMixerControlById(mixer, device, FE_CONTROL);
+    if (!ctl)
         return ENOENT;
-    }
 
-    ret = mixer_ctl_set_enum_by_string(ctl, val);
-    free(mixer_str);
-    return ret;
+    return mixer_ctl_set_enum_by_string(ctl, val);
 }
 
 int SessionAlsaUtils::registerMixerEvent(struct mixer *mixer, int device, const char *intf_name, int tag_id, void *payload, int payload_size)
@@ -1271,74 +1334,25 @@ int SessionAlsaUtils::registerMixerEvent(struct mixer *mixer, int device, const
 
 int SessionAlsaUtils::registerMixerEvent(struct mixer *mixer, int device, void *payload, int payload_size)
 {
-    char *pcmDeviceName = NULL;
-    char const *control = "event";
-    char *mixer_str;
     struct mixer_ctl *ctl;
-    int ctl_len = 0,status = 0;
-    std::shared_ptr<ResourceManager> rm = ResourceManager::getInstance();
-
-    pcmDeviceName = rm->getDeviceNameFromID(device);
-    if (!pcmDeviceName)
-        return -EINVAL;
 
-    ctl_len = strlen(pcmDeviceName) + 1 + strlen(control) + 1;
-    mixer_str = (char *)calloc(1, ctl_len);
-    if (!mixer_str)
-        return -ENOMEM;
-
-    snprintf(mixer_str, ctl_len, "%s %s", pcmDeviceName, control);
-
-    PAL_DBG(LOG_TAG, "- mixer -%s-\n", mixer_str);
-    ctl = mixer_get_ctl_by_name(mixer, mixer_str);
-    if (!ctl) {
-        PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", mixer_str);
-        free(mixer_str);
+    ctl = getFeMixerControlById(mixer, device, FE_EVENT);
+    if (!ctl)
         return ENOENT;
-    }
 
-    status = mixer_ctl_set_array(ctl, (struct agm_event_reg_cfg *)payload,
+    return mixer_ctl_set_array(ctl, (struct agm_event_reg_cfg *)payload,
                         payload_size);
-    free(mixer_str);
-    return status;
 }
 
 int SessionAlsaUtils::setECRefPath(struct mixer *mixer, int device, const char *intf_name)
 {
-    char *pcmDeviceName = NULL;
-    char const *control = "echoReference";
-    char *mixer_str;
     struct mixer_ctl *ctl;
-    int ctl_len = 0;
-    int ret = 0;
-    std::shared_ptr<ResourceManager> rm = ResourceManager::getInstance();
-
-    pcmDeviceName = rm->getDeviceNameFromID(device);
-    if(!pcmDeviceName){
-        PAL_ERR(LOG_TAG, "Device name from id %d not found", device);
-        return -EINVAL;
-    }
 
-    ctl_len = strlen(pcmDeviceName) + 1 + strlen(control) + 1;
-    mixer_str = (char *)calloc(1, ctl_len);
-    if(mixer_str == NULL) {
-        ret = -ENOMEM;
-        PAL_ERR(LOG_TAG, "calloc failed");
-        return ret;
-    }
-    snprintf(mixer_str, ctl_len, "%s %s", pcmDeviceName, control);
-
-    printf("%s mixer -%s-\n", __func__, mixer_str);
-    ctl = mixer_get_ctl_by_name(mixer, mixer_str);
-    if (!ctl) {
-        printf("Invalid mixer control: %s\n", mixer_str);
-        free(mixer_str);
+    ctl = getFeMixerControlById(mixer, device, FE_ECHOREFERENCE);
+    if (!ctl)
         return ENOENT;
-    }
 
-    ret = mixer_ctl_set_enum_by_string(ctl, intf_name);
-    free(mixer_str);
-    return ret;
+    return mixer_ctl_set_enum_by_string(ctl, intf_name);
 }
 
 int SessionAlsaUtils::mixerWriteDatapathParams(struct mixer *mixer, int device,
@@ -1417,6 +1431,9 @@ int SessionAlsaUtils::open(Stream * streamHandle, std::shared_ptr<ResourceManage
     struct pal_device dAttr;
     bool isDeviceFound = false;
 
+    MiidCacheGraphChange rxMiidGuard(RxDevIds);
+    MiidCacheGraphChange txMiidGuard(TxDevIds);
+
     if (RxDevIds.empty() || TxDevIds.empty()) {
         PAL_ERR(LOG_TAG, "RX and TX FE Dev Ids are empty");
         return -EINVAL;
@@ -1811,6 +1828,9 @@ int SessionAlsaUtils::close(Stream * streamHandle, std::shared_ptr<ResourceManag
     uint32_t streamDevicePropId[] = {0x08000010, 1, 0x3}; /** gsl_subgraph_platform_driver_props.xml */
     uint32_t i, rxDevNum, txDevNum;
 
+    MiidCacheGraphChange rxMiidGuard(RxDevIds);
+    MiidCacheGraphChange txMiidGuard(TxDevIds);
+
     status = streamHandle->getStreamAttributes(&sAttr);
     if(0 != status) {
         PAL_ERR(LOG_TAG, "getStreamAttributes Failed \n");
@@ -1992,6 +2012,8 @@ int SessionAlsaUtils::disconnectSessionDevice(Stream* streamHandle, pal_stream_t
     int sub = 1;
     uint32_t i;
 
+    MiidCacheGraphChange miidGuard(pcmDevIds);
+
     switch (streamType) {
         case PAL_STREAM_COMPRESSED:
             disconnectCtrlName << COMPRESS_SND_DEV_NAME_PREFIX << pcmDevIds.at(0) << " disconnect";
@@ -2096,6 +2118,9 @@ int SessionAlsaUtils::disconnectSessionDevice(Stream* streamHandle, pal_stream_t
     struct mixer_ctl *txFeMixerCtrls[FE_MAX_NUM_MIXER_CONTROLS] = { nullptr };
     std::ostringstream txFeName;
 
+    MiidCacheGraphChange txMiidGuard(pcmTxDevIds);
+    MiidCacheGraphChange rxMiidGuard(pcmRxDevIds);
+
     switch (streamType) {
          case PAL_STREAM_ULTRASOUND:
          case PAL_STREAM_LOOPBACK:
@@ -2147,9 +2172,11 @@ int SessionAlsaUtils::connectSessionDevice(Session* sess, Stream* streamHandle,
     int sub = 1;
     uint32_t miid;
     struct sessionToPayloadParam streamData = {};
-    PayloadBuilder* builder = new PayloadBuilder();
+    PayloadBuilder* builder = nullptr;
     std::shared_ptr<ResourceManager> rm = ResourceManager::getInstance();
 
+    MiidCacheGraphChange miidGuard(pcmDevIds);
+
     status = rmHandle->getVirtualAudioMixer(&mixerHandle);
     if (status) {
         PAL_ERR(LOG_TAG, "get mixer handle failed %d", status);
@@ -2246,6 +2273,8 @@ int SessionAlsaUtils::connectSessionDevice(Session* sess, Stream* streamHandle,
         streamData.numChannel = sAttr.in_media_config.ch_info.channels;
         streamData.rotation_type = PAL_SPEAKER_ROTATION_LR;
         streamData.ch_info = nullptr;
+        /* only ULL record needs a payload, keep device switch allocation free */
+        builder = new PayloadBuilder();
         builder->payloadMFCConfig(&payload, &payloadSize, miid, &streamData);
         if (payloadSize && payload) {
             sess->getCustomPayload(&payload, &payloadSize);
@@ -2291,6 +2320,9 @@ int SessionAlsaUtils::connectSessionDevice(Session* sess, Stream* streamHandle,
     size_t payloadSize = 0;
     bool is_out_dev = false;
 
+    MiidCacheGraphChange txMiidGuard(pcmTxDevIds);
+    MiidCacheGraphChange rxMiidGuard(pcmRxDevIds);
+
     if (dAttr.id > PAL_DEVICE_OUT_MIN && dAttr.id < PAL_DEVICE_OUT_MAX) {
         is_out_dev = true;
         connectCtrlName << PCM_SND_DEV_NAME_PREFIX << pcmRxDevIds.at(0) << " connect";
@@ -2394,6 +2426,8 @@ int SessionAlsaUtils::setupSessionDevice(Stream* streamHandle, pal_stream_type_t
     struct vsid_info vsidinfo = {};
     sidetone_mode_t sidetoneMode = SIDETONE_OFF;
 
+    MiidCacheGraphChange miidGuard(pcmDevIds);
+
     status = rmHandle->getVirtualAudioMixer(&mixerHandle);
     if (status) {
         PAL_VERBOSE(LOG_TAG, "get mixer handle failed %d", status);
@@ -599,7 +599,7 @@ int SessionAlsaVoice::populate_rx_mfc_payload(Stream *s, uint32_t rx_mfc_tag)
     builder->payloadMFCConfig(&payload, &payloadSize, miid, &deviceData);
     if (payload && payloadSize) {
         status = updateCustomPayload(payload, payloadSize);
-        freeCustomPayload(&payload, &payloadSize);
+        builder->releasePayload(&payload, &payloadSize);
         if (status != 0)
             PAL_ERR(LOG_TAG,"updateCustomPayload for Rx mfc %XFailed\n", rx_mfc_tag);
     }
@@ -159,6 +159,19 @@ int32_t SoundTriggerEngine::SetBufferReader(PalRingBufferReader *reader)
     return status;
 }
 
+int32_t SoundTriggerEngine::SetBufferFanout(
+    std::shared_ptr<PalRingBufferFanout> fanout)
+{
+    if (engine_type_ == ST_SM_ID_SVA_F_STAGE_GMM) {
+        PAL_ERR(LOG_TAG, "Cannot set buffer fan-out in GMM engine");
+        return -EINVAL;
+    }
+
+    fanout_ = fanout;
+
+    return 0;
+}
+
 int32_t SoundTriggerEngine::ResetBufferReaders(
     std::vector<PalRingBufferReader *> &reader_list)
 {
@@ -40,6 +40,12 @@
 #include "Stream.h"
 #include "SoundTriggerPlatformInfo.h"
 
+/*
+ * Upper bound for a single wait on the LAB reader, keeps exit_buffering_
+ * polled while the ring is starved.
+ */
+#define CAPI_READER_WAIT_TIMEOUT_MS 20
+
 ST_DBG_DECLARE(static int keyword_detection_cnt = 0);
 ST_DBG_DECLARE(static int user_verification_cnt = 0);
 
@@ -90,9 +96,10 @@ void SoundTriggerEngineCapi::BufferThreadLoop(
                  * StreamSoundTrigger may call stop recognition to second stage
                  * engines when one of the second stage engine reject detection.
                  * So check processing_started_ before notify stream in case
-                 * stream has already stopped recognition.
+                 * stream has already stopped recognition. A canceled engine
+                 * was stopped by the other engine's reject, which is notified.
                  */
-                if (capi_engine->processing_started_) {
+                if (capi_engine->processing_started_ && status != -ECANCELED) {
                     if (status)
                         detection_state = KEYWORD_DETECTION_REJECT;
                     else
@@ -108,9 +115,10 @@ void SoundTriggerEngineCapi::BufferThreadLoop(
                  * StreamSoundTrigger may call stop recognition to second stage
                  * engines when one of the second stage engine reject detection.
                  * So check processing_started_ before notify stream in case
-                 * stream has already stopped recognition.
+                 * stream has already stopped recognition. A canceled engine
+                 * was stopped by the other engine's reject, which is notified.
                  */
-                if (capi_engine->processing_started_) {
+                if (capi_engine->processing_started_ && status != -ECANCELED) {
                     if (status)
                         detection_state = USER_VERIFICATION_REJECT;
                     else
@@ -128,10 +136,74 @@ void SoundTriggerEngineCapi::BufferThreadLoop(
     PAL_DBG(LOG_TAG, "Exit");
 }
 
+/*
+ * Point data at the next size bytes of the range being processed, from the
+ * fan-out window shared with the other second stage engine or straight from
+ * this engine's reader. Returns the bytes available, 0 when the caller should
+ * check exit_buffering_ and retry, or a negative error. Reader data must be
+ * released with commitRead once capi is done with it.
+ */
+int32_t SoundTriggerEngineCapi::ReadLabData(uint32_t size, char *linear_buff,
+    char **data, bool *buffer_advanced)
+{
+    struct pal_ring_buffer_region read_regions[PAL_RING_BUFFER_MAX_REGIONS];
+    int32_t status = 0;
+    size_t read_size = 0;
+
+    if (fanout_) {
+        status = fanout_->waitForData(buffer_start_ + bytes_processed_ + size,
+            CAPI_READER_WAIT_TIMEOUT_MS);
+        if (status)
+            return status == -ETIMEDOUT ? 0 : status;
+        *data = fanout_->getData(buffer_start_ + bytes_processed_);
+        return size;
+    }
+
+    /* Original code had some time of wait will need to revisit*/
+    /* need to take into consideration the start and end buffer*/
+    if (!reader_->isEnabled())
+        return -EINVAL;
+
+    /* advance the offset to ensure we are reading at the right place */
+    if (!*buffer_advanced && buffer_start_ > 0) {
+        if (reader_->waitForData(buffer_start_, CAPI_READER_WAIT_TIMEOUT_MS))
+            return 0;
+        if (!reader_->advanceReadOffset(buffer_start_))
+            return 0;
+        *buffer_advanced = true;
+    }
+
+    if (reader_->waitForData(size, CAPI_READER_WAIT_TIMEOUT_MS))
+        return 0;
+
+    read_size = reader_->getReadRegions(read_regions, size);
+    if (read_size == 0)
+        return 0;
+
+    /*
+     * Feed capi straight from ring memory, the span stays untouched by
+     * the writer until commitRead. Only a chunk crossing the end of the
+     * ring needs to be linearized.
+     */
+    if (read_regions[1].size == 0) {
+        *data = read_regions[0].data;
+    } else {
+        ar_mem_cpy(linear_buff, read_size, read_regions[0].data,
+            read_regions[0].size);
+        ar_mem_cpy(linear_buff + read_regions[0].size,
+            read_size - read_regions[0].size, read_regions[1].data,
+            read_regions[1].size);
+        *data = linear_buff;
+    }
+
+    return read_size;
+}
+
 int32_t SoundTriggerEngineCapi::StartKeywordDetection()
 {
     int32_t status = 0;
     char *process_input_buff = nullptr;
+    char *process_data = nullptr;
     capi_v2_err_t rc = CAPI_V2_EOK;
     capi_v2_stream_data_t *stream_input = nullptr;
     sva_result_t *result_cfg_ptr = nullptr;
@@ -152,13 +224,16 @@ int32_t SoundTriggerEngineCapi::StartKeywordDetection()
     uint64_t total_capi_get_param_duration = 0;
 
     PAL_DBG(LOG_TAG, "Enter");
-    if (!reader_) {
+    if (!reader_ && !fanout_) {
         status = -EINVAL;
         PAL_ERR(LOG_TAG, "Invalid ring buffer reader");
         goto exit;
     }
 
-    reader_->getIndices(&buffer_start_, &buffer_end_);
+    if (fanout_)
+        fanout_->getIndices(&buffer_start_, &buffer_end_);
+    else
+        reader_->getIndices(&buffer_start_, &buffer_end_);
     if (buffer_start_ >= buffer_end_) {
         status = -EINVAL;
         PAL_ERR(LOG_TAG, "Invalid keyword indices");
@@ -226,44 +301,25 @@ int32_t SoundTriggerEngineCapi::StartKeywordDetection()
     process_start = std::chrono::steady_clock::now();
     while (!exit_buffering_ &&
         (bytes_processed_ < buffer_end_ - buffer_start_)) {
-        /* Original code had some time of wait will need to revisit*/
-        /* need to take into consideration the start and end buffer*/
-        if (!reader_->isEnabled()) {
-            status = -EINVAL;
-            goto exit;
-        }
-
-        /* advance the offset to ensure we are reading at the right place */
-        if (!buffer_advanced && buffer_start_ > 0) {
-            if (reader_->advanceReadOffset(buffer_start_)) {
-                buffer_advanced = true;
-            } else {
-                continue;
-            }
-        }
-
-        if (reader_->getUnreadSize() < buffer_size_)
-            continue;
-
-        read_size = reader_->read((void*)process_input_buff, buffer_size_);
-        if (read_size == 0) {
-            continue;
-        } else if (read_size < 0) {
+        read_size = ReadLabData(buffer_size_, process_input_buff,
+            &process_data, &buffer_advanced);
+        if (read_size < 0) {
             status = read_size;
-            PAL_ERR(LOG_TAG, "Failed to read from buffer, status %d", status);
             goto exit;
         }
+        if (read_size == 0)
+            continue;
 
         PAL_INFO(LOG_TAG, "Processed: %u, start: %u, end: %u",
                  bytes_processed_, buffer_start_, buffer_end_);
         stream_input->bufs_num = 1;
         stream_input->buf_ptr->max_data_len = buffer_size_;
         stream_input->buf_ptr->actual_data_len = read_size;
-        stream_input->buf_ptr->data_ptr = (int8_t *)process_input_buff;
+        stream_input->buf_ptr->data_ptr = (int8_t *)process_data;
 
         if (st_info_->GetEnableDebugDumps()) {
             ST_DBG_FILE_WRITE(keyword_detection_fd,
-                process_input_buff, read_size);
+                process_data, read_size);
         }
 
         PAL_VERBOSE(LOG_TAG, "Calling Capi Process");
@@ -282,6 +338,12 @@ int32_t SoundTriggerEngineCapi::StartKeywordDetection()
             goto exit;
         }
 
+        /* fails when the reader was reset while capi used its memory */
+        if (!fanout_ && reader_->commitRead(read_size)) {
+            status = -EINVAL;
+            PAL_ERR(LOG_TAG, "commit of %d bytes failed, reader reset", read_size);
+            goto exit;
+        }
         bytes_processed_ += read_size;
 
         capi_result.data_ptr = (int8_t*)result_cfg_ptr;
@@ -325,6 +387,9 @@ int32_t SoundTriggerEngineCapi::StartKeywordDetection()
     }
 
 exit:
+    /* let a pending reset() proceed if we bailed out holding read regions */
+    if (reader_)
+        reader_->cancelRead();
 
     PAL_INFO(LOG_TAG, "Issuing capi_set_param for param %d",
                    SVA_ID_REINIT_ALL);
@@ -351,6 +416,12 @@ exit:
 
     if (reader_)
         reader_->updateState(READER_DISABLED);
+    if (fanout_) {
+        /* a reject stops the user verification engine without waiting */
+        if (status || detection_state_ == KEYWORD_DETECTION_REJECT)
+            fanout_->cancel();
+        fanout_->release();
+    }
 
     if (process_input_buff)
         free(process_input_buff);
@@ -371,6 +442,7 @@ int32_t SoundTriggerEngineCapi::StartUserVerification()
 {
     int32_t status = 0;
     char *process_input_buff = nullptr;
+    char *process_data = nullptr;
     capi_v2_err_t rc = CAPI_V2_EOK;
     capi_v2_stream_data_t *stream_input = nullptr;
     capi_v2_buf_t capi_uv_ptr;
@@ -391,13 +463,16 @@ int32_t SoundTriggerEngineCapi::StartUserVerification()
     uint64_t total_capi_get_param_duration = 0;
 
     PAL_DBG(LOG_TAG, "Enter");
-    if (!reader_) {
+    if (!reader_ && !fanout_) {
         status = -EINVAL;
         PAL_ERR(LOG_TAG, "Invalid ring buffer reader");
         goto exit;
     }
 
-    reader_->getIndices(&buffer_start_, &buffer_end_);
+    if (fanout_)
+        fanout_->getIndices(&buffer_start_, &buffer_end_);
+    else
+        reader_->getIndices(&buffer_start_, &buffer_end_);
     if (buffer_start_ >= buffer_end_) {
         status = -EINVAL;
         PAL_ERR(LOG_TAG, "Invalid keyword indices");
@@ -499,43 +574,24 @@ int32_t SoundTriggerEngineCapi::StartUserVerification()
     process_start = std::chrono::steady_clock::now();
     while (!exit_buffering_ &&
         (bytes_processed_ < buffer_end_ - buffer_start_)) {
-        /* Original code had some time of wait will need to revisit*/
-        /* need to take into consideration the start and end buffer*/
-        if (!reader_->isEnabled()) {
-            status = -EINVAL;
-            goto exit;
-        }
-
-        /* advance the offset to ensure we are reading at the right place */
-        if (!buffer_advanced && buffer_start_ > 0) {
-            if (reader_->advanceReadOffset(buffer_start_)) {
-                buffer_advanced = true;
-            } else {
-                continue;
-            }
-        }
-
-        if (reader_->getUnreadSize() < buffer_size_)
-            continue;
-
-        read_size = reader_->read((void*)process_input_buff, buffer_size_);
-        if (read_size == 0) {
-            continue;
-        } else if (read_size < 0) {
+        read_size = ReadLabData(buffer_size_, process_input_buff,
+            &process_data, &buffer_advanced);
+        if (read_size < 0) {
             status = read_size;
-            PAL_ERR(LOG_TAG, "Failed to read from buffer, status %d", status);
             goto exit;
         }
+        if (read_size == 0)
+            continue;
         PAL_INFO(LOG_TAG, "Processed: %u, start: %u, end: %u",
                  bytes_processed_, buffer_start_, buffer_end_);
         stream_input->bufs_num = 1;
         stream_input->buf_ptr->max_data_len = buffer_size_;
         stream_input->buf_ptr->actual_data_len = read_size;
-        stream_input->buf_ptr->data_ptr = (int8_t *)process_input_buff;
+        stream_input->buf_ptr->data_ptr = (int8_t *)process_data;
 
         if (st_info_->GetEnableDebugDumps()) {
             ST_DBG_FILE_WRITE(user_verification_fd,
-                process_input_buff, read_size);
+                process_data, read_size);
         }
 
         PAL_VERBOSE(LOG_TAG, "Calling Capi Process\n");
@@ -554,6 +610,12 @@ int32_t SoundTriggerEngineCapi::StartUserVerification()
             goto exit;
         }
 
+        /* fails when the reader was reset while capi used its memory */
+        if (!fanout_ && reader_->commitRead(read_size)) {
+            status = -EINVAL;
+            PAL_ERR(LOG_TAG, "commit of %d bytes failed, reader reset", read_size);
+            goto exit;
+        }
         bytes_processed_ += read_size;
 
         capi_result.data_ptr = (int8_t*)result_cfg_ptr;
@@ -589,6 +651,10 @@ int32_t SoundTriggerEngineCapi::StartUserVerification()
     }
 
 exit:
+    /* let a pending reset() proceed if we bailed out holding read regions */
+    if (reader_)
+        reader_->cancelRead();
+
     process_end = std::chrono::steady_clock::now();
     process_duration = std::chrono::duration_cast<std::chrono::milliseconds>(
         process_end - process_start).count();
@@ -614,6 +680,12 @@ exit:
 
     if (reader_)
         reader_->updateState(READER_DISABLED);
+    if (fanout_) {
+        /* a reject stops the keyword detection engine without waiting */
+        if (status || detection_state_ == USER_VERIFICATION_REJECT)
+            fanout_->cancel();
+        fanout_->release();
+    }
 
     if (process_input_buff)
         free(process_input_buff);
@@ -1072,10 +1144,15 @@ int32_t SoundTriggerEngineCapi::RestartRecognition(Stream *s __unused)
     processing_started_ = false;
     {
         exit_buffering_ = true;
+        // wake the buffer thread if it is waiting on the shared window
+        if (fanout_)
+            fanout_->cancel();
         std::lock_guard<std::mutex> event_lck(event_mutex_);
     }
     if (reader_) {
         reader_->reset();
+    } else if (fanout_) {
+        fanout_->reset();
     } else {
         status = -EINVAL;
         goto exit;
@@ -1096,10 +1173,15 @@ int32_t SoundTriggerEngineCapi::StopRecognition(Stream *s __unused)
     processing_started_ = false;
     {
         exit_buffering_ = true;
+        // wake the buffer thread if it is waiting on the shared window
+        if (fanout_)
+            fanout_->cancel();
         std::lock_guard<std::mutex> event_lck(event_mutex_);
     }
     if (reader_) {
         reader_->reset();
+    } else if (fanout_) {
+        fanout_->reset();
     } else {
         status = -EINVAL;
         goto exit;
@@ -1138,7 +1220,8 @@ void SoundTriggerEngineCapi::SetDetected(bool detected)
     PAL_DBG(LOG_TAG, "SetDetected %d", detected);
     std::lock_guard<std::mutex> lck(event_mutex_);
     if (detected != processing_started_) {
-        if (detected)
+        // a shared fan-out is started by the stream for all engines
+        if (detected && reader_)
             reader_->updateState(READER_ENABLED);
         processing_started_ = detected;
         exit_buffering_ = !processing_started_;
@@ -48,6 +48,9 @@
 #endif
 
 #define MAX_MMAP_POSITION_QUERY_RETRY_CNT 5
+/* bounds of the mmap position poll interval while FTRT data is draining */
+#define MMAP_FTRT_MIN_POLL_US 500
+#define MMAP_FTRT_MAX_POLL_US 5000
 
 ST_DBG_DECLARE(static int dsp_output_cnt = 0);
 
@@ -195,6 +198,61 @@ void SoundTriggerEngineGsl::CheckAndSetDetectionConfLevels(Stream *s) {
             st->GetSoundModelInfo()->GetDetConfLevels()[i]);
 }
 
+/*
+ * How long to wait before the next mmap position query when no new data was
+ * found. During FTRT the DSP fills much faster than real time, so wait just
+ * long enough for one input buffer at the observed fill rate; afterwards the
+ * fill rate is real time and the wait is one buffer period.
+ */
+static uint64_t GetMmapPollIntervalUs(bool ftrt_phase, double fill_rate,
+    size_t chunk_size, uint64_t period_us)
+{
+    uint64_t interval_us = period_us;
+
+    if (!ftrt_phase)
+        return period_us;
+
+    if (fill_rate > 0)
+        interval_us = (uint64_t)(chunk_size / fill_rate);
+
+    return std::min(std::max(interval_us, (uint64_t)MMAP_FTRT_MIN_POLL_US),
+        std::min(period_us, (uint64_t)MMAP_FTRT_MAX_POLL_US));
+}
+
+/*
+ * Copy size bytes starting at offset of the DSP shared buffer into a write
+ * reservation of the ring buffer, both sides may wrap. Returns the bytes
+ * committed, which is less than size if the ring buffer is full.
+ */
+size_t SoundTriggerEngineGsl::WriteMmapToRingBuffer(size_t offset, size_t size,
+    FILE *dump_fd) {
+    struct pal_ring_buffer_region regions[PAL_RING_BUFFER_MAX_REGIONS];
+    uint8_t *src = (uint8_t *)mmap_buffer_.buffer;
+    size_t reserved = 0;
+    size_t copied = 0;
+    size_t chunk = 0;
+
+    reserved = buffer_->reserveWrite(regions, size);
+    if (reserved < size)
+        PAL_ERR(LOG_TAG, "ring buffer full, dropping %zu bytes",
+            size - reserved);
+
+    for (int i = 0; i < PAL_RING_BUFFER_MAX_REGIONS; i++) {
+        copied = 0;
+        while (copied < regions[i].size) {
+            chunk = std::min(regions[i].size - copied,
+                mmap_buffer_size_ - offset);
+            ar_mem_cpy(regions[i].data + copied, chunk, src + offset, chunk);
+            copied += chunk;
+            offset = (offset + chunk) % mmap_buffer_size_;
+        }
+        ST_DBG_FILE_WRITE(dump_fd, regions[i].data, regions[i].size);
+    }
+    buffer_->commitWrite(reserved);
+
+    return reserved;
+}
+
 int32_t SoundTriggerEngineGsl::StartBuffering(Stream *s) {
     int32_t status = 0;
     int32_t size = 0;
@@ -215,7 +273,19 @@ int32_t SoundTriggerEngineGsl::StartBuffering(Stream *s) {
     FILE *dsp_output_fd = nullptr;
     ChronoSteadyClock_t kw_transfer_begin;
     ChronoSteadyClock_t kw_transfer_end;
-    size_t retry_cnt = 0;
+    size_t ret = 0;
+    ChronoSteadyClock_t now;
+    ChronoSteadyClock_t last_poll_time;
+    ChronoSteadyClock_t last_data_time;
+    ChronoSteadyClock_t first_byte_time;
+    bool first_byte_received = false;
+    size_t last_bytes_written = 0;
+    double fill_rate = 0;
+    uint64_t period_us = 0;
+    uint64_t elapsed_us = 0;
+    uint64_t ttfb_us = 0;
+    uint64_t ftrt_rate_kbps = 0;
+    uint32_t mmap_poll_cnt = 0;
 
     PAL_DBG(LOG_TAG, "Enter");
     UpdateState(ENG_BUFFERING);
@@ -224,14 +294,18 @@ int32_t SoundTriggerEngineGsl::StartBuffering(Stream *s) {
         BITS_PER_BYTE * MS_PER_SEC /
         (sm_cfg_->GetSampleRate() * sm_cfg_->GetBitWidth() *
         sm_cfg_->GetOutChannels());
+    period_us = (uint64_t)sleep_ms * 1000;
 
     std::memset(&buf, 0, sizeof(struct pal_buffer));
     buf.size = input_buf_size * input_buf_num;
-    buf.buffer = (uint8_t *)calloc(1, buf.size);
-    if (!buf.buffer) {
-        PAL_ERR(LOG_TAG, "buf.buffer allocation failed");
-        status = -ENOMEM;
-        goto exit;
+    // mmap mode moves data from the shared buffer straight to ring buffer
+    if (mmap_buffer_size_ == 0) {
+        buf.buffer = (uint8_t *)calloc(1, buf.size);
+        if (!buf.buffer) {
+            PAL_ERR(LOG_TAG, "buf.buffer allocation failed");
+            status = -ENOMEM;
+            goto exit;
+        }
     }
 
     if (!IS_MODULE_TYPE_PDK(module_type_)) {
@@ -253,6 +327,8 @@ int32_t SoundTriggerEngineGsl::StartBuffering(Stream *s) {
 
     ATRACE_ASYNC_BEGIN("stEngine: read FTRT data", (int32_t)module_type_);
     kw_transfer_begin = std::chrono::steady_clock::now();
+    last_poll_time = kw_transfer_begin;
+    last_data_time = kw_transfer_begin;
     while (!exit_buffering_) {
         /*
          * When RestartRecognition is called during buffering thread
@@ -278,6 +354,7 @@ int32_t SoundTriggerEngineGsl::StartBuffering(Stream *s) {
              * and read after each detection.
              */
             status = session_->GetMmapPosition(s, &mmap_pos);
+            mmap_poll_cnt++;
             if (!status) {
                 bytes_written = FrameToBytes(mmap_pos.position_frames -
                     mmap_write_position_);
@@ -286,16 +363,39 @@ int32_t SoundTriggerEngineGsl::StartBuffering(Stream *s) {
                     status = -EINVAL;
                     goto exit;
                 }
+                now = std::chrono::steady_clock::now();
+                elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                    now - last_poll_time).count();
+                if (bytes_written > last_bytes_written && elapsed_us > 0) {
+                    // smoothed DSP fill rate in bytes per us
+                    fill_rate = (fill_rate == 0) ?
+                        (double)(bytes_written - last_bytes_written) / elapsed_us :
+                        (fill_rate + (double)(bytes_written - last_bytes_written) /
+                            elapsed_us) / 2;
+                }
+                last_poll_time = now;
+                last_bytes_written = bytes_written;
                 if (bytes_written > total_read_size) {
                     size_to_read = bytes_written - total_read_size;
-                    retry_cnt = 0;
+                    last_data_time = now;
                 } else {
-                    retry_cnt++;
-                    if (retry_cnt > MAX_MMAP_POSITION_QUERY_RETRY_CNT) {
+                    /* same stall tolerance as MAX_MMAP_POSITION_QUERY_RETRY_CNT periods */
+                    if (std::chrono::duration_cast<std::chrono::microseconds>(
+                            now - last_data_time).count() >
+                            (int64_t)(period_us * MAX_MMAP_POSITION_QUERY_RETRY_CNT)) {
+                        PAL_ERR(LOG_TAG, "no data from DSP for %u periods",
+                            MAX_MMAP_POSITION_QUERY_RETRY_CNT);
                         status = -EIO;
                         goto exit;
                     }
-                    std::this_thread::sleep_for(std::chrono::milliseconds(sleep_ms));
+                    /*
+                     * Only back off when nothing new was written, past FTRT
+                     * this waits one buffer period for the next real time
+                     * chunk instead of polling for partial data.
+                     */
+                    std::this_thread::sleep_for(std::chrono::microseconds(
+                        GetMmapPollIntervalUs(total_read_size < ftrt_size,
+                            fill_rate, input_buf_size, period_us)));
                     continue;
                 }
                 if (size_to_read > (2 * mmap_buffer_size_) - read_offset) {
@@ -311,35 +411,24 @@ int32_t SoundTriggerEngineGsl::StartBuffering(Stream *s) {
                 goto exit;
             }
 
-            if (size_to_read != buf.size) {
-                buf.buffer = (uint8_t *)realloc(buf.buffer, size_to_read);
-                if (!buf.buffer) {
-                    PAL_ERR(LOG_TAG, "buf.buffer allocation failed");
-                    status = -ENOMEM;
-                    goto exit;
-                }
-                buf.size = size_to_read;
-            }
-
-            // TODO: directly write to PalRingBuffer with shared buffer pointer
-            if (read_offset + size_to_read <= mmap_buffer_size_) {
-                ar_mem_cpy(buf.buffer, size_to_read,
-                    (uint8_t *)mmap_buffer_.buffer + read_offset,
-                    size_to_read);
-                read_offset += size_to_read;
+            // write data from shared buffer to ring buffer directly
+            if (bytes_to_drop >= size_to_read) {
+                bytes_to_drop -= size_to_read;
             } else {
-                ar_mem_cpy(buf.buffer, mmap_buffer_size_ - read_offset,
-                    (uint8_t *)mmap_buffer_.buffer + read_offset,
-                    mmap_buffer_size_ - read_offset);
-                ar_mem_cpy(buf.buffer + mmap_buffer_size_ - read_offset,
-                    size_to_read + read_offset - mmap_buffer_size_,
-                    (uint8_t *)mmap_buffer_.buffer,
-                    size_to_read + read_offset - mmap_buffer_size_);
-                read_offset = size_to_read + read_offset - mmap_buffer_size_;
+                ret = WriteMmapToRingBuffer(
+                    (read_offset + bytes_to_drop) % mmap_buffer_size_,
+                    size_to_read - bytes_to_drop, dsp_output_fd);
+                bytes_to_drop = 0;
+                PAL_VERBOSE(LOG_TAG, "%zu written to ring buffer", ret);
             }
-            size = size_to_read;
-            PAL_VERBOSE(LOG_TAG, "read %d bytes from shared buffer", size);
-            total_read_size += size;
+            if (!first_byte_received) {
+                first_byte_time = now;
+                first_byte_received = true;
+            }
+            read_offset = (read_offset + size_to_read) % mmap_buffer_size_;
+            PAL_VERBOSE(LOG_TAG, "read %zu bytes from shared buffer",
+                size_to_read);
+            total_read_size += size_to_read;
         } else if (buffer_->getFreeSize() >= buf.size) {
             if (total_read_size < ftrt_size &&
                 ftrt_size - total_read_size < buf.size) {
@@ -353,12 +442,15 @@ int32_t SoundTriggerEngineGsl::StartBuffering(Stream *s) {
                 break;
             }
             PAL_VERBOSE(LOG_TAG, "requested %zu, read %d", buf.size, size);
+            if (size && !first_byte_received) {
+                first_byte_time = std::chrono::steady_clock::now();
+                first_byte_received = true;
+            }
             total_read_size += size;
         }
         ATRACE_ASYNC_END("stEngine: lab read", (int32_t)module_type_);
         // write data to ring buffer
         if (size) {
-            size_t ret = 0;
             if (bytes_to_drop) {
                 if (size < bytes_to_drop) {
                     bytes_to_drop -= size;
@@ -387,8 +479,18 @@ int32_t SoundTriggerEngineGsl::StartBuffering(Stream *s) {
                 ATRACE_ASYNC_END("stEngine: read FTRT data", (int32_t)module_type_);
                 kw_transfer_latency_ = std::chrono::duration_cast<std::chrono::milliseconds>(
                     kw_transfer_end - kw_transfer_begin).count();
-                PAL_INFO(LOG_TAG, "FTRT data read done! total_read_size %zu, ftrt_size %zu, read latency %llums",
-                        total_read_size, ftrt_size, (long long)kw_transfer_latency_);
+                elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                    kw_transfer_end - kw_transfer_begin).count();
+                if (first_byte_received)
+                    ttfb_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                        first_byte_time - kw_transfer_begin).count();
+                // bytes per ms is KB per s
+                ftrt_rate_kbps = elapsed_us ? (total_read_size * 1000 / elapsed_us) : 0;
+                PAL_INFO(LOG_TAG, "FTRT data read done! total_read_size %zu, ftrt_size %zu, read latency %llums, "
+                        "first byte %lluus, throughput %lluKB/s, mmap polls %u",
+                        total_read_size, ftrt_size, (long long)kw_transfer_latency_,
+                        (unsigned long long)ttfb_us, (unsigned long long)ftrt_rate_kbps,
+                        mmap_poll_cnt);
 
                 if (!IS_MODULE_TYPE_PDK(module_type_)) {
                     StreamSoundTrigger *s = dynamic_cast<StreamSoundTrigger *>
@@ -42,9 +42,7 @@
 #include <exception>
 #include <semaphore.h>
 #include <errno.h>
-#ifdef LINUX_ENABLED
 #include <condition_variable>
-#endif
 #include "PalCommon.h"
 
 typedef enum {
@@ -125,12 +123,15 @@ typedef enum {
 /* Soft pause has to wait for ramp period to ensure volume stepping finishes.
  * This period of time was previously consumed in elite before acknowleging
  * pause completion. But it's not the case in Gecko.
- * FIXME: load the ramp period config from acdb.
+ * Default only, the "volume_ramp_period_ms" config param overrides it and
+ * the wait ends early once the DSP reports pause completion.
  */
 #define VOLUME_RAMP_PERIOD (100*1000)
 
 /*
- * The sleep is required for mute to ramp down.
+ * The wait is required for mute to ramp down.
+ * Default only, overridden by the "mute_ramp_period_ms" config param.
+ * Device PP mute raises no DSP event, so callers sleep for the whole period.
  */
 #define MUTE_RAMP_PERIOD (30*1000)
 
@@ -148,6 +149,11 @@ protected:
     struct pal_stream_attributes* mStreamAttr;
     int mGainLevel;
     std::mutex mStreamMutex;
+    /* Data path lock, held across blocking session read/write instead of
+     * mStreamMutex, and by the device switch path so I/O never runs against
+     * a half connected graph. Lock order is mStreamMutex -> mDataMutex.
+     */
+    std::mutex mDataMutex;
     static std::mutex mBaseStreamMutex; //TBD change this. as having a single static mutex for all instances of Stream is incorrect. Replace
     static std::shared_ptr<ResourceManager> rm;
     struct modifier_kv *mModifiers;
@@ -163,10 +169,21 @@ protected:
     stream_state_t currentState;
     stream_state_t cachedState;
     uint32_t mInstanceID = 0;
-    static std::condition_variable pauseCV;
-    static std::mutex pauseMutex;
+    /* per stream completion of a DSP ramp event, e.g. soft pause done */
+    std::mutex mRampMutex;
+    std::condition_variable mRampCV;
+    uint32_t mRampEventId = 0;
+    bool mRampArmed = false;
+    bool mRampDone = false;
+    void armRampEvent(uint32_t eventId);
+    void disarmRampEvent();
+    int32_t waitRampEvent(uint32_t timeoutUs);
+    /* deadline of the virtual sink used while the card is offline, only
+     * touched from the data path */
+    uint64_t mVirtualSinkDeadlineNs = 0;
+    void paceVirtualSink(size_t bytes, uint32_t frameSize, uint32_t sampleRate);
     bool mutexLockedbyRm = false;
-    sem_t mInUse;
+    pal_stream_handle_t *mStreamHandle = nullptr;
     int connectToDefaultDevice(Stream* streamHandle, uint32_t dir);
 public:
     virtual ~Stream() {};
@@ -195,10 +212,13 @@ public:
     virtual int32_t flush() {return 0;}
     virtual int32_t suspend() {return 0;}
     virtual int32_t read(struct pal_buffer *buf) = 0;
+    virtual int32_t readv(const struct pal_iovec *iov, uint32_t iovcnt);
 
     virtual int32_t addRemoveEffect(pal_audio_effect_t effect, bool enable) = 0; //TBD: make this non virtual and prrovide implementation as StreamPCM and StreamCompressed are doing the same things
     virtual int32_t setParameters(uint32_t param_id, void *payload) = 0;
     virtual int32_t write(struct pal_buffer *buf) = 0; //TBD: make this non virtual and prrovide implementation as StreamPCM and StreamCompressed are doing the same things
+    virtual int32_t writev(const struct pal_iovec *iov, uint32_t iovcnt);
+    static size_t getIovecSize(const struct pal_iovec *iov, uint32_t iovcnt);
     virtual int32_t registerCallBack(pal_stream_callback cb, uint64_t cookie) = 0;
     virtual int32_t getCallBack(pal_stream_callback *cb) = 0;
     virtual int32_t getParameters(uint32_t param_id, void **payload) = 0;
@@ -248,10 +268,8 @@ public:
     int32_t getEffectParameters(void *effect_query, size_t *payload_size);
     uint32_t getInstanceId() { return mInstanceID; }
     inline void setInstanceId(uint32_t sid) { mInstanceID = sid; }
-    int initStreamSmph();
-    int deinitStreamSmph();
-    int postStreamSmph();
-    int waitStreamSmph();
+    pal_stream_handle_t* getStreamHandle() { return mStreamHandle; }
+    void setStreamHandle(pal_stream_handle_t *handle) { mStreamHandle = handle; }
     bool checkStreamMatch(pal_device_id_t pal_device_id,
                                 pal_stream_type_t pal_stream_type);
     int32_t getEffectParameters(void *effect_query);
@@ -268,6 +286,7 @@ public:
     virtual int32_t HandleConcurrentStream(bool active) { return 0; }
     virtual int32_t DisconnectDevice(pal_device_id_t device_id) { return 0; }
     virtual int32_t ConnectDevice(pal_device_id_t device_id) { return 0; }
+    void signalRampEvent(uint32_t eventId);
     static void handleSoftPauseCallBack(uint64_t hdl, uint32_t event_id, void *data,
                                                            uint32_t event_size);
     static void handleStreamException(struct pal_stream_attributes *attributes,
@@ -264,6 +264,9 @@ class StreamACD : public Stream {
             data_ = std::make_shared<ACDDetectedEventConfigData>(data);
         }
         ~ACDDetectedEventConfig() {}
+        void SetData(void *data) {
+            ((ACDDetectedEventConfigData *)data_.get())->data_ = data;
+        }
     };
 
     class ACDConcurrentStreamEventConfigData : public ACDEventConfigData {
@@ -423,6 +426,7 @@ class StreamACD : public Stream {
     void AddState(ACDState* state);
     int32_t GetPreviousStateId();
     int32_t ProcessInternalEvent(std::shared_ptr<ACDEventConfig> ev_cfg);
+    std::shared_ptr<ACDEventConfig> GetDetectedEventConfig(void *event);
 
     int32_t SetupStreamConfig(const struct st_uuid *vendor_uuid);
     int32_t UpdateRecognitionConfig(struct acd_recognition_cfg *config);
@@ -443,6 +447,8 @@ class StreamACD : public Stream {
     struct acd_recognition_cfg    *rec_config_;
     struct pal_param_context_list *context_config_;
     struct pal_st_recognition_event *cached_event_data_;
+    // reused for every context event, see GetDetectedEventConfig
+    std::shared_ptr<ACDDetectedEventConfig> detected_ev_cfg_;
     bool                          paused_;
     bool                          device_opened_;
 
@@ -62,6 +62,8 @@ public:
    int32_t addRemoveEffect(pal_audio_effect_t effect, bool enable) override;
    int32_t read(struct pal_buffer *buf) override;
    int32_t write(struct pal_buffer *buf) override;
+   int32_t readv(const struct pal_iovec *iov, uint32_t iovcnt) override;
+   int32_t writev(const struct pal_iovec *iov, uint32_t iovcnt) override;
    int32_t registerCallBack(pal_stream_callback cb, uint64_t cookie) override;
    int32_t getCallBack(pal_stream_callback *cb) override;
    int32_t getParameters(uint32_t param_id, void **payload) override;
@@ -77,6 +79,11 @@ public:
    static int32_t isSampleRateSupported(uint32_t sampleRate);
    static int32_t isChannelSupported(uint32_t numChannels);
    static int32_t isBitWidthSupported(uint32_t bitWidth);
+private:
+   /* common data path for read/write and readv/writev, exactly one of
+    * buf or iov is set */
+   int32_t readData(struct pal_buffer *buf, const struct pal_iovec *iov, uint32_t iovcnt);
+   int32_t writeData(struct pal_buffer *buf, const struct pal_iovec *iov, uint32_t iovcnt);
 };
 
 #endif//STREAMPCM_H_
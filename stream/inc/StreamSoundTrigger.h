@@ -330,6 +330,9 @@ class StreamSoundTrigger : public Stream {
             data_ = std::make_shared<StReadBufferEventConfigData>(data);
         }
         ~StReadBufferEventConfig() {}
+        void SetData(void *data) {
+            ((StReadBufferEventConfigData *)data_.get())->data_ = data;
+        }
     };
 
     class StStopBufferingEventConfig : public StEventConfig {
@@ -553,6 +556,7 @@ class StreamSoundTrigger : public Stream {
     void AddState(StState* state);
     int32_t GetPreviousStateId();
     int32_t ProcessInternalEvent(std::shared_ptr<StEventConfig> ev_cfg);
+    std::shared_ptr<StEventConfig> GetReadBufferEventConfig(void *buf);
     void GetUUID(class SoundTriggerUUID *uuid, struct pal_st_sound_model
                                                           *sound_model);
     std::shared_ptr<SoundTriggerPlatformInfo> st_info_;
@@ -570,6 +574,8 @@ class StreamSoundTrigger : public Stream {
     pal_stream_callback callback_;
     uint64_t cookie_;
     PalRingBufferReader *reader_;
+    // reused for every LAB read, see GetReadBufferEventConfig
+    std::shared_ptr<StReadBufferEventConfig> read_buf_ev_cfg_;
     uint8_t *gsl_engine_model_;
     uint32_t gsl_engine_model_size_;
     uint8_t *gsl_conf_levels_;
@@ -589,6 +595,8 @@ class StreamSoundTrigger : public Stream {
     std::shared_ptr<CaptureProfile> cap_prof_;
     uint32_t conf_levels_intf_version_;
     std::vector<PalRingBufferReader *> reader_list_;
+    // second stage engines share reader_list_[1] through it, see SendRecognitionConfig
+    std::shared_ptr<PalRingBufferFanout> lab_fanout_;
     st_confidence_levels_info *st_conf_levels_;
     st_confidence_levels_info_v2 *st_conf_levels_v2_;
     bool capture_requested_;
@@ -62,6 +62,7 @@
 
 #define LOG_TAG "PAL: Stream"
 #include <semaphore.h>
+#include <time.h>
 #include "Stream.h"
 #include "StreamPCM.h"
 #include "StreamInCall.h"
@@ -79,22 +80,105 @@
 
 std::shared_ptr<ResourceManager> Stream::rm = nullptr;
 std::mutex Stream::mBaseStreamMutex;
-std::mutex Stream::pauseMutex;
-std::condition_variable Stream::pauseCV;
 
 
 void Stream::handleSoftPauseCallBack(uint64_t hdl, uint32_t event_id,
                                         void *data __unused,
                                         uint32_t event_size __unused) {
+    Stream *s = reinterpret_cast<Stream *>(hdl);
 
     PAL_DBG(LOG_TAG,"Event id %x ", event_id);
 
-    if (event_id == EVENT_ID_SOFT_PAUSE_PAUSE_COMPLETE) {
+    if (event_id == EVENT_ID_SOFT_PAUSE_PAUSE_COMPLETE && s) {
         PAL_DBG(LOG_TAG, "Pause done");
-        pauseCV.notify_all();
+        s->signalRampEvent(event_id);
     }
 }
 
+/*
+ * Arm before the command that starts the ramp is sent, so that a completion
+ * event racing with the caller is not lost.
+ */
+void Stream::armRampEvent(uint32_t eventId)
+{
+    std::lock_guard<std::mutex> lock(mRampMutex);
+
+    mRampEventId = eventId;
+    mRampArmed = true;
+    mRampDone = false;
+}
+
+/* Called when the command that would start the ramp failed. */
+void Stream::disarmRampEvent()
+{
+    std::lock_guard<std::mutex> lock(mRampMutex);
+
+    mRampArmed = false;
+    mRampDone = false;
+}
+
+/*
+ * Wait for the armed event for at most timeoutUs. Returns 0 when the DSP
+ * reported completion and -ETIMEDOUT when the full ramp period elapsed,
+ * which is also what happens when the event is not registered.
+ */
+int32_t Stream::waitRampEvent(uint32_t timeoutUs)
+{
+    std::unique_lock<std::mutex> lock(mRampMutex);
+    int32_t status = 0;
+
+    if (!mRampArmed)
+        return -EINVAL;
+
+    mRampCV.wait_for(lock, std::chrono::microseconds(timeoutUs),
+                     [this] { return mRampDone; });
+    if (!mRampDone) {
+        PAL_DBG(LOG_TAG, "event %x not received in %u us", mRampEventId, timeoutUs);
+        status = -ETIMEDOUT;
+    }
+    mRampArmed = false;
+    return status;
+}
+
+void Stream::signalRampEvent(uint32_t eventId)
+{
+    std::lock_guard<std::mutex> lock(mRampMutex);
+
+    if (!mRampArmed || eventId != mRampEventId)
+        return;
+
+    mRampDone = true;
+    mRampCV.notify_all();
+}
+
+/*
+ * Consume or produce bytes at real-time pace while the card is offline or
+ * SSR-up is pending. Buffers are scheduled back to back on an absolute
+ * CLOCK_MONOTONIC deadline, so the time the client spends between calls is
+ * not added on top of each buffer. The deadline is rebased when a new offline
+ * window starts or the client fell behind by more than a buffer. Callers must
+ * not hold mStreamMutex so control calls are not stalled meanwhile.
+ */
+void Stream::paceVirtualSink(size_t bytes, uint32_t frameSize, uint32_t sampleRate)
+{
+    struct timespec ts;
+    uint64_t nowNs = 0, durationNs = 0;
+
+    if (!frameSize || !sampleRate)
+        return;
+
+    durationNs = (uint64_t)bytes * 1000000000ULL / frameSize / sampleRate;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    nowNs = (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    if (mVirtualSinkDeadlineNs + durationNs < nowNs)
+        mVirtualSinkDeadlineNs = nowNs;
+    mVirtualSinkDeadlineNs += durationNs;
+
+    ts.tv_sec = mVirtualSinkDeadlineNs / 1000000000ULL;
+    ts.tv_nsec = mVirtualSinkDeadlineNs % 1000000000ULL;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR);
+}
+
 Stream* Stream::create(struct pal_stream_attributes *sAttr, struct pal_device *dAttr,
     uint32_t noOfDevices, struct modifier_kv *modifiers, uint32_t noOfModifiers)
 {
@@ -123,6 +207,14 @@ Stream* Stream::create(struct pal_stream_attributes *sAttr, struct pal_device *d
     }
     PAL_VERBOSE(LOG_TAG,"get RM instance success and noOfDevices %d \n", noOfDevices);
 
+    /* voice UI/ACD stream and sound model configs are parsed on first use */
+    if (sAttr->type == PAL_STREAM_VOICE_UI)
+        SoundTriggerPlatformInfo::GetInstance()->LoadDeferredConfig();
+    else if (sAttr->type == PAL_STREAM_ACD ||
+             sAttr->type == PAL_STREAM_SENSOR_PCM_DATA ||
+             sAttr->type == PAL_STREAM_CONTEXT_PROXY)
+        ACDPlatformInfo::GetInstance()->LoadDeferredConfig();
+
     if (sAttr->type == PAL_STREAM_NON_TUNNEL || sAttr->type == PAL_STREAM_CONTEXT_PROXY)
         goto stream_create;
 
@@ -792,6 +884,71 @@ bool Stream::isStreamAudioOutFmtSupported(pal_audio_fmt_t format)
     }
 }
 
+size_t Stream::getIovecSize(const struct pal_iovec *iov, uint32_t iovcnt)
+{
+    size_t total = 0;
+
+    for (uint32_t i = 0; i < iovcnt; i++)
+        total += iov[i].len;
+    return total;
+}
+
+/* Streams without a scatter/gather data path coalesce the spans into one
+ * bounce buffer and go through the regular read/write.
+ */
+int32_t Stream::writev(const struct pal_iovec *iov, uint32_t iovcnt)
+{
+    struct pal_buffer buf;
+    size_t total = getIovecSize(iov, iovcnt);
+    size_t offset = 0;
+    int32_t status = 0;
+
+    if (!total)
+        return 0;
+
+    memset(&buf, 0, sizeof(buf));
+    buf.buffer = (uint8_t *)malloc(total);
+    if (!buf.buffer) {
+        PAL_ERR(LOG_TAG, "failed to allocate %zu bytes", total);
+        return -ENOMEM;
+    }
+    for (uint32_t i = 0; i < iovcnt; i++) {
+        ar_mem_cpy(buf.buffer + offset, iov[i].len, iov[i].base, iov[i].len);
+        offset += iov[i].len;
+    }
+    buf.size = total;
+    status = write(&buf);
+    free(buf.buffer);
+    return status;
+}
+
+int32_t Stream::readv(const struct pal_iovec *iov, uint32_t iovcnt)
+{
+    struct pal_buffer buf;
+    size_t offset = 0;
+    size_t len = 0;
+    int32_t status = 0;
+
+    memset(&buf, 0, sizeof(buf));
+    buf.size = getIovecSize(iov, iovcnt);
+    if (!buf.size)
+        return 0;
+
+    buf.buffer = (uint8_t *)malloc(buf.size);
+    if (!buf.buffer) {
+        PAL_ERR(LOG_TAG, "failed to allocate %zu bytes", buf.size);
+        return -ENOMEM;
+    }
+    status = read(&buf);
+    for (uint32_t i = 0; i < iovcnt && status > 0 && offset < (size_t)status; i++) {
+        len = std::min(iov[i].len, (size_t)status - offset);
+        ar_mem_cpy(iov[i].base, iov[i].len, buf.buffer + offset, len);
+        offset += len;
+    }
+    free(buf.buffer);
+    return status;
+}
+
 int32_t Stream::getTimestamp(struct pal_session_time *stime)
 {
     int32_t status = 0;
@@ -805,6 +962,10 @@ int32_t Stream::getTimestamp(struct pal_session_time *stime)
         PAL_ERR(LOG_TAG, "Sound card offline, status %d", status);
         goto exit;
     }
+    /* served from the session clock without a getParam round trip */
+    if (session->getExtrapolatedTimestamp(stime) == 0)
+        goto exit;
+
     rm->lockResourceManagerMutex();
     status = session->getTimestamp(stime);
     rm->unlockResourceManagerMutex();
@@ -1029,6 +1190,8 @@ int32_t Stream::disconnectStreamDevice(Stream* streamHandle, pal_device_id_t dev
 int32_t Stream::disconnectStreamDevice_l(Stream* streamHandle, pal_device_id_t dev_id)
 {
     int32_t status = 0;
+    /* keep in-flight read/write out of the session while devices change */
+    std::lock_guard<std::mutex> dataLock(mDataMutex);
 
     if (currentState == STREAM_IDLE) {
         for (int i = 0; i < mDevices.size(); i++) {
@@ -1099,6 +1262,8 @@ int32_t Stream::connectStreamDevice_l(Stream* streamHandle, struct pal_device *d
     std::shared_ptr<Device> dev = nullptr;
     std::string newBackEndName;
     std::string curBackEndName;
+    /* keep in-flight read/write out of the session while devices change */
+    std::lock_guard<std::mutex> dataLock(mDataMutex);
 
     if (!dattr) {
         PAL_ERR(LOG_TAG, "invalid params");
@@ -1775,26 +1940,6 @@ bool Stream::checkStreamMatch(pal_device_id_t pal_device_id,
     return match;
 }
 
-int Stream::initStreamSmph()
-{
-    return sem_init(&mInUse, 0, 1);
-}
-
-int Stream::deinitStreamSmph()
-{
-    return sem_destroy(&mInUse);
-}
-
-int Stream::postStreamSmph()
-{
-    return sem_post(&mInUse);
-}
-
-int Stream::waitStreamSmph()
-{
-    return sem_wait(&mInUse);
-}
-
 void Stream::handleStreamException(struct pal_stream_attributes *attributes,
                                    pal_stream_callback cb, uint64_t cookie)
 {
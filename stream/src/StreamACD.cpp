@@ -59,6 +59,7 @@ StreamACD::StreamACD(struct pal_stream_attributes *sattr,
     acd_states_ = {};
     use_lpi_ = false;
     cached_event_data_ = nullptr;
+    detected_ev_cfg_ = std::make_shared<ACDDetectedEventConfig>(nullptr);
     callback_ = nullptr;
     cookie_ = 0;
     cur_state_ = nullptr;
@@ -552,7 +553,7 @@ notify:
          *  Unlock it before calling callback */
         notificationInProgress = true;
         mutex_.unlock();
-        callback_((pal_stream_handle_t *)this, 0, ev_payload, event_size, cookie_);
+        callback_(getStreamHandle(), 0, ev_payload, event_size, cookie_);
         free(ev_payload);
         ev_payload = NULL;
         mutex_.lock();
@@ -575,13 +576,25 @@ void StreamACD::SetEngineDetectionData(struct acd_context_event *event)
 {
     PAL_DBG(LOG_TAG, "Enter");
     mStreamMutex.lock();
-    std::shared_ptr<ACDEventConfig> ev_cfg(
-       new ACDDetectedEventConfig((void *)event));
-    cur_state_->ProcessEvent(ev_cfg);
+    cur_state_->ProcessEvent(GetDetectedEventConfig((void *)event));
     mStreamMutex.unlock();
     PAL_DBG(LOG_TAG, "Exit");
 }
 
+/*
+ * Context events keep coming for as long as the stream is active, reuse one
+ * event per stream unless the pooled one is still referenced.
+ */
+std::shared_ptr<StreamACD::ACDEventConfig>
+StreamACD::GetDetectedEventConfig(void *event)
+{
+    if (!detected_ev_cfg_ || detected_ev_cfg_.use_count() > 1)
+        return std::make_shared<ACDDetectedEventConfig>(event);
+
+    detected_ev_cfg_->SetData(event);
+    return detected_ev_cfg_;
+}
+
 pal_device_id_t StreamACD::GetAvailCaptureDevice()
 {
     if (acd_info_->GetSupportDevSwitch() &&
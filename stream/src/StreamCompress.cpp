@@ -41,23 +41,20 @@
 #define COMPRESS_OFFLOAD_FRAGMENT_SIZE (32 * 1024)
 #define COMPRESS_OFFLOAD_NUM_FRAGMENTS 4
 
-std::condition_variable cvPause;
-
 static void handleSessionCallBack(uint64_t hdl, uint32_t event_id, void *data,
                                   uint32_t event_size)
 {
-    Stream *s = NULL;
+    Stream *s = reinterpret_cast<Stream *>(hdl);
     pal_stream_callback cb;
 
     PAL_DBG(LOG_TAG,"Event id %x ", event_id);
     if (event_id == EVENT_ID_SOFT_PAUSE_PAUSE_COMPLETE) {
         PAL_DBG(LOG_TAG,"Pause Done");
-        cvPause.notify_all();
+        s->signalRampEvent(event_id);
     }
     else {
-        s = reinterpret_cast<Stream *>(hdl);
         if (s->getCallBack(&cb) == 0)
-            cb(reinterpret_cast<pal_stream_handle_t *>(s), event_id, (uint32_t *)data,
+            cb(s->getStreamHandle(), event_id, (uint32_t *)data,
                event_size, s->cookie);
     }
 }
@@ -243,6 +240,9 @@ int32_t StreamCompress::close()
         }
         mStreamMutex.lock();
     }
+    /* wait for in-flight read/write to leave the session */
+    mDataMutex.lock();
+    mDataMutex.unlock();
     rm->lockGraph();
     status = session->close(this);
     rm->unlockGraph();
@@ -309,6 +309,9 @@ int32_t StreamCompress::stop()
             rm->deregisterDevice(mDevices[i], this);
         }
         rm->unlockActiveStream();
+        /* wait for in-flight read/write before stopping the session */
+        mDataMutex.lock();
+        mDataMutex.unlock();
         switch (mStreamAttr->direction) {
         case PAL_AUDIO_OUTPUT:
             PAL_VERBOSE(LOG_TAG,"In PAL_AUDIO_OUTPUT case, device count - %zu", mDevices.size());
@@ -635,24 +638,26 @@ int32_t StreamCompress::write(struct pal_buffer *buf)
     if ((currentState == STREAM_OPENED) ||
         (currentState == STREAM_STARTED) ||
         (currentState == STREAM_PAUSED)) {
+        /* hand over to the data path lock, see StreamPCM::write */
+        mDataMutex.lock();
+        mStreamMutex.unlock();
         status = session->write(this, SHMEM_ENDPOINT, buf, &size, 0);
+        mDataMutex.unlock();
         if (0 != status) {
             PAL_ERR(LOG_TAG, "session write failed with status %d", status);
             if (errno == -ENETRESET && rm->cardState != CARD_STATUS_OFFLINE) {
                 PAL_ERR(LOG_TAG, "Sound card offline, informing rm");
                 rm->ssrHandler(CARD_STATUS_OFFLINE);
-                mStreamMutex.unlock();
                 return errno;
             } else if (rm->cardState == CARD_STATUS_OFFLINE) {
-                mStreamMutex.unlock();
                 return errno;
             } else {
-                mStreamMutex.unlock();
                 return status;
             }
         }
-        if ((currentState != STREAM_STARTED) &&
-            !(currentState == STREAM_PAUSED && isPaused)) {
+        mStreamMutex.lock();
+        if ((currentState == STREAM_OPENED) ||
+            (currentState == STREAM_PAUSED && !isPaused)) {
             currentState = STREAM_STARTED;
             // register device only after graph is actually started
             mStreamMutex.unlock();
@@ -731,12 +736,16 @@ int32_t StreamCompress::setParameters(uint32_t param_id, void *payload)
                 setConfigStatus = session->setConfig(this, MODULE, DEVICEPP_MUTE);
                 if (setConfigStatus) {
                     PAL_INFO(LOG_TAG, "DevicePP Mute failed");
+                } else {
+                    /* device PP mute reports no ramp completion, sleep it out */
+                    usleep(ResourceManager::getMuteRampPeriod());
                 }
-                usleep(MUTE_RAMP_PERIOD); // Wait for mute to ramp down
                 status = session->setParameters(this, 0,
                                                 PAL_PARAM_ID_DEVICE_ROTATION,
                                                 payload);
-                usleep(MUTE_RAMP_PERIOD); // Wait for channel swap to take affect
+                /* nothing to settle unmuted or when the swap was not applied */
+                if (!setConfigStatus && !status)
+                    usleep(ResourceManager::getMuteRampPeriod());
                 setConfigStatus = session->setConfig(this, MODULE, DEVICEPP_UNMUTE);
                 if (setConfigStatus) {
                     PAL_INFO(LOG_TAG, "DevicePP Unmute failed");
@@ -861,7 +870,6 @@ int32_t StreamCompress::pause_l()
     struct pal_vol_ctrl_ramp_param ramp_param;
     struct pal_volume_data *voldata = NULL;
     struct pal_volume_data *volume = NULL;
-    std::unique_lock<std::mutex> pauseLock(pauseMutex);
 
     //AF will try to pause the stream during SSR.
     if (rm->cardState == CARD_STATUS_OFFLINE) {
@@ -916,16 +924,16 @@ int32_t StreamCompress::pause_l()
         volume = NULL;
         voldata = NULL;
 
+        armRampEvent(EVENT_ID_SOFT_PAUSE_PAUSE_COMPLETE);
         status = session->setConfig(this, MODULE, PAUSE_TAG);
         if (0 != status) {
+            disarmRampEvent();
             PAL_ERR(LOG_TAG,"session setConfig for pause failed with status %d",status);
             goto exit;
         }
         PAL_DBG(LOG_TAG, "Waiting for Pause to complete");
-        if (session->isPauseRegistrationDone)
-            cvPause.wait_for(pauseLock, std::chrono::microseconds(VOLUME_RAMP_PERIOD));
-        else
-            usleep(VOLUME_RAMP_PERIOD);
+        /* without pause event registration this is a plain ramp period wait */
+        waitRampEvent(ResourceManager::getVolumeRampPeriod());
         isPaused = true;
         currentState = STREAM_PAUSED;
         PAL_VERBOSE(LOG_TAG,"session pause successful, state %d", currentState);
@@ -1006,6 +1014,9 @@ int32_t StreamCompress::flush()
         return 0;
     }
 
+    /* wait for in-flight write before flushing the session */
+    mDataMutex.lock();
+    mDataMutex.unlock();
     return session->flush();
 }
 
@@ -191,6 +191,9 @@ int32_t  StreamInCall::close()
         mStreamMutex.lock();
     }
 
+    /* wait for in-flight read/write to leave the session */
+    mDataMutex.lock();
+    mDataMutex.unlock();
     rm->lockGraph();
     status = session->close(this);
     rm->unlockGraph();
@@ -328,6 +331,9 @@ int32_t StreamInCall::stop()
                 session, mStreamAttr->direction, currentState);
 
     if (currentState == STREAM_STARTED || currentState == STREAM_PAUSED) {
+        /* wait for in-flight read/write before stopping the session */
+        mDataMutex.lock();
+        mDataMutex.unlock();
         switch (mStreamAttr->direction) {
         case PAL_AUDIO_OUTPUT:
             PAL_VERBOSE(LOG_TAG, "In PAL_AUDIO_OUTPUT case, device count - %zu",
@@ -501,14 +507,21 @@ int32_t  StreamInCall::read(struct pal_buffer* buf)
         }
         size = buf->size;
         memset(buf->buffer, 0, size);
-        usleep((uint64_t)size * 1000000 / streamSize / sampleRate);
+        mStreamMutex.unlock();
+        paceVirtualSink(size, streamSize, sampleRate);
         PAL_DBG(LOG_TAG, "Sound card offline, dropped buffer size - %d", size);
         status = size;
-        goto exit;
+        goto unlocked_exit;
     }
 
     if (currentState == STREAM_STARTED) {
+        /* hand over to the data path lock so that control calls are not
+         * blocked for up to a period by pcm_read
+         */
+        mDataMutex.lock();
+        mStreamMutex.unlock();
         status = session->read(this, SHMEM_ENDPOINT, buf, &size);
+        mDataMutex.unlock();
         if (0 != status) {
             PAL_ERR(LOG_TAG, "session read is failed with status %d", status);
             if (errno == -ENETRESET &&
@@ -518,15 +531,15 @@ int32_t  StreamInCall::read(struct pal_buffer* buf)
                 size = buf->size;
                 status = size;
                 PAL_DBG(LOG_TAG, "dropped buffer size - %d", size);
-                goto exit;
+                goto unlocked_exit;
             } else if (rm->cardState == CARD_STATUS_OFFLINE) {
                 size = buf->size;
                 status = size;
                 PAL_DBG(LOG_TAG, "dropped buffer size - %d", size);
-                goto exit;
+                goto unlocked_exit;
             } else {
                 status = errno;
-                goto exit;
+                goto unlocked_exit;
             }
         }
     } else {
@@ -534,11 +547,11 @@ int32_t  StreamInCall::read(struct pal_buffer* buf)
         status = -EINVAL;
         goto exit;
     }
-    mStreamMutex.unlock();
     PAL_VERBOSE(LOG_TAG, "Exit. session read successful size - %d", size);
     return size;
 exit :
     mStreamMutex.unlock();
+unlocked_exit:
     PAL_VERBOSE(LOG_TAG, "Exit session read failed status %d", status);
     return status;
 }
@@ -570,16 +583,19 @@ int32_t  StreamInCall::write(struct pal_buffer* buf)
             return -EINVAL;
         }
         size = buf->size;
-        usleep((uint64_t)size * 1000000 / frameSize / sampleRate);
-        PAL_DBG(LOG_TAG, "dropped buffer size - %d", size);
         mStreamMutex.unlock();
+        paceVirtualSink(size, frameSize, sampleRate);
+        PAL_DBG(LOG_TAG, "dropped buffer size - %d", size);
         PAL_VERBOSE(LOG_TAG, "Exit size: %d", size);
         return size;
     }
 
     if (currentState == STREAM_STARTED) {
-        status = session->write(this, SHMEM_ENDPOINT, buf, &size, 0);
+        /* hand over to the data path lock, see StreamPCM::write */
+        mDataMutex.lock();
         mStreamMutex.unlock();
+        status = session->write(this, SHMEM_ENDPOINT, buf, &size, 0);
+        mDataMutex.unlock();
         if (0 != status) {
             PAL_ERR(LOG_TAG, "session write is failed with status %d", status);
 
@@ -692,7 +708,6 @@ int32_t StreamInCall::mute(bool state)
 int32_t StreamInCall::pause_l()
 {
     int32_t status = 0;
-    std::unique_lock<std::mutex> pauseLock(pauseMutex);
     PAL_DBG(LOG_TAG, "Enter. session handle - %pK", session);
     if (rm->cardState == CARD_STATUS_OFFLINE) {
         cachedState = STREAM_PAUSED;
@@ -701,17 +716,17 @@ int32_t StreamInCall::pause_l()
         goto exit;
     }
 
+    armRampEvent(EVENT_ID_SOFT_PAUSE_PAUSE_COMPLETE);
     status = session->setConfig(this, MODULE, PAUSE_TAG);
     if (0 != status) {
+        disarmRampEvent();
         PAL_ERR(LOG_TAG, "session setConfig for pause failed with status %d",
                 status);
         goto exit;
     }
     PAL_DBG(LOG_TAG, "Waiting for Pause to complete");
-    if (session->isPauseRegistrationDone)
-        pauseCV.wait_for(pauseLock, std::chrono::microseconds(VOLUME_RAMP_PERIOD));
-    else
-        usleep(VOLUME_RAMP_PERIOD);
+    /* without pause event registration this is a plain ramp period wait */
+    waitRampEvent(ResourceManager::getVolumeRampPeriod());
     isPaused = true;
     currentState = STREAM_PAUSED;
     PAL_DBG(LOG_TAG, "Exit. session setConfig successful");
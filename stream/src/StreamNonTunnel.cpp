@@ -40,7 +40,7 @@ static void handleSessionCallBack(uint64_t hdl, uint32_t event_id, void *data,
     Stream *s = NULL;
     s = reinterpret_cast<Stream *>(hdl);
     if (s->streamCb)
-        s->streamCb(reinterpret_cast<pal_stream_handle_t *>(s), event_id, (uint32_t *)data,
+        s->streamCb(s->getStreamHandle(), event_id, (uint32_t *)data,
           event_size, s->cookie);
 }
 
@@ -630,7 +630,7 @@ int32_t StreamNonTunnel::ssrDownHandler()
 
     ssrInNTMode = true;
     if (streamCb)
-        streamCb(reinterpret_cast<pal_stream_handle_t *>(this), PAL_STREAM_CBK_EVENT_ERROR, NULL, 0, this->cookie);
+        streamCb(getStreamHandle(), PAL_STREAM_CBK_EVENT_ERROR, NULL, 0, this->cookie);
 
     mStreamMutex.unlock();
 
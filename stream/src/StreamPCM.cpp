@@ -33,11 +33,28 @@
 #include "StreamPCM.h"
 #include "Session.h"
 #include "SessionAlsaPcm.h"
+#include "SessionAlsaUtils.h"
 #include "ResourceManager.h"
 #include "Device.h"
 #include <unistd.h>
 #include <chrono>
 
+static void handleSessionCallBack(uint64_t hdl, uint32_t event_id, void *data,
+                                  uint32_t event_size)
+{
+    Stream *s = reinterpret_cast<Stream *>(hdl);
+    pal_stream_callback cb = NULL;
+
+    if (event_id == PAL_STREAM_CBK_EVENT_WRITE_READY ||
+        event_id == PAL_STREAM_CBK_EVENT_READ_DONE) {
+        if (s->getCallBack(&cb) == 0 && cb)
+            cb(s->getStreamHandle(), event_id, (uint32_t *)data,
+               event_size, s->cookie);
+    } else {
+        Stream::handleSoftPauseCallBack(hdl, event_id, data, event_size);
+    }
+}
+
 StreamPCM::StreamPCM(const struct pal_stream_attributes *sattr, struct pal_device *dattr,
                     const uint32_t no_of_devices, const struct modifier_kv *modifiers,
                     const uint32_t no_of_modifiers, const std::shared_ptr<ResourceManager> rm)
@@ -54,6 +71,8 @@ StreamPCM::StreamPCM(const struct pal_stream_attributes *sattr, struct pal_devic
     }
 
     session = NULL;
+    streamCb = NULL;
+    cookie = 0;
     mGainLevel = -1;
     std::shared_ptr<Device> dev = nullptr;
     mStreamAttr = (struct pal_stream_attributes *)nullptr;
@@ -170,9 +189,10 @@ StreamPCM::StreamPCM(const struct pal_stream_attributes *sattr, struct pal_devic
     }
 
 
-    // Register for Soft pause events
-    if (mStreamAttr->direction == PAL_AUDIO_OUTPUT )
-        session->registerCallBack(handleSoftPauseCallBack, (uint64_t)this);
+    // Register for Soft pause and non-blocking readiness events
+    if (mStreamAttr->direction == PAL_AUDIO_OUTPUT ||
+        (mStreamAttr->flags & PAL_STREAM_FLAG_NON_BLOCKING_MASK))
+        session->registerCallBack(handleSessionCallBack, (uint64_t)this);
 
     mStreamMutex.unlock();
     PAL_DBG(LOG_TAG, "Exit. state %d", currentState);
@@ -302,6 +322,9 @@ int32_t  StreamPCM::close()
         mStreamMutex.lock();
     }
 
+    /* wait for in-flight read/write to leave the session */
+    mDataMutex.lock();
+    mDataMutex.unlock();
     rm->lockGraph();
     status = session->close(this);
     rm->unlockGraph();
@@ -641,6 +664,9 @@ int32_t StreamPCM::stop()
             rm->deregisterDevice(mDevices[i], this);
         }
         rm->unlockActiveStream();
+        /* wait for in-flight read/write before stopping the session */
+        mDataMutex.lock();
+        mDataMutex.unlock();
         switch (mStreamAttr->direction) {
         case PAL_AUDIO_OUTPUT:
             PAL_VERBOSE(LOG_TAG, "In PAL_AUDIO_OUTPUT case, device count - %zu",
@@ -866,6 +892,21 @@ exit:
 }
 
 int32_t  StreamPCM::read(struct pal_buffer* buf)
+{
+    return readData(buf, NULL, 0);
+}
+
+int32_t  StreamPCM::readv(const struct pal_iovec *iov, uint32_t iovcnt)
+{
+    /* mmap capture has no span aware session path */
+    if (SessionAlsaUtils::isMmapUsecase(*mStreamAttr))
+        return Stream::readv(iov, iovcnt);
+
+    return readData(NULL, iov, iovcnt);
+}
+
+int32_t  StreamPCM::readData(struct pal_buffer *buf, const struct pal_iovec *iov,
+                             uint32_t iovcnt)
 {
     int32_t status = 0;
     int32_t size;
@@ -887,33 +928,49 @@ int32_t  StreamPCM::read(struct pal_buffer* buf)
             status =  -EINVAL;
             goto exit;
         }
-        size = buf->size;
-        memset(buf->buffer, 0, size);
-        usleep((uint64_t)size * 1000000 / streamSize / sampleRate);
+        if (buf) {
+            size = buf->size;
+            memset(buf->buffer, 0, size);
+        } else {
+            size = getIovecSize(iov, iovcnt);
+            for (uint32_t i = 0; i < iovcnt; i++)
+                memset(iov[i].base, 0, iov[i].len);
+        }
+        mStreamMutex.unlock();
+        paceVirtualSink(size, streamSize, sampleRate);
         PAL_DBG(LOG_TAG, "Sound card offline, dropped buffer size - %d", size);
         status = size;
-        goto exit;
+        goto unlocked_exit;
     }
 
     if (currentState == STREAM_STARTED) {
-        status = session->read(this, SHMEM_ENDPOINT, buf, &size);
+        /* hand over to the data path lock so that control calls are not
+         * blocked for up to a period by pcm_read
+         */
+        mDataMutex.lock();
+        mStreamMutex.unlock();
+        if (buf)
+            status = session->read(this, SHMEM_ENDPOINT, buf, &size);
+        else
+            status = session->readv(this, SHMEM_ENDPOINT, iov, iovcnt, &size);
+        mDataMutex.unlock();
         if (0 != status) {
             PAL_ERR(LOG_TAG, "session read is failed with status %d", status);
             if (errno == -ENETRESET &&
                 rm->cardState != CARD_STATUS_OFFLINE) {
                 PAL_ERR(LOG_TAG, "Sound card offline, informing RM");
                 rm->ssrHandler(CARD_STATUS_OFFLINE);
-                size = buf->size;
+                size = buf ? buf->size : getIovecSize(iov, iovcnt);
                 status = size;
                 PAL_DBG(LOG_TAG, "dropped buffer size - %d", size);
-                goto exit;
+                goto unlocked_exit;
             } else if (rm->cardState == CARD_STATUS_OFFLINE) {
-                size = buf->size;
+                size = buf ? buf->size : getIovecSize(iov, iovcnt);
                 status = size;
                 PAL_DBG(LOG_TAG, "dropped buffer size - %d", size);
-                goto exit;
+                goto unlocked_exit;
             } else {
-                goto exit;
+                goto unlocked_exit;
             }
         }
     } else {
@@ -921,16 +978,31 @@ int32_t  StreamPCM::read(struct pal_buffer* buf)
         status = -EINVAL;
         goto exit;
     }
-    mStreamMutex.unlock();
     PAL_VERBOSE(LOG_TAG, "Exit. session read successful size - %d", size);
     return size;
 exit :
     mStreamMutex.unlock();
+unlocked_exit:
     PAL_DBG(LOG_TAG, "Exit. session read failed status %d", status);
     return status;
 }
 
 int32_t StreamPCM::write(struct pal_buffer* buf)
+{
+    return writeData(buf, NULL, 0);
+}
+
+int32_t StreamPCM::writev(const struct pal_iovec *iov, uint32_t iovcnt)
+{
+    /* mmap playback has no span aware session path */
+    if (SessionAlsaUtils::isMmapUsecase(*mStreamAttr))
+        return Stream::writev(iov, iovcnt);
+
+    return writeData(NULL, iov, iovcnt);
+}
+
+int32_t StreamPCM::writeData(struct pal_buffer *buf, const struct pal_iovec *iov,
+                             uint32_t iovcnt)
 {
     int32_t status = 0;
     int32_t size = 0;
@@ -958,10 +1030,10 @@ int32_t StreamPCM::write(struct pal_buffer* buf)
             status = -EINVAL;
             goto exit;
         }
-        size = buf->size;
-        usleep((uint64_t)size * 1000000 / frameSize / sampleRate);
-        PAL_DBG(LOG_TAG, "dropped buffer size - %d", size);
+        size = buf ? buf->size : getIovecSize(iov, iovcnt);
         mStreamMutex.unlock();
+        paceVirtualSink(size, frameSize, sampleRate);
+        PAL_DBG(LOG_TAG, "dropped buffer size - %d", size);
         PAL_VERBOSE(LOG_TAG, "Exit size: %d", size);
         return size;
     }
@@ -969,8 +1041,16 @@ int32_t StreamPCM::write(struct pal_buffer* buf)
     // we should allow writes to go through in Start/Pause state as well.
     if ((currentState == STREAM_STARTED) ||
         (currentState == STREAM_PAUSED) ) {
-        status = session->write(this, SHMEM_ENDPOINT, buf, &size, 0);
+        /* hand over to the data path lock so that volume, mute and device
+         * switch are not blocked for up to a period by pcm_write
+         */
+        mDataMutex.lock();
         mStreamMutex.unlock();
+        if (buf)
+            status = session->write(this, SHMEM_ENDPOINT, buf, &size, 0);
+        else
+            status = session->writev(this, SHMEM_ENDPOINT, iov, iovcnt, &size, 0);
+        mDataMutex.unlock();
         if (0 != status) {
             PAL_ERR(LOG_TAG, "session write is failed with status %d", status);
 
@@ -979,12 +1059,12 @@ int32_t StreamPCM::write(struct pal_buffer* buf)
                 rm->cardState != CARD_STATUS_OFFLINE) {
                 PAL_ERR(LOG_TAG, "Sound card offline, informing RM");
                 rm->ssrHandler(CARD_STATUS_OFFLINE);
-                size = buf->size;
+                size = buf ? buf->size : getIovecSize(iov, iovcnt);
                 status = size;
                 PAL_DBG(LOG_TAG, "dropped buffer size - %d", size);
                 goto exit;
             } else if (rm->cardState == CARD_STATUS_OFFLINE) {
-                size = buf->size;
+                size = buf ? buf->size : getIovecSize(iov, iovcnt);
                 status = size;
                 PAL_DBG(LOG_TAG, "dropped buffer size - %d", size);
                 goto exit;
@@ -1019,13 +1099,16 @@ exit:
     return status;
 }
 
-int32_t  StreamPCM::registerCallBack(pal_stream_callback /*cb*/, uint64_t /*cookie*/)
+int32_t  StreamPCM::registerCallBack(pal_stream_callback cb, uint64_t cookie)
 {
+    streamCb = cb;
+    this->cookie = cookie;
     return 0;
 }
 
-int32_t  StreamPCM::getCallBack(pal_stream_callback * /*cb*/)
+int32_t  StreamPCM::getCallBack(pal_stream_callback *cb)
 {
+    *cb = streamCb;
     return 0;
 }
 
@@ -1097,12 +1180,16 @@ int32_t  StreamPCM::setParameters(uint32_t param_id, void *payload)
                 setConfigStatus = session->setConfig(this, MODULE, DEVICEPP_MUTE);
                 if (setConfigStatus) {
                     PAL_INFO(LOG_TAG, "DevicePP Mute failed");
+                } else {
+                    /* device PP mute reports no ramp completion, sleep it out */
+                    usleep(ResourceManager::getMuteRampPeriod());
                 }
-                usleep(MUTE_RAMP_PERIOD); // Wait for Mute ramp down to happen
                 status = session->setParameters(this, 0,
                                                 PAL_PARAM_ID_DEVICE_ROTATION,
                                                 payload);
-                usleep(MUTE_RAMP_PERIOD); // Wait for channel swap to take affect
+                /* nothing to settle unmuted or when the swap was not applied */
+                if (!setConfigStatus && !status)
+                    usleep(ResourceManager::getMuteRampPeriod());
                 setConfigStatus = session->setConfig(this, MODULE, DEVICEPP_UNMUTE);
                 if (setConfigStatus) {
                     PAL_INFO(LOG_TAG, "DevicePP Unmute failed");
@@ -1185,7 +1272,6 @@ int32_t StreamPCM::pause_l()
     struct pal_vol_ctrl_ramp_param ramp_param;
     struct pal_volume_data *voldata = NULL;
     struct pal_volume_data *volume = NULL;
-    std::unique_lock<std::mutex> pauseLock(pauseMutex);
     PAL_DBG(LOG_TAG, "Enter. session handle - %pK", session);
     if (rm->cardState == CARD_STATUS_OFFLINE) {
         cachedState = STREAM_PAUSED;
@@ -1236,17 +1322,17 @@ int32_t StreamPCM::pause_l()
         volume = NULL;
         voldata = NULL;
 
+        armRampEvent(EVENT_ID_SOFT_PAUSE_PAUSE_COMPLETE);
         status = session->setConfig(this, MODULE, PAUSE_TAG);
         if (0 != status) {
+           disarmRampEvent();
            PAL_ERR(LOG_TAG, "session setConfig for pause failed with status %d",
                     status);
            goto exit;
         }
         PAL_DBG(LOG_TAG, "Waiting for Pause to complete");
-        if (session->isPauseRegistrationDone)
-            pauseCV.wait_for(pauseLock, std::chrono::microseconds(VOLUME_RAMP_PERIOD));
-        else
-            usleep(VOLUME_RAMP_PERIOD);
+        /* without pause event registration this is a plain ramp period wait */
+        waitRampEvent(ResourceManager::getVolumeRampPeriod());
         isPaused = true;
         currentState = STREAM_PAUSED;
         PAL_DBG(LOG_TAG, "session setConfig successful");
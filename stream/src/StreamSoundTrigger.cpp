@@ -95,6 +95,7 @@ StreamSoundTrigger::StreamSoundTrigger(struct pal_stream_attributes *sattr,
     int32_t enable_concurrency_count = 0;
     int32_t disable_concurrency_count = 0;
     reader_ = nullptr;
+    read_buf_ev_cfg_ = std::make_shared<StReadBufferEventConfig>(nullptr);
     detection_state_ = ENGINE_IDLE;
     notification_state_ = ENGINE_IDLE;
     inBufSize = BUF_SIZE_CAPTURE;
@@ -257,6 +258,7 @@ StreamSoundTrigger::~StreamSoundTrigger() {
 
     st_states_.clear();
     engines_.clear();
+    lab_fanout_.reset();
     mStreamMutex.unlock();
 
     rm->deregisterStream(this);
@@ -390,20 +392,20 @@ int32_t StreamSoundTrigger::read(struct pal_buffer* buf) {
         this->force_nlpi_vote = true;
     }
 
-    std::shared_ptr<StEventConfig> ev_cfg(
-        new StReadBufferEventConfig((void *)buf));
-    size = cur_state_->ProcessEvent(ev_cfg);
+    size = cur_state_->ProcessEvent(GetReadBufferEventConfig((void *)buf));
 
     /*
      * st stream read pcm data from ringbuffer with almost no
-     * delay, sleep for some time after each read even if read
-     * fails or no enough data in ring buffer
+     * delay, wait for the next buffer to be filled after each read
+     * even if read fails or no enough data in ring buffer, bounded
+     * by the duration of one buffer
      */
     if (size <= 0 || reader_->getUnreadSize() < buf->size) {
         sleep_ms = (buf->size * BITS_PER_BYTE * MS_PER_SEC) /
             (sm_cfg_->GetSampleRate() * sm_cfg_->GetBitWidth() *
              sm_cfg_->GetOutChannels());
-        std::this_thread::sleep_for(std::chrono::milliseconds(sleep_ms));
+        if (reader_->waitForData(buf->size, sleep_ms) == -EINVAL)
+            std::this_thread::sleep_for(std::chrono::milliseconds(sleep_ms));
     }
 
     PAL_VERBOSE(LOG_TAG, "Exit, read size %d", size);
@@ -1553,6 +1555,7 @@ int32_t StreamSoundTrigger::SendRecognitionConfig(
     uint32_t num_conf_levels = 0;
     uint32_t ring_buffer_len = 0;
     uint32_t ring_buffer_size = 0;
+    bool shared_reader = false;
 
     PAL_DBG(LOG_TAG, "Enter");
     if (!config) {
@@ -1742,8 +1745,15 @@ int32_t StreamSoundTrigger::SendRecognitionConfig(
     ring_buffer_size = (ring_buffer_len / MS_PER_SEC) * sm_cfg_->GetSampleRate() *
                        sm_cfg_->GetBitWidth() *
                        sm_cfg_->GetOutChannels() / BITS_PER_BYTE;
+    /*
+     * With pipelined second stage, keyword detection and user verification
+     * share one reader through a fan-out window, so the LAB is copied out of
+     * the ring once and a reject from either engine cancels the other.
+     */
+    shared_reader = st_info_->GetPipelinedSecondStage() && engines_.size() > 2;
     status = gsl_engine_->CreateBuffer(ring_buffer_size,
-                                       engines_.size(), reader_list_);
+                                       shared_reader ? 2 : engines_.size(),
+                                       reader_list_);
     if (status) {
         PAL_ERR(LOG_TAG, "Failed to get ring buf reader, status %d", status);
         goto error_exit;
@@ -1756,7 +1766,16 @@ int32_t StreamSoundTrigger::SendRecognitionConfig(
     for (i = 0; i < engines_.size(); i++) {
         if (engines_[i]->GetEngine()->GetEngineType() ==
             ST_SM_ID_SVA_F_STAGE_GMM) {
-            reader_ = reader_list_[i];
+            reader_ = reader_list_[shared_reader ? 0 : i];
+        } else if (shared_reader) {
+            if (!lab_fanout_)
+                lab_fanout_ = std::make_shared<PalRingBufferFanout>(
+                    reader_list_[1], engines_.size() - 1);
+            status = engines_[i]->GetEngine()->SetBufferFanout(lab_fanout_);
+            if (status) {
+                PAL_ERR(LOG_TAG, "Failed to set ring buffer fan-out");
+                goto error_exit;
+            }
         } else {
             status = engines_[i]->GetEngine()->SetBufferReader(
                 reader_list_[i]);
@@ -1923,7 +1942,7 @@ int32_t StreamSoundTrigger::notifyClient(bool detection) {
             " total processing time: %llums",
             (long long)total_process_duration);
         mStreamMutex.unlock();
-        callback_((pal_stream_handle_t *)this, 0, (uint32_t *)rec_event,
+        callback_(getStreamHandle(), 0, (uint32_t *)rec_event,
                   event_size, cookie_);
 
         /*
@@ -2874,6 +2893,8 @@ exit:
 }
 
 void StreamSoundTrigger::SetDetectedToEngines(bool detected) {
+    if (detected && lab_fanout_)
+        lab_fanout_->start();
     for (auto& eng: engines_) {
         if (eng->GetEngineId() != ST_SM_ID_SVA_F_STAGE_GMM) {
             PAL_VERBOSE(LOG_TAG, "Notify detection event %d to engine %d",
@@ -2982,6 +3003,20 @@ void StreamSoundTrigger::TransitTo(int32_t state_id) {
             mInstanceID, oldState.c_str(), newState.c_str());
 }
 
+/*
+ * LAB reads arrive every buffer period while the client drains, so reuse one
+ * event per stream instead of allocating three objects per read. Only fall
+ * back to a fresh event if the pooled one is still referenced.
+ */
+std::shared_ptr<StreamSoundTrigger::StEventConfig>
+StreamSoundTrigger::GetReadBufferEventConfig(void *buf) {
+    if (!read_buf_ev_cfg_ || read_buf_ev_cfg_.use_count() > 1)
+        return std::make_shared<StReadBufferEventConfig>(buf);
+
+    read_buf_ev_cfg_->SetData(buf);
+    return read_buf_ev_cfg_;
+}
+
 int32_t StreamSoundTrigger::ProcessInternalEvent(
     std::shared_ptr<StEventConfig> ev_cfg) {
     return cur_state_->ProcessEvent(ev_cfg);
@@ -3107,6 +3142,7 @@ int32_t StreamSoundTrigger::StIdle::ProcessEvent(
             if(st_stream_.gsl_engine_)
                 st_stream_.gsl_engine_->DetachStream(&st_stream_, true);
             st_stream_.reader_list_.clear();
+            st_stream_.lab_fanout_.reset();
             if (st_stream_.sm_info_) {
                 delete st_stream_.sm_info_;
                 st_stream_.sm_info_ = nullptr;
@@ -3332,6 +3368,7 @@ int32_t StreamSoundTrigger::StLoaded::ProcessEvent(
             st_stream_.engines_.clear();
             st_stream_.gsl_engine_->DetachStream(&st_stream_, true);
             st_stream_.reader_list_.clear();
+            st_stream_.lab_fanout_.reset();
             if (st_stream_.sm_info_) {
                 delete st_stream_.sm_info_;
                 st_stream_.sm_info_ = nullptr;
@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Failure path test for PalInitTaskGraph. A failing task must cancel the
+ * tasks that depend on it, directly or through another task, and leave
+ * independent tasks and waitAll() alone. Tasks added after the failure run
+ * normally, and a task waiting on its own graph must get -EDEADLK.
+ *
+ * Usage : PalInitTaskGraphTest [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include <atomic>
+#include "PalCommon.h"
+#include "PalInitTaskGraph.h"
+
+uint32_t pal_log_lvl = PAL_LOG_ERR;
+
+#define IG_TEST_DEFAULT_ITERATIONS  200
+#define IG_TEST_FAIL_STATUS         (-EIO)
+
+static std::atomic<uint32_t> errors(0);
+
+static void expect(const char *what, int32_t got, int32_t expected)
+{
+    if (got != expected) {
+        fprintf(stdout, "%s: status %d, expected %d\n", what, got, expected);
+        errors++;
+    }
+}
+
+static void checkFailure()
+{
+    PalInitTaskGraph graph;
+    std::atomic<uint32_t> order(0);
+    std::atomic<bool> cancelledRan(false);
+    uint32_t slow = 0, afterSlow = 0;
+
+    int32_t slowTask = graph.add("slow", [&]() {
+        usleep(1000);
+        slow = order++;
+        return 0;
+    });
+    int32_t failTask = graph.add("fail", []() {
+        return IG_TEST_FAIL_STATUS;
+    });
+    int32_t afterSlowTask = graph.add("after_slow", [&]() {
+        afterSlow = order++;
+        return 0;
+    }, {slowTask});
+    int32_t afterFailTask = graph.add("after_fail", [&]() {
+        cancelledRan = true;
+        return 0;
+    }, {failTask});
+    int32_t transitiveTask = graph.add("transitive", [&]() {
+        cancelledRan = true;
+        return 0;
+    }, {afterSlowTask, afterFailTask});
+
+    expect("unknown dependency", graph.add("bad", []() { return 0; }, {99}), -EINVAL);
+
+    expect("independent task", graph.wait(afterSlowTask), 0);
+    if (afterSlow <= slow) {
+        fprintf(stdout, "task ran before its dependency\n");
+        errors++;
+    }
+    expect("failed task", graph.wait(failTask), IG_TEST_FAIL_STATUS);
+    expect("dependent of failed task", graph.wait(afterFailTask), -ECANCELED);
+    expect("transitive dependent", graph.wait(transitiveTask), -ECANCELED);
+    if (cancelledRan) {
+        fprintf(stdout, "dependent of a failed task was run\n");
+        errors++;
+    }
+
+    /* the failure must not stick to the graph */
+    expect("waitAll after failure", graph.waitAll(), 0);
+    int32_t lateTask = graph.add("late", []() { return 0; }, {slowTask});
+    expect("task added after failure", graph.wait(lateTask), 0);
+    expect("waitAll after late task", graph.waitAll(), 0);
+
+    int32_t selfWaitTask = graph.add("self_wait", [&]() {
+        return graph.waitAll();
+    });
+    expect("waitAll from a worker", graph.wait(selfWaitTask), -EDEADLK);
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t iterations = IG_TEST_DEFAULT_ITERATIONS;
+
+    if (argc > 1)
+        iterations = strtoul(argv[1], NULL, 0);
+
+    for (uint32_t i = 0; i < iterations; i++)
+        checkFailure();
+
+    fprintf(stdout, "%u iterations, %u errors\n%s\n", iterations, errors.load(),
+            errors.load() ? "FAIL" : "PASS");
+    return errors.load() ? 1 : 0;
+}
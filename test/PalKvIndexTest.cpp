@@ -0,0 +1,427 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Checks the hashed selector index behind PayloadBuilder::findKVs() against
+ * the linear xml order scan it replaced, and times both. The tables come
+ * from each usecase xml given (the target's own by default), parsed with the
+ * PayloadBuilder expat handlers and queried with every selector combination
+ * the xml defines, then from randomized tables as an extra case.
+ *
+ * Usage : PalKvIndexTest [lookups] [seed] [usecaseKvManager.xml ...]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <chrono>
+#include <map>
+#include <random>
+#include <set>
+#include <tuple>
+#include "PayloadBuilder.h"
+
+#define KV_TEST_DEFAULT_XML      "/vendor/etc/usecaseKvManager.xml"
+#define KV_TEST_XML_READ_SIZE    1024
+#define KV_TEST_NUM_TYPES        24
+#define KV_TEST_BLOCKS_PER_TABLE 48
+#define KV_TEST_MAX_KV_PER_BLOCK 12
+#define KV_TEST_VALUES_PER_SEL   4
+#define KV_TEST_DEFAULT_LOOKUPS  200000
+
+static const selector_type_t testSelTypes[] = {
+    DIRECTION_SEL, BITWIDTH_SEL, INSTANCE_SEL, SUB_TYPE_SEL,
+    STREAM_TYPE_SEL, CUSTOM_CONFIG_SEL,
+};
+#define KV_TEST_NUM_SEL_TYPES (sizeof(testSelTypes) / sizeof(testSelTypes[0]))
+
+class PalKvIndexTest : public PayloadBuilder
+{
+public:
+    using PayloadBuilder::all_streams;
+    using PayloadBuilder::all_streampps;
+    using PayloadBuilder::all_devices;
+    using PayloadBuilder::all_devicepps;
+    using PayloadBuilder::buildKVIndex;
+};
+
+static std::string selectorValue(selector_type_t type, uint32_t idx)
+{
+    return "SEL" + std::to_string(type) + "_VAL" + std::to_string(idx);
+}
+
+/* findKVs() as it was before the index: sorted compare or subset match */
+static bool compareSelectorPairs(std::vector<std::pair<selector_type_t, std::string>> selector_pairs,
+    std::vector<std::pair<selector_type_t, std::string>> filled_selector_pairs)
+{
+    size_t count = 0;
+
+    if (selector_pairs.size() == filled_selector_pairs.size()) {
+        std::sort(filled_selector_pairs.begin(), filled_selector_pairs.end());
+        std::sort(selector_pairs.begin(), selector_pairs.end());
+        return std::equal(selector_pairs.begin(), selector_pairs.end(),
+            filled_selector_pairs.begin());
+    }
+    for (size_t i = 0; i < filled_selector_pairs.size(); i++) {
+        if (selector_pairs.end() != std::find(selector_pairs.begin(),
+            selector_pairs.end(), filled_selector_pairs[i]))
+            count++;
+    }
+    return filled_selector_pairs.size() == count;
+}
+
+static bool scanKVs(std::vector<std::pair<selector_type_t, std::string>> &filled_selector_pairs,
+    uint32_t type, std::vector<allKVs> &any_type, std::vector<std::pair<int, int>> &keyVector)
+{
+    bool found = false;
+
+    for (size_t i = 0; i < any_type.size(); i++) {
+        if (!PayloadBuilder::isIdTypeAvailable(type, any_type[i].id_type))
+            continue;
+        for (size_t j = 0; j < any_type[i].keys_values.size(); j++) {
+            struct kvInfo &info = any_type[i].keys_values[j];
+            bool match = filled_selector_pairs.empty() ? info.selector_pairs.empty() :
+                compareSelectorPairs(info.selector_pairs, filled_selector_pairs);
+
+            if (!match)
+                continue;
+            for (size_t k = 0; k < info.kv_pairs.size(); k++)
+                keyVector.push_back(std::make_pair(info.kv_pairs[k].key,
+                    info.kv_pairs[k].value));
+            found = true;
+            break;
+        }
+    }
+    return found;
+}
+
+static void fillTable(std::vector<allKVs> &table, std::mt19937 &rng)
+{
+    std::uniform_int_distribution<uint32_t> coin(0, 99);
+
+    table.clear();
+    for (int i = 0; i < KV_TEST_BLOCKS_PER_TABLE; i++) {
+        allKVs block;
+        int numIds = 1 + rng() % 3;
+        int numKvs = 1 + rng() % KV_TEST_MAX_KV_PER_BLOCK;
+
+        for (int n = 0; n < numIds; n++)
+            block.id_type.push_back(rng() % KV_TEST_NUM_TYPES);
+        for (int n = 0; n < numKvs; n++) {
+            kvInfo info;
+
+            for (size_t t = 0; t < KV_TEST_NUM_SEL_TYPES; t++) {
+                if (coin(rng) < 55)
+                    continue;
+                /* a selector may list several values, as in "RX,TX" */
+                int numValues = coin(rng) < 20 ? 2 : 1;
+                for (int v = 0; v < numValues; v++)
+                    info.selector_pairs.push_back(std::make_pair(testSelTypes[t],
+                        selectorValue(testSelTypes[t], rng() % KV_TEST_VALUES_PER_SEL)));
+            }
+            /* block order matters: the first match of a block wins */
+            if (coin(rng) < 10)
+                info.selector_pairs.clear();
+            for (int k = 0; k < 1 + (int)(rng() % 3); k++)
+                info.kv_pairs.push_back({(unsigned int)rng(), (unsigned int)rng()});
+            block.keys_values.push_back(info);
+        }
+        table.push_back(block);
+    }
+}
+
+/* one value per selector type, like getSelectorValues(), sometimes unknown */
+static void fillQuery(std::vector<std::pair<selector_type_t, std::string>> &filled,
+    std::mt19937 &rng)
+{
+    filled.clear();
+    for (size_t t = 0; t < KV_TEST_NUM_SEL_TYPES; t++) {
+        if (rng() % 2)
+            continue;
+        filled.push_back(std::make_pair(testSelTypes[t],
+            selectorValue(testSelTypes[t], rng() % (KV_TEST_VALUES_PER_SEL + 1))));
+    }
+    std::shuffle(filled.begin(), filled.end(), rng);
+}
+
+typedef std::vector<std::pair<selector_type_t, std::string>> kvSelectors;
+
+struct kvQuery {
+    std::vector<allKVs> *table;
+    uint32_t type;
+    kvSelectors selectors;
+};
+
+static std::vector<std::vector<allKVs> *> allTables()
+{
+    return {&PalKvIndexTest::all_streams, &PalKvIndexTest::all_streampps,
+            &PalKvIndexTest::all_devices, &PalKvIndexTest::all_devicepps};
+}
+
+/* the same expat setup as PayloadBuilder::init(), without the snapshot */
+static int loadUsecaseXml(const char *xmlFile)
+{
+    struct user_xml_data tagData;
+    XML_Parser parser;
+    FILE *file = NULL;
+    void *buf = NULL;
+    int bytesRead = 0;
+    int ret = 0;
+
+    memset(&tagData, 0, sizeof(tagData));
+    for (auto table : allTables())
+        table->clear();
+
+    file = fopen(xmlFile, "r");
+    if (!file)
+        return -ENOENT;
+
+    parser = XML_ParserCreate(NULL);
+    if (!parser) {
+        fclose(file);
+        return -ENOMEM;
+    }
+    XML_SetUserData(parser, &tagData);
+    XML_SetElementHandler(parser, PayloadBuilder::startTag, PayloadBuilder::endTag);
+    XML_SetCharacterDataHandler(parser, PayloadBuilder::handleData);
+
+    while (1) {
+        buf = XML_GetBuffer(parser, KV_TEST_XML_READ_SIZE);
+        if (!buf) {
+            ret = -ENOMEM;
+            break;
+        }
+        bytesRead = fread(buf, 1, KV_TEST_XML_READ_SIZE, file);
+        if (XML_ParseBuffer(parser, bytesRead, bytesRead == 0) == XML_STATUS_ERROR) {
+            ret = -EINVAL;
+            break;
+        }
+        if (bytesRead == 0)
+            break;
+    }
+
+    XML_ParserFree(parser);
+    fclose(file);
+    return ret;
+}
+
+/*
+ * Queries the way resolveKVs() builds them: one value for every selector
+ * type the blocks of that stream type/dev id use. Each kvInfo contributes
+ * its own values, once per listed value, and the selector types it does not
+ * name take a value some other kvInfo of the type uses, or none at all.
+ */
+static void usecaseQueries(std::vector<kvQuery> &queries)
+{
+    std::set<std::tuple<std::vector<allKVs> *, uint32_t, kvSelectors>> seen;
+
+    for (auto table : allTables()) {
+        std::set<uint32_t> types;
+
+        for (auto &block : *table)
+            types.insert(block.id_type.begin(), block.id_type.end());
+
+        for (auto type : types) {
+            std::map<selector_type_t, std::string> typeValues;
+            std::vector<const kvInfo *> infos;
+
+            for (auto &block : *table) {
+                if (!PayloadBuilder::isIdTypeAvailable(type, block.id_type))
+                    continue;
+                for (auto &info : block.keys_values) {
+                    infos.push_back(&info);
+                    for (auto &pair : info.selector_pairs)
+                        typeValues.emplace(pair.first, pair.second);
+                }
+            }
+
+            for (auto info : infos) {
+                std::map<selector_type_t, std::vector<std::string>> own;
+                size_t variants = 1;
+
+                for (auto &pair : info->selector_pairs) {
+                    own[pair.first].push_back(pair.second);
+                    variants = std::max(variants, own[pair.first].size());
+                }
+                for (size_t v = 0; v < variants; v++) {
+                    for (int fill = 0; fill < 2; fill++) {
+                        kvQuery query = {table, type, {}};
+
+                        for (auto &tv : typeValues) {
+                            auto it = own.find(tv.first);
+                            if (it != own.end())
+                                query.selectors.push_back(std::make_pair(tv.first,
+                                    it->second[std::min(v, it->second.size() - 1)]));
+                            else if (fill)
+                                query.selectors.push_back(tv);
+                        }
+                        if (seen.insert(std::make_tuple(table, type,
+                                                        query.selectors)).second)
+                            queries.push_back(query);
+                    }
+                }
+            }
+        }
+    }
+}
+
+static void randomQueries(std::vector<kvQuery> &queries, uint32_t count,
+    std::mt19937 &rng)
+{
+    std::vector<std::vector<allKVs> *> tables = allTables();
+    kvSelectors filled;
+
+    for (uint32_t i = 0; i < count; i++) {
+        auto table = tables[rng() % tables.size()];
+        uint32_t type = rng() % (KV_TEST_NUM_TYPES + 1);
+
+        fillQuery(filled, rng);
+        queries.push_back({table, type, filled});
+    }
+}
+
+/*
+ * Every query must return the same KVs in the same order through both
+ * paths, then the query list is timed through both. Returns mismatches.
+ */
+static uint32_t checkQueries(const char *name, std::vector<kvQuery> &queries,
+    uint32_t lookups)
+{
+    std::vector<std::pair<int, int>> expected, actual;
+    kvSelectors query;
+    uint32_t mismatches = 0, hits = 0;
+    bool foundScan, foundIndex;
+
+    if (queries.empty()) {
+        fprintf(stdout, "%s: no queries\n", name);
+        return 1;
+    }
+
+    for (size_t i = 0; i < queries.size(); i++) {
+        kvQuery &q = queries[i];
+
+        expected.clear();
+        actual.clear();
+        query = q.selectors;
+        foundScan = scanKVs(query, q.type, *q.table, expected);
+        query = q.selectors;
+        foundIndex = PayloadBuilder::findKVs(query, q.type, *q.table, actual);
+        if (foundScan != foundIndex || expected != actual) {
+            if (mismatches++ < 10)
+                fprintf(stdout, "%s: mismatch: query %zu type %u, %zu selectors, "
+                        "scan found %d (%zu kvs), index found %d (%zu kvs)\n",
+                        name, i, q.type, q.selectors.size(), foundScan,
+                        expected.size(), foundIndex, actual.size());
+        }
+        hits += foundScan ? 1 : 0;
+    }
+    fprintf(stdout, "%s: %zu queries, %u hits, %u mismatches\n", name,
+            queries.size(), hits, mismatches);
+
+    /* microbenchmark: the same query stream through both paths */
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < lookups; i++) {
+        kvQuery &q = queries[i % queries.size()];
+
+        query = q.selectors;
+        expected.clear();
+        scanKVs(query, q.type, *q.table, expected);
+    }
+    auto scanNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < lookups; i++) {
+        kvQuery &q = queries[i % queries.size()];
+
+        query = q.selectors;
+        actual.clear();
+        PayloadBuilder::findKVs(query, q.type, *q.table, actual);
+    }
+    auto indexNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    if (lookups) {
+        fprintf(stdout, "%s: scan:  %lld ns/lookup\n", name,
+                (long long)(scanNs / lookups));
+        fprintf(stdout, "%s: index: %lld ns/lookup\n", name,
+                (long long)(indexNs / lookups));
+    }
+
+    return mismatches;
+}
+
+int main(int argc, char *argv[])
+{
+    std::vector<const char *> xmlFiles;
+    std::vector<kvQuery> queries;
+    uint32_t lookups = KV_TEST_DEFAULT_LOOKUPS;
+    uint32_t seed = 1;
+    uint32_t failures = 0;
+    int ret = 0;
+
+    if (argc > 1)
+        lookups = strtoul(argv[1], NULL, 0);
+    if (argc > 2)
+        seed = strtoul(argv[2], NULL, 0);
+    for (int i = 3; i < argc; i++)
+        xmlFiles.push_back(argv[i]);
+    if (xmlFiles.empty())
+        xmlFiles.push_back(KV_TEST_DEFAULT_XML);
+
+    for (auto xmlFile : xmlFiles) {
+        ret = loadUsecaseXml(xmlFile);
+        if (ret) {
+            fprintf(stdout, "%s: load failed %d\n", xmlFile, ret);
+            failures++;
+            continue;
+        }
+        PalKvIndexTest::buildKVIndex();
+        queries.clear();
+        usecaseQueries(queries);
+        failures += checkQueries(xmlFile, queries, lookups);
+    }
+
+    std::mt19937 rng(seed);
+    for (auto table : allTables())
+        fillTable(*table, rng);
+    PalKvIndexTest::buildKVIndex();
+    queries.clear();
+    randomQueries(queries, lookups, rng);
+    failures += checkQueries("random", queries, lookups);
+
+    fprintf(stdout, "%s\n", failures ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,405 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Multi-reader stress test for PalRingBuffer. One writer streams a position
+ * dependent byte pattern through write() and reserveWrite()/commitWrite()
+ * while several readers drain it through read(), getReadRegions()/
+ * commitRead() and waitForData(), and a transient reader is repeatedly
+ * added and removed. Resize and reset under an outstanding peek are
+ * checked once the stream is done. Every reader checks each byte it gets against its
+ * stream position, so any lost, duplicated or overwritten byte fails.
+ * Finally a fan-out window is shared by a fast chunked consumer and a slow
+ * consumer of the whole range, and a cancel must wake a blocked consumer.
+ *
+ * Usage : PalRingBufferTest [megabytes] [seed]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+#include "PalCommon.h"
+#include "PalRingBuffer.h"
+
+uint32_t pal_log_lvl = PAL_LOG_ERR;
+
+#define RB_TEST_BUFFER_SIZE     (16 * 1024 + 17)
+#define RB_TEST_NUM_READERS     4
+#define RB_TEST_MAX_CHUNK       4096
+#define RB_TEST_DEFAULT_MB      64
+#define RB_TEST_SYNC_BYTES      64
+#define RB_TEST_FANOUT_CHUNK    320
+#define RB_TEST_FANOUT_WAIT_MS  20
+
+static std::atomic<uint64_t> totalWritten(0);
+static std::atomic<bool> writerDone(false);
+static std::atomic<uint32_t> errors(0);
+
+static inline uint8_t patternByte(uint64_t pos)
+{
+    return (uint8_t)(pos ^ (pos >> 8) ^ (pos >> 16) ^ (pos >> 29) ^ 0x5a);
+}
+
+static void reportError(const char *who, uint64_t pos, uint8_t got)
+{
+    if (errors.fetch_add(1) < 10)
+        fprintf(stdout, "%s: byte %llu is 0x%02x, expected 0x%02x\n", who,
+                (unsigned long long)pos, got, patternByte(pos));
+}
+
+static void writerThread(PalRingBuffer *rb, uint64_t total, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::vector<uint8_t> chunk(RB_TEST_MAX_CHUNK);
+    struct pal_ring_buffer_region regions[PAL_RING_BUFFER_MAX_REGIONS];
+    uint64_t pos = 0;
+    size_t size, done;
+
+    while (pos < total) {
+        size = std::min((uint64_t)(1 + rng() % RB_TEST_MAX_CHUNK), total - pos);
+        if (rng() % 2) {
+            for (size_t i = 0; i < size; i++)
+                chunk[i] = patternByte(pos + i);
+            done = rb->write(chunk.data(), size);
+        } else {
+            done = rb->reserveWrite(regions, size);
+            for (size_t i = 0; i < regions[0].size; i++)
+                regions[0].data[i] = patternByte(pos + i);
+            for (size_t i = 0; i < done - regions[0].size; i++)
+                regions[1].data[i] = patternByte(pos + regions[0].size + i);
+            if (rb->commitWrite(done)) {
+                reportError("commitWrite", pos, 0);
+                break;
+            }
+        }
+        pos += done;
+        totalWritten.store(pos, std::memory_order_release);
+        if (!done)
+            std::this_thread::yield();
+    }
+    writerDone.store(true, std::memory_order_release);
+}
+
+/* drains the whole stream from position 0 */
+static void readerThread(PalRingBufferReader *reader, uint64_t total, int id)
+{
+    std::mt19937 rng(id);
+    std::vector<uint8_t> chunk(RB_TEST_MAX_CHUNK);
+    struct pal_ring_buffer_region regions[PAL_RING_BUFFER_MAX_REGIONS];
+    uint64_t pos = 0;
+    size_t size;
+    int32_t ret;
+
+    while (pos < total && errors.load() == 0) {
+        switch (rng() % 3) {
+        case 0:
+            ret = reader->read(chunk.data(), 1 + rng() % RB_TEST_MAX_CHUNK);
+            if (ret < 0) {
+                reportError("read", pos, 0);
+                return;
+            }
+            for (int32_t i = 0; i < ret; i++)
+                if (chunk[i] != patternByte(pos + i))
+                    reportError("read", pos + i, chunk[i]);
+            pos += ret;
+            break;
+        case 1:
+            size = reader->getReadRegions(regions, 1 + rng() % RB_TEST_MAX_CHUNK);
+            for (size_t i = 0; i < regions[0].size; i++)
+                if ((uint8_t)regions[0].data[i] != patternByte(pos + i))
+                    reportError("peek", pos + i, regions[0].data[i]);
+            for (size_t i = 0; i < size - regions[0].size; i++)
+                if ((uint8_t)regions[1].data[i] != patternByte(pos + regions[0].size + i))
+                    reportError("peek", pos + regions[0].size + i, regions[1].data[i]);
+            if (reader->commitRead(size)) {
+                reportError("commitRead", pos, 0);
+                return;
+            }
+            pos += size;
+            break;
+        default:
+            size = std::min((uint64_t)(1 + rng() % 512), total - pos);
+            ret = reader->waitForData(size, 100);
+            if (ret && ret != -ETIMEDOUT) {
+                reportError("waitForData", pos, 0);
+                return;
+            }
+            break;
+        }
+    }
+}
+
+/*
+ * Joins the stream at whatever position the writer is at, so it first
+ * locates its start position from the pattern, then checks bytes as usual.
+ */
+static void transientReaderThread(PalRingBuffer *rb, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::vector<uint8_t> chunk(RB_TEST_MAX_CHUNK);
+    uint64_t lo, hi, start, pos, got;
+    bool synced;
+    int32_t ret;
+
+    while (!writerDone.load(std::memory_order_acquire) && errors.load() == 0) {
+        lo = totalWritten.load(std::memory_order_acquire);
+        PalRingBufferReader *reader = rb->newReader();
+        reader->updateState(READER_ENABLED);
+        /* the writer may be one chunk ahead of totalWritten */
+        hi = totalWritten.load(std::memory_order_acquire) + RB_TEST_MAX_CHUNK;
+
+        synced = false;
+        got = 0;
+        pos = 0;
+        for (int n = 1 + rng() % 200; n > 0 && !writerDone.load(); n--) {
+            ret = reader->read(chunk.data() + got, (synced ? RB_TEST_MAX_CHUNK :
+                               RB_TEST_SYNC_BYTES) - got);
+            if (ret <= 0) {
+                std::this_thread::yield();
+                continue;
+            }
+            got += ret;
+            if (!synced) {
+                if (got < RB_TEST_SYNC_BYTES)
+                    continue;
+                for (start = lo; start <= hi && !synced; start++) {
+                    synced = true;
+                    for (uint64_t i = 0; i < got && synced; i++)
+                        synced = chunk[i] == patternByte(start + i);
+                }
+                if (!synced) {
+                    reportError("transient sync", lo, chunk[0]);
+                    break;
+                }
+                pos = start - 1 + got;
+                got = 0;
+                continue;
+            }
+            for (uint64_t i = 0; i < got; i++)
+                if (chunk[i] != patternByte(pos + i))
+                    reportError("transient", pos + i, chunk[i]);
+            pos += got;
+            got = 0;
+        }
+        rb->removeReader(reader);
+        delete reader;
+    }
+}
+
+/*
+ * reset() of a reader whose regions are still held must wait for the
+ * commit, and that commit must then fail instead of consuming.
+ */
+static void checkResetWaitsForPeek(PalRingBuffer *rb, PalRingBufferReader *reader)
+{
+    struct pal_ring_buffer_region regions[PAL_RING_BUFFER_MAX_REGIONS];
+    std::atomic<bool> resetDone(false);
+    uint8_t data[128];
+    size_t size;
+
+    for (int i = 0; i < (int)sizeof(data); i++)
+        data[i] = patternByte(i);
+    reader->updateState(READER_ENABLED);
+    rb->write(data, sizeof(data));
+    size = reader->getReadRegions(regions, sizeof(data));
+    if (size != sizeof(data)) {
+        fprintf(stdout, "peek returned %zu bytes\n", size);
+        errors++;
+        return;
+    }
+
+    std::thread resetter([&] { reader->reset(); resetDone.store(true); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    if (resetDone.load()) {
+        fprintf(stdout, "reset did not wait for the outstanding peek\n");
+        errors++;
+    }
+    if (memcmp(regions[0].data, data, regions[0].size)) {
+        fprintf(stdout, "peeked data changed before commit\n");
+        errors++;
+    }
+    if (reader->commitRead(size) != -EINVAL) {
+        fprintf(stdout, "commit after reset did not fail\n");
+        errors++;
+    }
+    resetter.join();
+    if (reader->getUnreadSize() != 0 || reader->isEnabled()) {
+        fprintf(stdout, "reader not reset after peek was released\n");
+        errors++;
+    }
+}
+
+static void fanoutConsumer(PalRingBufferFanout *fanout, size_t total,
+                           size_t chunk, uint32_t delayMs, int id)
+{
+    const char *data;
+    int32_t status;
+
+    for (size_t off = 0; off < total; off += chunk) {
+        size_t end = std::min(off + chunk, total);
+
+        while ((status = fanout->waitForData(end, RB_TEST_FANOUT_WAIT_MS)) ==
+               -ETIMEDOUT)
+            ;
+        if (status) {
+            fprintf(stdout, "fan-out consumer %d wait failed %d\n", id, status);
+            errors++;
+            break;
+        }
+        data = fanout->getData(off);
+        for (size_t i = 0; i < end - off; i++) {
+            if ((uint8_t)data[i] != patternByte(off + i)) {
+                reportError("fan-out consumer", off + i, data[i]);
+                break;
+            }
+        }
+        /* stands in for capi processing the chunk */
+        std::this_thread::sleep_for(std::chrono::milliseconds(delayMs));
+    }
+    fanout->release();
+}
+
+static void checkFanout()
+{
+    PalRingBuffer ring(RB_TEST_BUFFER_SIZE);
+    PalRingBufferReader *reader = ring.newReader();
+    PalRingBufferFanout *fanout = new PalRingBufferFanout(reader, 2);
+    size_t total = RB_TEST_BUFFER_SIZE - RB_TEST_FANOUT_CHUNK;
+    uint8_t data[100];
+    int32_t status = 0;
+
+    fanout->start();
+    std::thread fast(fanoutConsumer, fanout, total,
+                     (size_t)RB_TEST_FANOUT_CHUNK, 1, 0);
+    std::thread slow(fanoutConsumer, fanout, total, total, 50, 1);
+    for (size_t pos = 0; pos < total; pos += sizeof(data)) {
+        size_t size = std::min(sizeof(data), total - pos);
+
+        for (size_t i = 0; i < size; i++)
+            data[i] = patternByte(pos + i);
+        ring.write(data, size);
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    fast.join();
+    slow.join();
+    if (reader->isEnabled()) {
+        fprintf(stdout, "fan-out reader still enabled after release\n");
+        errors++;
+    }
+
+    /* a cancel must wake a consumer blocked on data that never comes */
+    fanout->start();
+    std::chrono::steady_clock::time_point begin =
+        std::chrono::steady_clock::now();
+    std::thread blocked([&] { status = fanout->waitForData(total, 2000); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    fanout->cancel();
+    blocked.join();
+    if (status != -ECANCELED ||
+        std::chrono::steady_clock::now() - begin > std::chrono::milliseconds(500)) {
+        fprintf(stdout, "cancel did not wake the fan-out consumer, status %d\n",
+                status);
+        errors++;
+    }
+    if (fanout->waitForData(1, 0) != -ECANCELED) {
+        fprintf(stdout, "wait after cancel did not fail\n");
+        errors++;
+    }
+
+    ring.removeReader(reader);
+    delete fanout;
+}
+
+int main(int argc, char *argv[])
+{
+    uint64_t total = (uint64_t)RB_TEST_DEFAULT_MB << 20;
+    uint32_t seed = 1;
+    PalRingBufferReader *readers[RB_TEST_NUM_READERS];
+    std::vector<std::thread> threads;
+
+    if (argc > 1)
+        total = strtoull(argv[1], NULL, 0) << 20;
+    if (argc > 2)
+        seed = strtoul(argv[2], NULL, 0);
+
+    PalRingBuffer *rb = new PalRingBuffer(RB_TEST_BUFFER_SIZE);
+    for (int i = 0; i < RB_TEST_NUM_READERS; i++) {
+        readers[i] = rb->newReader();
+        readers[i]->updateState(READER_ENABLED);
+    }
+
+    for (int i = 0; i < RB_TEST_NUM_READERS; i++)
+        threads.emplace_back(readerThread, readers[i], total, seed + i + 1);
+    threads.emplace_back(transientReaderThread, rb, seed + 100);
+    threads.emplace_back(writerThread, rb, total, seed);
+    for (auto &t : threads)
+        t.join();
+
+    for (int i = 0; i < RB_TEST_NUM_READERS; i++) {
+        if (readers[i]->getUnreadSize() != 0) {
+            fprintf(stdout, "reader %d left %zu bytes unread\n", i,
+                    readers[i]->getUnreadSize());
+            errors++;
+        }
+    }
+
+    /* a resize must restart the writer and every reader at the same place */
+    rb->resizeRingBuffer(RB_TEST_BUFFER_SIZE / 2);
+    uint8_t in[64], out[64];
+    for (int i = 0; i < (int)sizeof(in); i++)
+        in[i] = patternByte(i);
+    if (rb->write(in, sizeof(in)) != sizeof(in))
+        errors++;
+    for (int i = 0; i < RB_TEST_NUM_READERS; i++) {
+        if (readers[i]->read(out, sizeof(out)) != (int32_t)sizeof(out) ||
+            memcmp(in, out, sizeof(in))) {
+            fprintf(stdout, "reader %d out of sync after resize\n", i);
+            errors++;
+        }
+    }
+
+    checkResetWaitsForPeek(rb, readers[0]);
+    checkFanout();
+
+    delete rb;
+    fprintf(stdout, "%llu bytes through %d readers, %u errors\n%s\n",
+            (unsigned long long)total, RB_TEST_NUM_READERS, errors.load(),
+            errors.load() ? "FAIL" : "PASS");
+    return errors.load() ? 1 : 0;
+}
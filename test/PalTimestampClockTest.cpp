@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Host test for PalTimestampClock against a simulated session clock that
+ * runs slightly fast and is only sampled at 1 ms granularity, like SPR.
+ * Reads are spaced one 60 fps video frame apart, the way A/V sync clients
+ * poll, and most of them must be served by extrapolation within the
+ * accuracy bound. A silent stall must be caught by the next sample and a
+ * reset() must force a fresh one.
+ *
+ * Usage : PalTimestampClockTest [reads]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include "PalCommon.h"
+#include "PalTimestampClock.h"
+
+uint32_t pal_log_lvl = PAL_LOG_ERR;
+
+#define TS_TEST_DEFAULT_READS       150
+#define TS_TEST_FRAME_US            16000
+#define TS_TEST_DRIFT_PPM           150
+#define TS_TEST_GRANULARITY_US      100
+#define TS_TEST_STALL_US            50000
+/* percentage of reads that must not need a DSP round trip */
+#define TS_TEST_MIN_CLOCK_READS     75
+
+static uint32_t errors = 0;
+static uint64_t startUs = 0;
+static uint64_t stalledUs = 0;
+
+static uint64_t sessionTimeAt(uint64_t monoUs)
+{
+    uint64_t elapsed = monoUs - startUs - stalledUs;
+
+    return elapsed + elapsed * TS_TEST_DRIFT_PPM / 1000000;
+}
+
+static void takeSample(PalTimestampClock *clock)
+{
+    struct pal_session_time stime;
+    uint64_t now = PalTimestampClock::nowUs();
+    uint64_t sessUs = sessionTimeAt(now) / TS_TEST_GRANULARITY_US *
+                      TS_TEST_GRANULARITY_US;
+
+    stime.session_time.value_lsw = (uint32_t)sessUs;
+    stime.session_time.value_msw = (uint32_t)(sessUs >> 32);
+    stime.absolute_time = stime.session_time;
+    stime.timestamp.value_lsw = 0;
+    stime.timestamp.value_msw = 0;
+    clock->update(&stime, now);
+}
+
+/* error against the session time over [beforeUs, afterUs] around the read */
+static int64_t readError(const struct pal_session_time *stime, uint64_t beforeUs,
+                         uint64_t afterUs)
+{
+    int64_t got = (int64_t)(((uint64_t)stime->session_time.value_msw << 32) |
+                            stime->session_time.value_lsw);
+    int64_t lo = (int64_t)sessionTimeAt(beforeUs);
+    int64_t hi = (int64_t)sessionTimeAt(afterUs);
+
+    if (got < lo)
+        return got - lo;
+    if (got > hi)
+        return got - hi;
+    return 0;
+}
+
+static int32_t timedRead(PalTimestampClock *clock, struct pal_session_time *stime,
+                         int64_t *err)
+{
+    uint64_t beforeUs = PalTimestampClock::nowUs();
+    int32_t status = clock->read(stime);
+
+    if (status == 0)
+        *err = readError(stime, beforeUs, PalTimestampClock::nowUs());
+    return status;
+}
+
+/* returns the number of reads served by the clock */
+static uint32_t pollAtFrameRate(PalTimestampClock *clock, uint32_t reads)
+{
+    struct pal_session_time stime;
+    uint32_t served = 0;
+    int64_t err = 0;
+
+    for (uint32_t i = 0; i < reads; i++) {
+        if (timedRead(clock, &stime, &err) == 0) {
+            served++;
+            if (llabs(err) > PAL_TS_CLOCK_DEFAULT_ACCURACY_US) {
+                fprintf(stdout, "read %u off by %lld us\n", i, (long long)err);
+                errors++;
+            }
+        } else {
+            takeSample(clock);
+        }
+        usleep(TS_TEST_FRAME_US);
+    }
+
+    return served;
+}
+
+int main(int argc, char *argv[])
+{
+    PalTimestampClock clock;
+    struct pal_session_time stime;
+    int64_t err = 0;
+    uint32_t reads = TS_TEST_DEFAULT_READS;
+    uint32_t served = 0;
+
+    if (argc > 1)
+        reads = strtoul(argv[1], NULL, 0);
+
+    startUs = PalTimestampClock::nowUs();
+    served = pollAtFrameRate(&clock, reads);
+    fprintf(stdout, "%u of %u frame rate reads served by the clock\n",
+            served, reads);
+    if (served * 100 < reads * TS_TEST_MIN_CLOCK_READS) {
+        fprintf(stdout, "too few reads served by the clock\n");
+        errors++;
+    }
+
+    /* a stall the session does not report: the next sample must unlock */
+    stalledUs += TS_TEST_STALL_US;
+    takeSample(&clock);
+    if (timedRead(&clock, &stime, &err) == 0) {
+        fprintf(stdout, "clock still locked after a stall, off by %lld us\n",
+                (long long)err);
+        errors++;
+    }
+
+    /* a reported one */
+    pollAtFrameRate(&clock, 20);
+    clock.reset();
+    if (clock.read(&stime) != -EAGAIN) {
+        fprintf(stdout, "read after reset did not ask for a sample\n");
+        errors++;
+    }
+
+    fprintf(stdout, "%u errors\n%s\n", errors, errors ? "FAIL" : "PASS");
+    return errors ? 1 : 0;
+}
@@ -151,10 +151,16 @@ class ACDPlatformInfo : public SoundTriggerXml {
     bool IsACDEnabled() const;
     std::shared_ptr<StreamConfig> GetStreamConfig(const ACDUUID& uuid) const;
     std::shared_ptr<CaptureProfile> GetCapProfile(const std::string& name) const;
+    void SetDeferredConfig(const std::string &file, int64_t offset,
+        int64_t size) { deferred_xml_.Set(file, offset, size); }
+    /* parse stream configs and capture profiles on first use */
+    void LoadDeferredConfig() { deferred_xml_.Load(this, true); }
 
  private:
     ACDPlatformInfo();
     static std::shared_ptr<ACDPlatformInfo> me_;
+    static std::mutex me_mutex_;
+    SoundTriggerDeferredXml deferred_xml_;
     bool acd_enable_;
     bool support_device_switch_;
     bool support_nlpi_switch_;
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PAL_INIT_TASK_GRAPH_H
+#define PAL_INIT_TASK_GRAPH_H
+
+#include <stdint.h>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define PAL_INIT_TASK_MAX_WORKERS 3
+
+/*
+ * Dependency graph for bring-up work that is off the pal_init critical path.
+ *
+ * Each task is added with the ids of the tasks it depends on and runs on one
+ * of up to maxWorkers threads once all of its dependencies have completed.
+ * A task whose dependency failed is not run and completes with -ECANCELED.
+ * A failure only reaches the tasks that depend on it, waitAll() does not
+ * report it; callers check the tasks they need with wait().
+ * Workers exit when nothing is left to pick up and add() starts them again,
+ * so an idle graph holds no threads.
+ *
+ * A task must not wait on its own graph, the ordering has to be expressed as
+ * a dependency instead; wait() and waitAll() return -EDEADLK when called
+ * from a worker thread on unfinished work.
+ */
+class PalInitTaskGraph {
+public:
+    typedef std::function<int32_t()> task_fn;
+
+    explicit PalInitTaskGraph(uint32_t maxWorkers = PAL_INIT_TASK_MAX_WORKERS);
+    ~PalInitTaskGraph();
+
+    /* returns the task id, or -EINVAL if a dependency is unknown */
+    int32_t add(const char *name, task_fn fn, const std::vector<int32_t> &deps = {});
+    /* block until task id has completed and return its status */
+    int32_t wait(int32_t id);
+    /* block until every added task has completed, task status is not returned */
+    int32_t waitAll();
+    static bool isWorkerThread();
+
+private:
+    struct task {
+        std::string name;
+        task_fn fn;
+        std::vector<int32_t> deps;
+        bool started;
+        bool done;
+        int32_t status;
+    };
+
+    void workerLoop();
+    /* called with mutex_ held, -1 when no task is runnable */
+    int32_t nextRunnable(int32_t *depStatus);
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<task> tasks_;
+    std::vector<std::thread> workers_;
+    uint32_t maxWorkers_;
+    uint32_t liveWorkers_;
+    uint32_t unstarted_;
+    uint32_t pending_;
+};
+
+#endif //PAL_INIT_TASK_GRAPH_H
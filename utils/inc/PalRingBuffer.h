@@ -34,8 +34,11 @@
 
 
 #include <stdlib.h>
+#include <stdint.h>
+#include <atomic>
 #include <memory>
 #include <mutex>
+#include <condition_variable>
 #include <vector>
 #include <string>
 #include <iostream>
@@ -46,6 +49,38 @@
 
 #define DEFAULT_PAL_RING_BUFFER_SIZE 4096 * 10
 
+/*
+ * Single producer, multiple reader ring buffer.
+ *
+ * The writer and every reader track monotonic byte positions instead of
+ * wrapped offsets: writePos_ counts all bytes ever written and each reader's
+ * readPos_ counts the bytes it has consumed, so unread size is always
+ * writePos_ - readPos_ and the ring offset is pos % bufferEnd_. The writer
+ * publishes writePos_ with release after copying data in, readers publish
+ * readPos_ with release after copying data out, and each side loads the
+ * other's cursor with acquire, so the data path never takes a lock.
+ *
+ * mutex_ only serializes changes to the reader list. Each change publishes a
+ * new immutable copy of the list through readers_, which the writer walks
+ * without any lock while it holds listUsers_; the old copy is freed once
+ * the writer is no longer using it. Neither side of the data path takes a
+ * lock, so the LAB producer and the second stage consumers do not contend.
+ * newReader/removeReader may run concurrently with write, while reset and
+ * resizeRingBuffer are control path calls and must not race with write or
+ * read.
+ */
+
+/*
+ * A contiguous span of ring memory. Peek/reserve hand out at most two,
+ * the second one only when the span crosses the end of the buffer.
+ */
+struct pal_ring_buffer_region {
+    char *data;
+    size_t size;
+};
+
+#define PAL_RING_BUFFER_MAX_REGIONS 2
+
 typedef enum {
     READER_DISABLED = 0,
     READER_ENABLED = 1,
@@ -55,30 +90,51 @@ class PalRingBuffer;
 
 class PalRingBufferReader {
  public:
-     PalRingBufferReader(PalRingBuffer *buffer)
-         : ringBuffer_(buffer),
-           unreadSize_(0),
-           readOffset_(0),
-           state_(READER_DISABLED) {}
+     PalRingBufferReader(PalRingBuffer *buffer);
 
     ~PalRingBufferReader() {};
 
     size_t advanceReadOffset(size_t advanceSize);
     int32_t read(void* readBuffer, size_t readSize);
+    /*
+     * Zero copy read: expose up to maxSize unread bytes in place, the
+     * memory stays valid and unmodified until commitRead() or cancelRead()
+     * releases it. reset() waits for that release, so the thread holding
+     * the regions must not reset its own reader. commitRead() returns
+     * -EINVAL and consumes nothing if the reader was reset meanwhile.
+     */
+    size_t getReadRegions(struct pal_ring_buffer_region *regions, size_t maxSize);
+    int32_t commitRead(size_t size);
+    void cancelRead();
+    /*
+     * Block until at least minBytes are unread, the reader is disabled or
+     * reset, or timeoutMs elapses. Returns 0 when the data is available,
+     * -ETIMEDOUT on timeout and -EINVAL if the reader is not enabled.
+     */
+    int32_t waitForData(size_t minBytes, uint32_t timeoutMs);
     void updateState(pal_ring_buffer_reader_state state);
     void getIndices(uint32_t *startIndice, uint32_t *endIndice);
     size_t getUnreadSize();
     void reset();
-    bool isEnabled() { return state_ == READER_ENABLED; }
+    bool isEnabled() {
+        return state_.load(std::memory_order_acquire) == READER_ENABLED;
+    }
 
     friend class PalRingBuffer;
+    friend class PalRingBufferFanout;
     friend class StreamSoundTrigger;
 
  protected:
     PalRingBuffer *ringBuffer_;
-    size_t unreadSize_;
-    size_t readOffset_;
-    pal_ring_buffer_reader_state state_;
+    std::atomic<uint64_t> readPos_;
+    std::atomic<pal_ring_buffer_reader_state> state_;
+    /* threads inside read/advance or holding regions, reset() waits for 0 */
+    std::atomic<uint32_t> users_;
+    /* regions handed out by getReadRegions, only used by the consuming thread */
+    bool peekHeld_;
+    bool enterRead();
+    void leaveRead();
+    size_t advanceReadOffset_l(size_t advanceSize);
 };
 
 class PalRingBuffer {
@@ -87,15 +143,20 @@ class PalRingBuffer {
         : buffer_((char*)(new char[bufferSize])),
           startIndex(0),
           endIndex(0),
-          writeOffset_(0),
-          bufferEnd_(bufferSize) {}
+          writePos_(0),
+          bufferEnd_(bufferSize),
+          readers_(new std::vector<PalRingBufferReader*>()),
+          listUsers_(0),
+          reservedSize_(0),
+          waiters_(0) {}
 
     ~PalRingBuffer() {
         if (buffer_)
-            delete buffer_;
+            delete[] buffer_;
 
         for (int i = 0; i < readOffsets_.size(); i++)
             delete readOffsets_[i];
+        delete readers_.load(std::memory_order_relaxed);
     }
 
     PalRingBufferReader* newReader();
@@ -104,6 +165,12 @@ class PalRingBuffer {
     size_t read(std::shared_ptr<PalRingBufferReader>reader, void* readBuffer,
                 size_t readSize);
     size_t write(void* writeBuffer, size_t writeSize);
+    /*
+     * Zero copy write: expose up to size free bytes for the producer to
+     * fill in place, nothing is visible to readers until commitWrite().
+     */
+    size_t reserveWrite(struct pal_ring_buffer_region *regions, size_t size);
+    int32_t commitWrite(size_t size);
     size_t getFreeSize();
     void updateIndices(uint32_t startIndice, uint32_t endIndice);
     void reset();
@@ -113,12 +180,75 @@ class PalRingBuffer {
  protected:
     std::mutex mutex_;
     char* buffer_;
-    uint32_t startIndex;
-    uint32_t endIndex;
-    size_t writeOffset_;
+    std::atomic<uint32_t> startIndex;
+    std::atomic<uint32_t> endIndex;
+    std::atomic<uint64_t> writePos_;
     size_t bufferEnd_;
+    /* master reader list, only touched with mutex_ held */
     std::vector<PalRingBufferReader*> readOffsets_;
-    void updateUnReadSize(size_t writtenSize);
+    /* immutable copy of readOffsets_ the writer walks without mutex_ */
+    std::atomic<std::vector<PalRingBufferReader*> *> readers_;
+    /* non zero while the writer walks readers_ */
+    std::atomic<uint32_t> listUsers_;
+    void publishReaders_l();
+    std::vector<PalRingBufferReader*> *acquireReaders();
+    void releaseReaders();
+    size_t getFreeSize(const std::vector<PalRingBufferReader*> *readers);
+    void copyOut(uint64_t pos, void *dst, size_t size);
+    size_t getRegions(uint64_t pos, size_t size,
+                      struct pal_ring_buffer_region *regions);
+    /* set by reserveWrite, consumed by commitWrite */
+    std::atomic<size_t> reservedSize_;
+    /* readers blocked in waitForData, writer only signals when non zero */
+    std::mutex waitMutex_;
+    std::condition_variable dataCV_;
+    std::atomic<uint32_t> waiters_;
+    void wakeReaders();
     friend class PalRingBufferReader;
 };
+
+/*
+ * Fans one reader out to several consumers of the same range, e.g. the
+ * second stage engines of one detection. The data is copied out of the
+ * ring once into a linear window shared by all consumers: a consumer that
+ * needs bytes nobody has pulled yet pulls them itself, so no consumer waits
+ * for another one that is busy processing. Offsets are relative to the
+ * reader position when start() was called, and window memory stays valid
+ * until the next start(). cancel() fails every current and later wait of
+ * the window, so the first consumer to give up stops the others at once.
+ */
+class PalRingBufferFanout {
+ public:
+    PalRingBufferFanout(PalRingBufferReader *reader, uint32_t numConsumers);
+    ~PalRingBufferFanout();
+
+    void start();
+    void cancel();
+    void reset();
+    /* called once by each consumer when done, the last one disables the reader */
+    void release();
+    /*
+     * Block until [0, end) of the window is filled. Returns 0 when it is,
+     * -ETIMEDOUT on timeout, -ECANCELED after cancel(), -EINVAL if the
+     * reader was disabled and -ENOSPC if end does not fit in the window.
+     */
+    int32_t waitForData(size_t end, uint32_t timeoutMs);
+    char *getData(size_t offset) { return window_ + offset; }
+    void getIndices(uint32_t *startIndice, uint32_t *endIndice);
+
+ protected:
+    PalRingBufferReader *reader_;
+    uint32_t numConsumers_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    char *window_;
+    size_t windowSize_;
+    /* bytes of the window pulled from the ring so far */
+    size_t filled_;
+    /* a consumer is copying from the ring into the window */
+    bool pumping_;
+    bool cancelled_;
+    uint32_t active_;
+    int32_t pump(std::unique_lock<std::mutex> &lock, uint32_t timeoutMs);
+};
 #endif
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PAL_TIMESTAMP_CLOCK_H
+#define PAL_TIMESTAMP_CLOCK_H
+
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include "PalDefs.h"
+
+/* bound on how far an extrapolated session time may be off, in us */
+#define PAL_TS_CLOCK_ACCURACY_PROP "vendor.audio.pal.ts_accuracy_us"
+#define PAL_TS_CLOCK_DEFAULT_ACCURACY_US 1000
+/* session clock rates further than this from nominal mean "not running" */
+#define PAL_TS_CLOCK_MAX_DRIFT_PPM 2000
+/* drift is measured over at least this much wall time before trusting it */
+#define PAL_TS_CLOCK_MIN_BASELINE_US 100000
+#define PAL_TS_CLOCK_MAX_REFRESH_US 100000
+
+/*
+ * Extrapolated SPR session clock.
+ *
+ * A sample pairs the DSP session/absolute time with CLOCK_MONOTONIC taken
+ * around the getParam round trip. Samples are anchored to the first one
+ * after reset() and the rate of the session clock against CLOCK_MONOTONIC is
+ * measured over that baseline, so DSP time granularity averages out. Once
+ * the baseline is long enough and the rate is close to nominal the clock is
+ * locked and read() extrapolates for up to refreshUs_ before asking for a
+ * fresh sample. refreshUs_ is how long drift alone stays within the
+ * accuracy bound, so a client polling once per video frame is served from
+ * the clock for most calls.
+ *
+ * Every fresh sample is compared with the extrapolated value; a mismatch
+ * larger than the accuracy bound (pause, underrun, flush the session did not
+ * report) unlocks the clock and re-anchors it, so callers fall back to
+ * querying the DSP until the rate is known again. A stall is only caught by
+ * that next sample, so sessions also reset() the clock on the pause, flush
+ * and transfer errors they do see.
+ *
+ * read() is a lock-free seqlock read; update() and reset() serialize on
+ * mutex_.
+ */
+class PalTimestampClock {
+public:
+    PalTimestampClock();
+    ~PalTimestampClock() {};
+
+    /*
+     * Fill stime with the extrapolated time. Returns 0 on success and
+     * -EAGAIN when the caller must take a fresh sample and pass it to
+     * update().
+     */
+    int32_t read(struct pal_session_time *stime);
+    /* record a DSP sample taken at CLOCK_MONOTONIC time monoUs */
+    void update(const struct pal_session_time *stime, uint64_t monoUs);
+    /* drop the sample history, e.g. on start/stop/pause/flush */
+    void reset();
+    static uint64_t nowUs();
+
+private:
+    void publish(bool locked, uint64_t monoUs, uint64_t sessUs, uint64_t absUs,
+                 uint64_t tsUs, int64_t sessRatePpm, int64_t absRatePpm);
+
+    /* seqlock protected published state, odd seq_ means write in progress */
+    std::atomic<uint32_t> seq_;
+    std::atomic<bool> locked_;
+    std::atomic<uint64_t> sampleMonoUs_;
+    std::atomic<uint64_t> sampleSessUs_;
+    std::atomic<uint64_t> sampleAbsUs_;
+    std::atomic<uint64_t> sampleTsUs_;
+    std::atomic<int64_t> sessRatePpm_;
+    std::atomic<int64_t> absRatePpm_;
+
+    /* writer side state, guarded by mutex_ */
+    std::mutex mutex_;
+    bool anchored_;
+    uint64_t anchorMonoUs_;
+    uint64_t anchorSessUs_;
+    uint64_t anchorAbsUs_;
+
+    uint32_t accuracyUs_;
+    uint32_t refreshUs_;
+};
+
+#endif //PAL_TIMESTAMP_CLOCK_H
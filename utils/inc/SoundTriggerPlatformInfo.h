@@ -198,6 +198,7 @@ class SoundTriggerPlatformInfo : public SoundTriggerXml {
     }
     bool GetMmapEnable() const { return mmap_enable_; }
     bool GetNotifySecondStageFailure() { return notify_second_stage_failure_; }
+    bool GetPipelinedSecondStage() const { return pipelined_second_stage_; }
     uint32_t GetMmapBufferDuration() const { return mmap_buffer_duration_; }
     uint32_t GetMmapFrameLength() const { return mmap_frame_length_; }
     std::shared_ptr<SoundModelConfig> GetSmConfig(const UUID& uuid) const;
@@ -205,6 +206,10 @@ class SoundTriggerPlatformInfo : public SoundTriggerXml {
     void GetSmConfigForVersionQuery(
         std::vector<std::shared_ptr<SoundModelConfig>> &sm_cfg_list) const;
     bool GetDeferSwitchSupport() const { return support_defer_lpi_switch_; }
+    void SetDeferredConfig(const std::string &file, int64_t offset,
+        int64_t size) { deferred_xml_.Set(file, offset, size); }
+    /* parse sound model configs and capture profiles on first use */
+    void LoadDeferredConfig() { deferred_xml_.Load(this, false); }
 
     void HandleStartTag(const char *tag, const char **attribs)
         override;
@@ -213,6 +218,8 @@ class SoundTriggerPlatformInfo : public SoundTriggerXml {
  private:
     SoundTriggerPlatformInfo();
     static std::shared_ptr<SoundTriggerPlatformInfo> me_;
+    static std::mutex me_mutex_;
+    SoundTriggerDeferredXml deferred_xml_;
     uint32_t version_;
     bool enable_failure_detection_;
     bool support_device_switch_;
@@ -229,6 +236,7 @@ class SoundTriggerPlatformInfo : public SoundTriggerXml {
     bool low_latency_bargein_enable_;
     bool mmap_enable_;
     bool notify_second_stage_failure_;
+    bool pipelined_second_stage_;
     bool support_defer_lpi_switch_;
     uint32_t mmap_buffer_duration_;
     uint32_t mmap_frame_length_;
@@ -30,6 +30,7 @@
 #ifndef SOUND_TRIGGER_UTILS_H
 #define SOUND_TRIGGER_UTILS_H
 
+#include <mutex>
 #include "PalDefs.h"
 #include "ListenSoundModelLib.h"
 
@@ -427,6 +428,7 @@ class SoundModelLib {
 
  private:
     static std::shared_ptr<SoundModelLib> sml_;
+    static std::mutex sml_mutex_;
     void *sml_lib_handle_;
 };
 
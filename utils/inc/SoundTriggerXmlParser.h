@@ -31,6 +31,8 @@
 #ifndef SOUND_TRIGGER_XML_PARSER_H
 #define SOUND_TRIGGER_XML_PARSER_H
 
+#include <mutex>
+#include <string>
 #include "PalDefs.h"
 
 #define CAPTURE_PROFILE_PRIORITY_HIGH 1
@@ -58,6 +60,30 @@ class SoundTriggerXml {
     virtual ~SoundTriggerXml() {};
 };
 
+/*
+ * Byte range of a platform info section in the resource xml. The resource
+ * xml pass only hands the top level params of the section to the platform
+ * info, the nested configs (capture profiles, sound model and stream
+ * configs) are parsed from this range by Load() when the first stream that
+ * needs them is created.
+ */
+class SoundTriggerDeferredXml {
+ public:
+    SoundTriggerDeferredXml() : offset_(0), size_(0) {};
+    SoundTriggerDeferredXml(SoundTriggerDeferredXml &rhs) = delete;
+    SoundTriggerDeferredXml & operator=(SoundTriggerDeferredXml &rhs) = delete;
+
+    void Set(const std::string &file, int64_t offset, int64_t size);
+    /* runs once, later calls return after the first one completed */
+    void Load(SoundTriggerXml *target, bool buffer_char_data);
+
+ private:
+    std::string file_;
+    int64_t offset_;
+    int64_t size_;
+    std::once_flag load_once_;
+};
+
 class CaptureProfile : public SoundTriggerXml {
  public:
     CaptureProfile(std::string name);
@@ -322,6 +322,7 @@ void StreamConfig::HandleEndTag(struct xml_userdata *data, const char* tag) {
 
 std::shared_ptr<ACDPlatformInfo> ACDPlatformInfo::me_ =
     nullptr;
+std::mutex ACDPlatformInfo::me_mutex_;
 
 ACDPlatformInfo::ACDPlatformInfo() :
     acd_enable_(true),
@@ -404,6 +405,7 @@ std::shared_ptr<CaptureProfile> ACDPlatformInfo::GetCapProfile(
 std::shared_ptr<ACDPlatformInfo>
 ACDPlatformInfo::GetInstance() {
 
+    std::lock_guard<std::mutex> lck(me_mutex_);
     if (!me_)
         me_ = std::shared_ptr<ACDPlatformInfo>
             (new ACDPlatformInfo);
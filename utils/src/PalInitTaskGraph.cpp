@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define LOG_TAG "PAL: PalInitTaskGraph"
+
+#include "PalInitTaskGraph.h"
+#include "PalCommon.h"
+#include <errno.h>
+
+static thread_local bool tlsInitWorker = false;
+
+PalInitTaskGraph::PalInitTaskGraph(uint32_t maxWorkers)
+    : maxWorkers_(maxWorkers ? maxWorkers : 1),
+      liveWorkers_(0),
+      unstarted_(0),
+      pending_(0)
+{
+}
+
+PalInitTaskGraph::~PalInitTaskGraph()
+{
+    waitAll();
+    for (auto &t : workers_) {
+        if (t.joinable())
+            t.join();
+    }
+    workers_.clear();
+}
+
+bool PalInitTaskGraph::isWorkerThread()
+{
+    return tlsInitWorker;
+}
+
+int32_t PalInitTaskGraph::add(const char *name, task_fn fn,
+                              const std::vector<int32_t> &deps)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    int32_t id = (int32_t)tasks_.size();
+
+    for (auto dep : deps) {
+        if (dep < 0 || dep >= id) {
+            PAL_ERR(LOG_TAG, "task %s: invalid dependency %d", name, dep);
+            return -EINVAL;
+        }
+    }
+
+    tasks_.push_back({name, fn, deps, false, false, 0});
+    unstarted_++;
+    pending_++;
+
+    /* reap workers that already exited before starting another one */
+    if (liveWorkers_ == 0) {
+        for (auto &t : workers_) {
+            if (t.joinable())
+                t.join();
+        }
+        workers_.clear();
+    }
+
+    if (liveWorkers_ < maxWorkers_) {
+        liveWorkers_++;
+        workers_.push_back(std::thread(&PalInitTaskGraph::workerLoop, this));
+    } else {
+        cv_.notify_all();
+    }
+    PAL_DBG(LOG_TAG, "task %d %s queued, %zu dependencies", id, name, deps.size());
+
+    return id;
+}
+
+int32_t PalInitTaskGraph::nextRunnable(int32_t *depStatus)
+{
+    for (int32_t i = 0; i < (int32_t)tasks_.size(); i++) {
+        bool ready = true;
+
+        if (tasks_[i].started)
+            continue;
+
+        *depStatus = 0;
+        for (auto dep : tasks_[i].deps) {
+            if (!tasks_[dep].done) {
+                ready = false;
+                break;
+            }
+            if (tasks_[dep].status != 0)
+                *depStatus = tasks_[dep].status;
+        }
+        if (ready)
+            return i;
+    }
+
+    return -1;
+}
+
+void PalInitTaskGraph::workerLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    int32_t depStatus = 0;
+    int32_t id;
+
+    tlsInitWorker = true;
+    while (unstarted_ > 0) {
+        id = nextRunnable(&depStatus);
+        if (id < 0) {
+            /* everything left waits on a task running on another worker */
+            cv_.wait(lock);
+            continue;
+        }
+
+        task &t = tasks_[id];
+        task_fn fn = t.fn;
+        std::string name = t.name;
+        int32_t status;
+
+        t.started = true;
+        unstarted_--;
+        lock.unlock();
+
+        if (depStatus != 0) {
+            PAL_ERR(LOG_TAG, "task %d %s skipped, dependency failed %d",
+                    id, name.c_str(), depStatus);
+            status = -ECANCELED;
+        } else {
+            PAL_DBG(LOG_TAG, "task %d %s started", id, name.c_str());
+            status = fn();
+            PAL_DBG(LOG_TAG, "task %d %s done, status %d", id, name.c_str(), status);
+        }
+
+        lock.lock();
+        /* tasks_ may have grown while unlocked, index it again */
+        tasks_[id].done = true;
+        tasks_[id].status = status;
+        pending_--;
+        cv_.notify_all();
+    }
+    liveWorkers_--;
+}
+
+int32_t PalInitTaskGraph::wait(int32_t id)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    if (id < 0 || id >= (int32_t)tasks_.size())
+        return -EINVAL;
+
+    if (!tasks_[id].done && tlsInitWorker) {
+        PAL_ERR(LOG_TAG, "task %s waited on from a worker", tasks_[id].name.c_str());
+        return -EDEADLK;
+    }
+
+    cv_.wait(lock, [&]{ return tasks_[id].done; });
+
+    return tasks_[id].status;
+}
+
+int32_t PalInitTaskGraph::waitAll()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    if (pending_ > 0 && tlsInitWorker) {
+        PAL_ERR(LOG_TAG, "graph waited on from a worker");
+        return -EDEADLK;
+    }
+
+    cv_.wait(lock, [&]{ return pending_ == 0; });
+
+    return 0;
+}
@@ -31,19 +31,55 @@
 #ifdef LINUX_ENABLED
 #include <algorithm>
 #endif
+#include <thread>
 #include "PalRingBuffer.h"
 #include "PalCommon.h"
+#include <unistd.h>
 #define LOG_TAG "PAL: PalRingBuffer"
 
+#define PAL_RING_BUFFER_RESET_WARN_MS 100
+
 int32_t PalRingBuffer::removeReader(PalRingBufferReader *reader)
 {
+    std::lock_guard<std::mutex> lock(mutex_);
     auto iter = std::find(readOffsets_.begin(), readOffsets_.end(), reader);
-    if (iter != readOffsets_.end())
+    if (iter != readOffsets_.end()) {
         readOffsets_.erase(iter);
+        publishReaders_l();
+    }
 
     return 0;
 }
 
+/*
+ * Swap in a copy of readOffsets_ for the writer and free the previous copy
+ * once the writer has left it. The writer holds a list for one write only,
+ * so the wait is bounded by a single copy into the ring. Caller holds mutex_.
+ */
+void PalRingBuffer::publishReaders_l()
+{
+    std::vector<PalRingBufferReader*> *readers =
+        new std::vector<PalRingBufferReader*>(readOffsets_);
+    std::vector<PalRingBufferReader*> *old =
+        readers_.exchange(readers, std::memory_order_seq_cst);
+
+    while (listUsers_.load(std::memory_order_seq_cst) != 0)
+        std::this_thread::yield();
+    delete old;
+}
+
+std::vector<PalRingBufferReader*> *PalRingBuffer::acquireReaders()
+{
+    /* pairs with the exchange in publishReaders_l */
+    listUsers_.fetch_add(1, std::memory_order_seq_cst);
+    return readers_.load(std::memory_order_seq_cst);
+}
+
+void PalRingBuffer::releaseReaders()
+{
+    listUsers_.fetch_sub(1, std::memory_order_release);
+}
+
 size_t PalRingBuffer::read(std::shared_ptr<PalRingBufferReader>reader __unused,
                            void* readBuffer __unused, size_t readSize __unused)
 {
@@ -52,86 +88,142 @@ size_t PalRingBuffer::read(std::shared_ptr<PalRingBufferReader>reader __unused,
 
 size_t PalRingBuffer::getFreeSize()
 {
+    size_t freeSize = getFreeSize(acquireReaders());
 
-    size_t freeSize = bufferEnd_;
-    std::vector<PalRingBufferReader*>::iterator it;
+    releaseReaders();
+    return freeSize;
+}
 
-    for (it = readOffsets_.begin(); it != readOffsets_.end(); it++) {
-        if ((*(it))->state_ == READER_ENABLED)
-            freeSize = std::min(freeSize, bufferEnd_ - (*(it))->unreadSize_);
+size_t PalRingBuffer::getFreeSize(const std::vector<PalRingBufferReader*> *readers)
+{
+    size_t freeSize = bufferEnd_;
+    uint64_t writePos = writePos_.load(std::memory_order_relaxed);
+    uint64_t readPos = 0;
+    std::vector<PalRingBufferReader*>::const_iterator it;
+
+    for (it = readers->begin(); it != readers->end(); it++) {
+        if (!(*(it))->isEnabled())
+            continue;
+        /* acquire pairs with the reader's release once it has copied out */
+        readPos = (*(it))->readPos_.load(std::memory_order_acquire);
+        if (readPos >= writePos)
+            continue;
+        if (writePos - readPos >= bufferEnd_)
+            return 0;
+        freeSize = std::min(freeSize, (size_t)(bufferEnd_ - (writePos - readPos)));
     }
     return freeSize;
 }
 
-void PalRingBuffer::updateUnReadSize(size_t writtenSize)
+void PalRingBuffer::updateIndices(uint32_t startIndice, uint32_t endIndice)
 {
-    int32_t i = 0;
-    std::vector<PalRingBufferReader*>::iterator it;
+    startIndex.store(startIndice, std::memory_order_release);
+    endIndex.store(endIndice, std::memory_order_release);
+    PAL_VERBOSE(LOG_TAG, "start index = %u, end index = %u", startIndice, endIndice);
+}
 
-    for (it = readOffsets_.begin(); it != readOffsets_.end(); it++, i++) {
-        (*(it))->unreadSize_ += writtenSize;
-        PAL_VERBOSE(LOG_TAG, "Reader (%d), unreadSize(%zu)", i, (*(it))->unreadSize_);
-    }
+void PalRingBuffer::copyOut(uint64_t pos, void *dst, size_t size)
+{
+    size_t offset = pos % bufferEnd_;
+    size_t firstPart = std::min(size, bufferEnd_ - offset);
+
+    ar_mem_cpy(dst, firstPart, buffer_ + offset, firstPart);
+    if (size > firstPart)
+        ar_mem_cpy((char *)dst + firstPart, size - firstPart, buffer_,
+                   size - firstPart);
 }
 
-void PalRingBuffer::updateIndices(uint32_t startIndice, uint32_t endIndice)
+void PalRingBuffer::wakeReaders()
+{
+    /* order the cursor publish before the waiter check, see waitForData */
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters_.load(std::memory_order_relaxed) == 0)
+        return;
+
+    std::lock_guard<std::mutex> lock(waitMutex_);
+    dataCV_.notify_all();
+}
+
+size_t PalRingBuffer::getRegions(uint64_t pos, size_t size,
+                                 struct pal_ring_buffer_region *regions)
+{
+    size_t offset = pos % bufferEnd_;
+    size_t firstPart = std::min(size, bufferEnd_ - offset);
+
+    regions[0].data = buffer_ + offset;
+    regions[0].size = firstPart;
+    regions[1].data = buffer_;
+    regions[1].size = size - firstPart;
+
+    return size;
+}
+
+size_t PalRingBuffer::reserveWrite(struct pal_ring_buffer_region *regions,
+                                   size_t size)
+{
+    size_t sizeToReserve = std::min(size, getFreeSize());
+
+    /*
+     * Readers only ever free more space, so the reservation stays valid
+     * until it is committed.
+     */
+    reservedSize_.store(sizeToReserve, std::memory_order_relaxed);
+    return getRegions(writePos_.load(std::memory_order_relaxed), sizeToReserve,
+                      regions);
+}
+
+int32_t PalRingBuffer::commitWrite(size_t size)
 {
-    startIndex = startIndice;
-    endIndex = endIndice;
-    PAL_VERBOSE(LOG_TAG, "start index = %u, end index = %u", startIndex, endIndex);
+    size_t reserved = reservedSize_.exchange(0, std::memory_order_relaxed);
+
+    if (size > reserved) {
+        PAL_ERR(LOG_TAG, "Cannot commit %zu bytes, only %zu reserved",
+                size, reserved);
+        return -EINVAL;
+    }
+
+    writePos_.store(writePos_.load(std::memory_order_relaxed) + size,
+                    std::memory_order_release);
+    wakeReaders();
+    PAL_VERBOSE(LOG_TAG, "committed %zu bytes", size);
+    return 0;
 }
 
 size_t PalRingBuffer::write(void* writeBuffer, size_t writeSize)
 {
-    /* update the unread size for each reader*/
-    mutex_.lock();
     size_t freeSize = getFreeSize();
-    size_t writtenSize = 0;
-    int32_t i = 0;
-    size_t sizeToCopy = 0;
-
-    PAL_DBG(LOG_TAG, "Enter. freeSize(%zu), writeOffset(%zu)", freeSize, writeOffset_);
+    uint64_t writePos = writePos_.load(std::memory_order_relaxed);
+    size_t writeOffset = writePos % bufferEnd_;
+    size_t sizeToCopy = std::min(writeSize, freeSize);
+    size_t firstPart = 0;
 
-    if (writeSize <= freeSize)
-        sizeToCopy = writeSize;
-    else
-        sizeToCopy = freeSize;
+    PAL_DBG(LOG_TAG, "Enter. freeSize(%zu), writeOffset(%zu)", freeSize, writeOffset);
 
     if (sizeToCopy) {
+        firstPart = std::min(sizeToCopy, bufferEnd_ - writeOffset);
+        ar_mem_cpy(buffer_ + writeOffset, firstPart, writeBuffer, firstPart);
         //buffer wrapped around
-        if (writeOffset_ + sizeToCopy > bufferEnd_) {
-            i = bufferEnd_ - writeOffset_;
-
-            ar_mem_cpy(buffer_ + writeOffset_, i, writeBuffer, i);
-            writtenSize += i;
-            sizeToCopy -= writtenSize;
-            ar_mem_cpy(buffer_, sizeToCopy, (char*)writeBuffer + writtenSize,
-                             sizeToCopy);
-            writtenSize += sizeToCopy;
-            writeOffset_ = sizeToCopy;
-        } else {
-            ar_mem_cpy(buffer_ + writeOffset_, sizeToCopy, writeBuffer,
-                             sizeToCopy);
-            writeOffset_ += sizeToCopy;
-            writtenSize = sizeToCopy;
-        }
+        if (sizeToCopy > firstPart)
+            ar_mem_cpy(buffer_, sizeToCopy - firstPart,
+                       (char*)writeBuffer + firstPart, sizeToCopy - firstPart);
+        /* publish the data to all readers */
+        writePos_.store(writePos + sizeToCopy, std::memory_order_release);
+        wakeReaders();
     }
-    updateUnReadSize(writtenSize);
-    writeOffset_ = writeOffset_ % bufferEnd_;
-    PAL_DBG(LOG_TAG, "Exit. writeOffset(%zu)", writeOffset_);
-    mutex_.unlock();
-    return writtenSize;
+    PAL_DBG(LOG_TAG, "Exit. writeOffset(%zu)",
+            (size_t)((writePos + sizeToCopy) % bufferEnd_));
+    return sizeToCopy;
 }
 
 void PalRingBuffer::reset()
 {
     std::vector<PalRingBufferReader*>::iterator it;
+    std::lock_guard<std::mutex> lock(mutex_);
 
-    mutex_.lock();
-    startIndex = 0;
-    endIndex = 0;
-    writeOffset_ = 0;
-    mutex_.unlock();
+    startIndex.store(0, std::memory_order_relaxed);
+    endIndex.store(0, std::memory_order_relaxed);
+    writePos_.store(0, std::memory_order_release);
+    reservedSize_.store(0, std::memory_order_relaxed);
 
     /* Reset all the associated readers */
     for (it = readOffsets_.begin(); it != readOffsets_.end(); it++)
@@ -140,155 +232,397 @@ void PalRingBuffer::reset()
 
 void PalRingBuffer::resizeRingBuffer(size_t bufferSize)
 {
+    std::lock_guard<std::mutex> lock(mutex_);
+
     if (buffer_) {
         delete[] buffer_;
         buffer_ = nullptr;
     }
     buffer_ = (char *)new char[bufferSize];
     bufferEnd_ = bufferSize;
+
+    /* positions are only meaningful modulo the old size, restart at zero */
+    startIndex.store(0, std::memory_order_relaxed);
+    endIndex.store(0, std::memory_order_relaxed);
+    writePos_.store(0, std::memory_order_release);
+    reservedSize_.store(0, std::memory_order_relaxed);
+    for (auto reader : readOffsets_)
+        reader->readPos_.store(0, std::memory_order_release);
+}
+
+PalRingBufferReader::PalRingBufferReader(PalRingBuffer *buffer)
+    : ringBuffer_(buffer),
+      readPos_(buffer->writePos_.load(std::memory_order_acquire)),
+      state_(READER_DISABLED),
+      users_(0),
+      peekHeld_(false)
+{
+}
+
+/*
+ * Register as a user of readPos_ before checking the state, reset() does
+ * the opposite, so either it waits for this user or this sees the reset.
+ */
+bool PalRingBufferReader::enterRead()
+{
+    users_.fetch_add(1, std::memory_order_seq_cst);
+    return state_.load(std::memory_order_seq_cst) == READER_ENABLED;
+}
+
+void PalRingBufferReader::leaveRead()
+{
+    users_.fetch_sub(1, std::memory_order_release);
 }
 
 int32_t PalRingBufferReader::read(void* readBuffer, size_t bufferSize)
 {
-    int32_t readSize = 0;
+    uint64_t readPos = 0;
+    uint64_t writePos = 0;
+    size_t readSize = 0;
 
-    if (state_ == READER_DISABLED)
+    if (!enterRead()) {
+        leaveRead();
         return -EINVAL;
+    }
+
+    readPos = readPos_.load(std::memory_order_relaxed);
+    /* acquire pairs with the writer's release after copying in */
+    writePos = ringBuffer_->writePos_.load(std::memory_order_acquire);
 
     // Return 0 when no data can be read for current reader
-    if (unreadSize_ == 0)
-        return 0;
+    if (writePos > readPos) {
+        readSize = std::min(bufferSize, (size_t)(writePos - readPos));
+        ringBuffer_->copyOut(readPos, readBuffer, readSize);
+        /* hand the consumed region back to the writer */
+        readPos_.store(readPos + readSize, std::memory_order_release);
+    }
+    leaveRead();
 
-    ringBuffer_->mutex_.lock();
-
-    // when writeOffset leads readOffset
-    if (ringBuffer_->writeOffset_ > readOffset_) {
-        unreadSize_ = ringBuffer_->writeOffset_ - readOffset_;
-
-        if (bufferSize >= unreadSize_) {
-            ar_mem_cpy(readBuffer, unreadSize_, ringBuffer_->buffer_ +
-                             readOffset_, unreadSize_);
-            readOffset_ += unreadSize_;
-            readSize = unreadSize_;
-            unreadSize_ = 0;
-        } else {
-            ar_mem_cpy(readBuffer, unreadSize_, ringBuffer_->buffer_ +
-                             readOffset_, bufferSize);
-            readOffset_ += bufferSize;
-            readSize = bufferSize;
-            unreadSize_ = ringBuffer_->writeOffset_ - readOffset_;
-        }
-    } else {
-        //When readOffset leads WriteOffset
-        int32_t freeClientSize = bufferSize;
-        int32_t i = ringBuffer_->bufferEnd_ - readOffset_;
-
-        if (bufferSize >= i) {
-            ar_mem_cpy(readBuffer, i, (char*)(ringBuffer_->buffer_ +
-                             readOffset_), i);
-            readSize = i;
-            freeClientSize -= readSize;
-            unreadSize_ = ringBuffer_->writeOffset_;
-            readOffset_ = 0;
-            //copy remaining unread buffer
-            if (freeClientSize > unreadSize_) {
-                ar_mem_cpy((char *)readBuffer + readSize, unreadSize_,
-                                 ringBuffer_->buffer_, unreadSize_);
-                readSize += unreadSize_;
-                readOffset_ = unreadSize_;
-                unreadSize_ = 0;
-            } else {
-                //copy whatever we can
-                ar_mem_cpy((char *)readBuffer + readSize, freeClientSize,
-                                 ringBuffer_->buffer_, freeClientSize);
-                readSize += freeClientSize;
-                readOffset_ = freeClientSize;
-                unreadSize_ = ringBuffer_->writeOffset_ - readOffset_;
-            }
+    return readSize;
+}
 
-        } else {
-            ar_mem_cpy(readBuffer, bufferSize, ringBuffer_->buffer_ +
-                             readOffset_, bufferSize);
-            readSize = bufferSize;
-            readOffset_ += bufferSize;
-            unreadSize_ = ringBuffer_->bufferEnd_ - readOffset_ +
-                          ringBuffer_->writeOffset_;
-        }
+size_t PalRingBufferReader::getReadRegions(struct pal_ring_buffer_region *regions,
+                                           size_t maxSize)
+{
+    size_t size = 0;
+
+    /* a second peek before commit re-uses the first registration */
+    if (!peekHeld_ && !enterRead()) {
+        leaveRead();
+        regions[0].size = 0;
+        regions[1].size = 0;
+        return 0;
     }
-    ringBuffer_->mutex_.unlock();
-    return readSize;
+
+    size = std::min(maxSize, getUnreadSize());
+    ringBuffer_->getRegions(readPos_.load(std::memory_order_relaxed),
+                            size, regions);
+    peekHeld_ = size != 0;
+    if (!peekHeld_)
+        leaveRead();
+
+    return size;
+}
+
+int32_t PalRingBufferReader::waitForData(size_t minBytes, uint32_t timeoutMs)
+{
+    int32_t status = 0;
+    PalRingBuffer *rb = ringBuffer_;
+
+    if (!isEnabled())
+        return -EINVAL;
+
+    if (getUnreadSize() >= minBytes)
+        return 0;
+
+    /*
+     * Register as a waiter before re-checking the cursor: either the writer
+     * sees waiters_ and notifies under waitMutex_, or this check sees the
+     * writer's new cursor.
+     */
+    rb->waiters_.fetch_add(1, std::memory_order_seq_cst);
+    std::unique_lock<std::mutex> lock(rb->waitMutex_);
+    if (!rb->dataCV_.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+            [&] { return !isEnabled() || getUnreadSize() >= minBytes; }))
+        status = -ETIMEDOUT;
+    else if (!isEnabled())
+        status = -EINVAL;
+    lock.unlock();
+    rb->waiters_.fetch_sub(1, std::memory_order_relaxed);
+
+    return status;
+}
+
+int32_t PalRingBufferReader::commitRead(size_t size)
+{
+    int32_t status = -EINVAL;
+
+    if (!peekHeld_)
+        enterRead();
+
+    /* a reset waiting on this peek has already disabled the reader */
+    if (isEnabled())
+        status = advanceReadOffset_l(size) == size ? 0 : -EINVAL;
+    peekHeld_ = false;
+    leaveRead();
+
+    return status;
+}
+
+void PalRingBufferReader::cancelRead()
+{
+    if (!peekHeld_)
+        return;
+
+    peekHeld_ = false;
+    leaveRead();
 }
 
 size_t PalRingBufferReader::advanceReadOffset(size_t advanceSize)
 {
-    size_t size_advanced = 0;
+    size_t advanced = 0;
 
-    std::lock_guard<std::mutex> lock(ringBuffer_->mutex_);
+    enterRead();
+    advanced = advanceReadOffset_l(advanceSize);
+    leaveRead();
+
+    return advanced;
+}
+
+size_t PalRingBufferReader::advanceReadOffset_l(size_t advanceSize)
+{
+    size_t unreadSize = getUnreadSize();
 
     /* add code to advance the offset here*/
-    if (unreadSize_ < advanceSize) {
+    if (unreadSize < advanceSize) {
         PAL_ERR(LOG_TAG, "Cannot advance read offset %zu greater than unread size %zu",
-            advanceSize, unreadSize_);
-        return size_advanced;
+            advanceSize, unreadSize);
+        return 0;
     }
 
-    unreadSize_ -= advanceSize;
-    if (readOffset_ + advanceSize < ringBuffer_->bufferEnd_) {
-        readOffset_ += advanceSize;
-    } else {
-        readOffset_ = readOffset_ + advanceSize - ringBuffer_->bufferEnd_;
-    }
-    size_advanced += advanceSize;
+    readPos_.store(readPos_.load(std::memory_order_relaxed) + advanceSize,
+                   std::memory_order_release);
 
-    return size_advanced;
+    return advanceSize;
 }
 
 void PalRingBufferReader::updateState(pal_ring_buffer_reader_state state)
 {
-    PAL_DBG(LOG_TAG, "update reader state to %d", state);
-    std::lock_guard<std::mutex> lock(ringBuffer_->mutex_);
+    uint64_t writePos = 0;
+    uint64_t readPos = 0;
 
-    if (state_ == READER_DISABLED && state == READER_ENABLED) {
-        if (unreadSize_ > ringBuffer_->bufferEnd_)
-           unreadSize_ = ringBuffer_->bufferEnd_;
+    PAL_DBG(LOG_TAG, "update reader state to %d", state);
 
-        if (unreadSize_ <= ringBuffer_->writeOffset_) {
-            readOffset_ = ringBuffer_->writeOffset_ - unreadSize_;
-        } else {
-            readOffset_ = ringBuffer_->writeOffset_ +
-                ringBuffer_->bufferEnd_ - unreadSize_;
-        }
+    if (!isEnabled() && state == READER_ENABLED) {
+        /* a disabled reader keeps up to one buffer of history */
+        writePos = ringBuffer_->writePos_.load(std::memory_order_acquire);
+        readPos = readPos_.load(std::memory_order_relaxed);
+        if (writePos > readPos && writePos - readPos > ringBuffer_->bufferEnd_)
+            readPos_.store(writePos - ringBuffer_->bufferEnd_,
+                           std::memory_order_release);
+        state_.store(state, std::memory_order_seq_cst);
+        /*
+         * The writer may have sampled this reader as disabled and written
+         * past the position chosen above, re-clamp against its latest cursor.
+         */
+        writePos = ringBuffer_->writePos_.load(std::memory_order_seq_cst);
+        readPos = readPos_.load(std::memory_order_relaxed);
+        if (writePos > readPos && writePos - readPos > ringBuffer_->bufferEnd_)
+            readPos_.store(writePos - ringBuffer_->bufferEnd_,
+                           std::memory_order_release);
+        return;
     }
-    state_ = state;
+    state_.store(state, std::memory_order_release);
+    if (state == READER_DISABLED)
+        ringBuffer_->wakeReaders();
 }
 
 void PalRingBufferReader::getIndices(uint32_t *startIndice, uint32_t *endIndice)
 {
-    *startIndice = ringBuffer_->startIndex;
-    *endIndice = ringBuffer_->endIndex;
+    *startIndice = ringBuffer_->startIndex.load(std::memory_order_acquire);
+    *endIndice = ringBuffer_->endIndex.load(std::memory_order_acquire);
     PAL_VERBOSE(LOG_TAG, "start index = %u, end index = %u",
-                ringBuffer_->startIndex, ringBuffer_->endIndex);
+                *startIndice, *endIndice);
 }
 
 size_t PalRingBufferReader::getUnreadSize()
 {
-    PAL_VERBOSE(LOG_TAG, "unread size %zu", unreadSize_);
-    return unreadSize_;
+    uint64_t writePos = ringBuffer_->writePos_.load(std::memory_order_acquire);
+    uint64_t readPos = readPos_.load(std::memory_order_acquire);
+    size_t unreadSize = writePos > readPos ? (size_t)(writePos - readPos) : 0;
+
+    PAL_VERBOSE(LOG_TAG, "unread size %zu", unreadSize);
+    return unreadSize;
 }
 
+/*
+ * Disable first so no new read or peek starts, then wait for the ones in
+ * flight, e.g. a second stage engine still processing ring memory it got
+ * from getReadRegions(), before moving readPos_ under them.
+ */
 void PalRingBufferReader::reset()
 {
-    ringBuffer_->mutex_.lock();
-    readOffset_ = 0;
-    unreadSize_ = 0;
-    state_ = READER_DISABLED;
-    ringBuffer_->mutex_.unlock();
+    uint32_t waitedMs = 0;
+
+    state_.store(READER_DISABLED, std::memory_order_seq_cst);
+    ringBuffer_->wakeReaders();
+    while (users_.load(std::memory_order_seq_cst) != 0) {
+        if (waitedMs++ == PAL_RING_BUFFER_RESET_WARN_MS)
+            PAL_INFO(LOG_TAG, "reset waiting for outstanding read regions");
+        usleep(1000);
+    }
+    readPos_.store(ringBuffer_->writePos_.load(std::memory_order_acquire),
+                   std::memory_order_release);
 }
 
 PalRingBufferReader* PalRingBuffer::newReader()
 {
     PalRingBufferReader* readOffset =
                   new PalRingBufferReader(this);
+    std::lock_guard<std::mutex> lock(mutex_);
     readOffsets_.push_back(readOffset);
+    publishReaders_l();
     return readOffset;
 }
+
+PalRingBufferFanout::PalRingBufferFanout(PalRingBufferReader *reader,
+                                         uint32_t numConsumers)
+    : reader_(reader),
+      numConsumers_(numConsumers),
+      window_(nullptr),
+      windowSize_(0),
+      filled_(0),
+      pumping_(false),
+      cancelled_(false),
+      active_(0)
+{
+}
+
+PalRingBufferFanout::~PalRingBufferFanout()
+{
+    if (window_)
+        delete[] window_;
+    if (reader_)
+        delete reader_;
+}
+
+/*
+ * Rewind the window for a new range starting at the history the reader
+ * kept while disabled. The window holds that history, at most one ring,
+ * plus as much again arriving afterwards. No consumer may still use the
+ * previous window.
+ */
+void PalRingBufferFanout::start()
+{
+    size_t size = 2 * reader_->ringBuffer_->getBufferSize();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (size != windowSize_) {
+        if (window_)
+            delete[] window_;
+        window_ = new char[size];
+        windowSize_ = size;
+    }
+    filled_ = 0;
+    cancelled_ = false;
+    active_ = numConsumers_;
+    reader_->updateState(READER_ENABLED);
+}
+
+void PalRingBufferFanout::cancel()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cancelled_ = true;
+        cv_.notify_all();
+    }
+    /* wakes a consumer pumping in the reader's waitForData */
+    reader_->updateState(READER_DISABLED);
+}
+
+void PalRingBufferFanout::reset()
+{
+    cancel();
+    reader_->reset();
+}
+
+void PalRingBufferFanout::release()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (active_ && --active_ == 0)
+        reader_->updateState(READER_DISABLED);
+}
+
+/*
+ * Copy whatever the ring holds into the window on the calling consumer's
+ * thread, waiting up to timeoutMs for the writer if it holds nothing.
+ * Called with lock held and no other consumer pumping.
+ */
+int32_t PalRingBufferFanout::pump(std::unique_lock<std::mutex> &lock,
+                                  uint32_t timeoutMs)
+{
+    size_t from = filled_;
+    int32_t size = 0;
+    int32_t status = 0;
+
+    pumping_ = true;
+    lock.unlock();
+    status = reader_->waitForData(1, timeoutMs);
+    if (!status) {
+        size = reader_->read(window_ + from, windowSize_ - from);
+        if (size < 0)
+            status = size;
+    }
+    lock.lock();
+    pumping_ = false;
+    if (size > 0)
+        filled_ = from + size;
+    cv_.notify_all();
+
+    return status;
+}
+
+int32_t PalRingBufferFanout::waitForData(size_t end, uint32_t timeoutMs)
+{
+    int32_t status = 0;
+    int64_t waitMs = 0;
+    std::chrono::steady_clock::time_point deadline =
+        std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    if (end > windowSize_) {
+        PAL_ERR(LOG_TAG, "range end %zu exceeds window %zu", end, windowSize_);
+        return -ENOSPC;
+    }
+
+    while (!cancelled_ && filled_ < end) {
+        if (pumping_) {
+            if (cv_.wait_until(lock, deadline) == std::cv_status::timeout) {
+                status = -ETIMEDOUT;
+                break;
+            }
+            continue;
+        }
+        waitMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count();
+        if (waitMs <= 0) {
+            status = -ETIMEDOUT;
+            break;
+        }
+        status = pump(lock, (uint32_t)waitMs);
+        if (status)
+            break;
+    }
+
+    if (cancelled_)
+        status = -ECANCELED;
+    else if (filled_ >= end)
+        status = 0;
+
+    return status;
+}
+
+void PalRingBufferFanout::getIndices(uint32_t *startIndice, uint32_t *endIndice)
+{
+    reader_->getIndices(startIndice, endIndice);
+}
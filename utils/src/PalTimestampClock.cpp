@@ -0,0 +1,238 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define LOG_TAG "PAL: PalTimestampClock"
+
+#include "PalTimestampClock.h"
+#include "PalCommon.h"
+#include <cutils/properties.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <time.h>
+#include <algorithm>
+
+#define PAL_TS_CLOCK_NOMINAL_RATE_PPM 1000000LL
+
+static inline uint64_t palTimeToUs(const struct pal_time_us *t)
+{
+    return ((uint64_t)t->value_msw << 32) | t->value_lsw;
+}
+
+static inline void usToPalTime(uint64_t us, struct pal_time_us *t)
+{
+    t->value_lsw = (uint32_t)us;
+    t->value_msw = (uint32_t)(us >> 32);
+}
+
+static inline uint64_t extrapolate(uint64_t base, uint64_t elapsedUs, int64_t ratePpm)
+{
+    return base + (uint64_t)((int64_t)elapsedUs * ratePpm / PAL_TS_CLOCK_NOMINAL_RATE_PPM);
+}
+
+PalTimestampClock::PalTimestampClock()
+    : seq_(0),
+      locked_(false),
+      sampleMonoUs_(0),
+      sampleSessUs_(0),
+      sampleAbsUs_(0),
+      sampleTsUs_(0),
+      sessRatePpm_(PAL_TS_CLOCK_NOMINAL_RATE_PPM),
+      absRatePpm_(PAL_TS_CLOCK_NOMINAL_RATE_PPM),
+      anchored_(false),
+      anchorMonoUs_(0),
+      anchorSessUs_(0),
+      anchorAbsUs_(0),
+      accuracyUs_(PAL_TS_CLOCK_DEFAULT_ACCURACY_US)
+{
+#ifndef FEATURE_IPQ_OPENWRT
+    char value[PROPERTY_VALUE_MAX] = {0};
+    long accuracy = 0;
+
+    if (property_get(PAL_TS_CLOCK_ACCURACY_PROP, value, "") > 0) {
+        accuracy = strtol(value, NULL, 10);
+        if (accuracy > 0)
+            accuracyUs_ = (uint32_t)accuracy;
+    }
+#endif
+    /*
+     * After lock-in the residual drift is far below the plausibility
+     * bound, so refreshing before the bound alone could exceed the
+     * accuracy keeps the extrapolation error within it. Stalls are not
+     * covered by the window, sessions reset() the clock on the xruns,
+     * pauses and flushes they see and update() re-anchors on the rest.
+     */
+    refreshUs_ = (uint32_t)std::min<uint64_t>(PAL_TS_CLOCK_MAX_REFRESH_US,
+            (uint64_t)accuracyUs_ * PAL_TS_CLOCK_NOMINAL_RATE_PPM /
+            PAL_TS_CLOCK_MAX_DRIFT_PPM);
+}
+
+uint64_t PalTimestampClock::nowUs()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+void PalTimestampClock::publish(bool locked, uint64_t monoUs, uint64_t sessUs,
+                                uint64_t absUs, uint64_t tsUs, int64_t sessRatePpm,
+                                int64_t absRatePpm)
+{
+    uint32_t seq = seq_.load(std::memory_order_relaxed);
+
+    seq_.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    locked_.store(locked, std::memory_order_relaxed);
+    sampleMonoUs_.store(monoUs, std::memory_order_relaxed);
+    sampleSessUs_.store(sessUs, std::memory_order_relaxed);
+    sampleAbsUs_.store(absUs, std::memory_order_relaxed);
+    sampleTsUs_.store(tsUs, std::memory_order_relaxed);
+    sessRatePpm_.store(sessRatePpm, std::memory_order_relaxed);
+    absRatePpm_.store(absRatePpm, std::memory_order_relaxed);
+    seq_.store(seq + 2, std::memory_order_release);
+}
+
+int32_t PalTimestampClock::read(struct pal_session_time *stime)
+{
+    uint32_t seq = 0;
+    bool locked = false;
+    uint64_t monoUs = 0, sessUs = 0, absUs = 0, tsUs = 0;
+    int64_t sessRatePpm = 0, absRatePpm = 0;
+    uint64_t now = 0, elapsed = 0;
+
+    for (;;) {
+        seq = seq_.load(std::memory_order_acquire);
+        if (seq & 1)
+            continue;
+        locked = locked_.load(std::memory_order_relaxed);
+        monoUs = sampleMonoUs_.load(std::memory_order_relaxed);
+        sessUs = sampleSessUs_.load(std::memory_order_relaxed);
+        absUs = sampleAbsUs_.load(std::memory_order_relaxed);
+        tsUs = sampleTsUs_.load(std::memory_order_relaxed);
+        sessRatePpm = sessRatePpm_.load(std::memory_order_relaxed);
+        absRatePpm = absRatePpm_.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (seq_.load(std::memory_order_relaxed) == seq)
+            break;
+    }
+
+    if (!locked)
+        return -EAGAIN;
+
+    now = nowUs();
+    elapsed = now > monoUs ? now - monoUs : 0;
+    if (elapsed > refreshUs_)
+        return -EAGAIN;
+
+    usToPalTime(extrapolate(sessUs, elapsed, sessRatePpm), &stime->session_time);
+    usToPalTime(extrapolate(absUs, elapsed, absRatePpm), &stime->absolute_time);
+    usToPalTime(tsUs, &stime->timestamp);
+    return 0;
+}
+
+void PalTimestampClock::update(const struct pal_session_time *stime, uint64_t monoUs)
+{
+    uint64_t sessUs = palTimeToUs(&stime->session_time);
+    uint64_t absUs = palTimeToUs(&stime->absolute_time);
+    uint64_t tsUs = palTimeToUs(&stime->timestamp);
+    uint64_t baseline = 0, predicted = 0, err = 0;
+    int64_t sessRatePpm = 0, absRatePpm = 0;
+    int64_t tolerancePpm = 0;
+    bool inBound = false;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (anchored_ && locked_.load(std::memory_order_relaxed)) {
+        predicted = extrapolate(sampleSessUs_.load(std::memory_order_relaxed),
+                monoUs > sampleMonoUs_.load(std::memory_order_relaxed) ?
+                monoUs - sampleMonoUs_.load(std::memory_order_relaxed) : 0,
+                sessRatePpm_.load(std::memory_order_relaxed));
+        err = predicted > sessUs ? predicted - sessUs : sessUs - predicted;
+        if (err > accuracyUs_) {
+            PAL_DBG(LOG_TAG, "session time off by %llu us, re-anchoring",
+                    (unsigned long long)err);
+            anchored_ = false;
+        }
+    }
+
+    if (anchored_ && (monoUs <= anchorMonoUs_ || sessUs < anchorSessUs_ ||
+                      absUs < anchorAbsUs_))
+        anchored_ = false;
+
+    if (!anchored_) {
+        anchored_ = true;
+        anchorMonoUs_ = monoUs;
+        anchorSessUs_ = sessUs;
+        anchorAbsUs_ = absUs;
+        publish(false, monoUs, sessUs, absUs, tsUs, PAL_TS_CLOCK_NOMINAL_RATE_PPM,
+                PAL_TS_CLOCK_NOMINAL_RATE_PPM);
+        return;
+    }
+
+    baseline = monoUs - anchorMonoUs_;
+    sessRatePpm = (int64_t)((sessUs - anchorSessUs_) * PAL_TS_CLOCK_NOMINAL_RATE_PPM / baseline);
+    absRatePpm = (int64_t)((absUs - anchorAbsUs_) * PAL_TS_CLOCK_NOMINAL_RATE_PPM / baseline);
+    /* samples are only accurate to accuracyUs_, allow for that over the baseline */
+    tolerancePpm = PAL_TS_CLOCK_MAX_DRIFT_PPM +
+                   (int64_t)accuracyUs_ * PAL_TS_CLOCK_NOMINAL_RATE_PPM / (int64_t)baseline;
+    inBound = llabs(sessRatePpm - PAL_TS_CLOCK_NOMINAL_RATE_PPM) <= tolerancePpm &&
+              llabs(absRatePpm - PAL_TS_CLOCK_NOMINAL_RATE_PPM) <= tolerancePpm;
+
+    if (baseline < PAL_TS_CLOCK_MIN_BASELINE_US) {
+        /* rate is still dominated by DSP time granularity */
+        publish(false, monoUs, sessUs, absUs, tsUs, sessRatePpm, absRatePpm);
+        return;
+    }
+
+    if (!inBound) {
+        /* session clock is not running at nominal rate, start over */
+        anchorMonoUs_ = monoUs;
+        anchorSessUs_ = sessUs;
+        anchorAbsUs_ = absUs;
+        publish(false, monoUs, sessUs, absUs, tsUs, PAL_TS_CLOCK_NOMINAL_RATE_PPM,
+                PAL_TS_CLOCK_NOMINAL_RATE_PPM);
+        return;
+    }
+
+    publish(true, monoUs, sessUs, absUs, tsUs, sessRatePpm, absRatePpm);
+}
+
+void PalTimestampClock::reset()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    anchored_ = false;
+    publish(false, 0, 0, 0, 0, PAL_TS_CLOCK_NOMINAL_RATE_PPM,
+            PAL_TS_CLOCK_NOMINAL_RATE_PPM);
+}
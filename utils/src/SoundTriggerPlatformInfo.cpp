@@ -388,6 +388,7 @@ void SoundModelConfig::HandleEndTag(struct xml_userdata *data, const char* tag)
 
 std::shared_ptr<SoundTriggerPlatformInfo> SoundTriggerPlatformInfo::me_ =
     nullptr;
+std::mutex SoundTriggerPlatformInfo::me_mutex_;
 
 SoundTriggerPlatformInfo::SoundTriggerPlatformInfo() :
     enable_failure_detection_(false),
@@ -405,6 +406,7 @@ SoundTriggerPlatformInfo::SoundTriggerPlatformInfo() :
     low_latency_bargein_enable_(false),
     mmap_enable_(false),
     notify_second_stage_failure_(false),
+    pipelined_second_stage_(false),
     support_defer_lpi_switch_(true),
     mmap_buffer_duration_(0),
     mmap_frame_length_(0),
@@ -448,6 +450,7 @@ void SoundTriggerPlatformInfo::GetSmConfigForVersionQuery(
 std::shared_ptr<SoundTriggerPlatformInfo>
 SoundTriggerPlatformInfo::GetInstance() {
 
+    std::lock_guard<std::mutex> lck(me_mutex_);
     if (!me_)
         me_ = std::shared_ptr<SoundTriggerPlatformInfo>
             (new SoundTriggerPlatformInfo);
@@ -546,6 +549,9 @@ void SoundTriggerPlatformInfo::HandleStartTag(const char* tag,
             } else if (!strcmp(attribs[i], "notify_second_stage_failure")) {
                 notify_second_stage_failure_ =
                     !strncasecmp(attribs[++i], "true", 4) ? true : false;
+            } else if (!strcmp(attribs[i], "pipelined_second_stage")) {
+                pipelined_second_stage_ =
+                    !strncasecmp(attribs[++i], "true", 4) ? true : false;
             } else if (!strcmp(attribs[i], "support_defer_lpi_switch")) {
                  support_defer_lpi_switch_ =
                     !strncasecmp(attribs[++i], "true", 4) ? true : false;
@@ -141,8 +141,11 @@ int SoundTriggerUUID::StringToUUID(const char* str,
 
 std::shared_ptr<SoundModelLib> SoundModelLib::sml_ =
     nullptr;
+std::mutex SoundModelLib::sml_mutex_;
 
+/* the sound model lib is only opened by the first voice UI engine using it */
 std::shared_ptr<SoundModelLib> SoundModelLib::GetInstance() {
+    std::lock_guard<std::mutex> lck(sml_mutex_);
     if (!sml_)
         sml_ = std::make_shared<SoundModelLib>();
 
@@ -37,6 +37,34 @@
 #include "SoundTriggerXmlParser.h"
 #include "ResourceManager.h"
 
+void SoundTriggerDeferredXml::Set(const std::string &file, int64_t offset,
+    int64_t size) {
+
+    file_ = file;
+    offset_ = offset;
+    size_ = size;
+}
+
+void SoundTriggerDeferredXml::Load(SoundTriggerXml *target,
+    bool buffer_char_data) {
+
+    std::call_once(load_once_, [&]() {
+        int32_t status = 0;
+
+        if (file_.empty())
+            return;
+
+        status = ResourceManager::parseDeferredXmlSection(file_, offset_,
+            size_, target, buffer_char_data);
+        if (status)
+            PAL_ERR(LOG_TAG, "failed to parse deferred configs of %s, status %d",
+                file_.c_str(), status);
+        else
+            PAL_INFO(LOG_TAG, "parsed deferred configs of %s at %lld",
+                file_.c_str(), (long long)offset_);
+    });
+}
+
 CaptureProfile::CaptureProfile(const std::string name) :
     name_(name),
     device_id_(PAL_DEVICE_IN_MIN),